@@ -871,10 +871,18 @@ void CabbageMainComponent::timerCallback()
         if (getCurrentCsdFile().existsAsFile())
         {
 
-          const String csoundOutputString = getFilterGraph()->getCsoundOutput (nodeId);
+          CabbageOutputConsole* outputConsole = getCurrentOutputConsole();
 
-          if (csoundOutputString.length() > 0)
-                getCurrentOutputConsole()->setText (csoundOutputString);
+          if (getFilterGraph()->readConsoleLines (nodeId, outputConsole->getLog()))
+                outputConsole->linesAdded();
+
+          outputConsole->setNumDroppedMessages (getFilterGraph()->getNumDroppedConsoleMessages (nodeId));
+#if Cabbage_Performance_Monitor
+          CabbagePerformanceMonitor::Snapshot performance;
+
+          if (getFilterGraph()->getPerformanceSnapshot (nodeId, performance))
+              outputConsole->setPerformanceSnapshot (performance);
+#endif
 
         }
         
@@ -116,6 +116,41 @@ public:
 		return String();
 	}
 
+	//copies the node's new console lines into dest, returns true if there were any
+	bool readConsoleLines(AudioProcessorGraph::NodeID nodeId, CabbageConsoleLog& dest)
+	{
+		if (graph.getNodeForId(nodeId) != nullptr)
+			if (auto* csoundProcessor = dynamic_cast<CsoundPluginProcessor*> (graph.getNodeForId(nodeId)->getProcessor()))
+				return csoundProcessor->readConsoleLines(dest);
+
+		return false;
+	}
+
+	//console messages the node's processor has dropped because Csound was printing too quickly
+	int64 getNumDroppedConsoleMessages(AudioProcessorGraph::NodeID nodeId)
+	{
+		if (graph.getNodeForId(nodeId) != nullptr)
+			if (auto* csoundProcessor = dynamic_cast<CsoundPluginProcessor*> (graph.getNodeForId(nodeId)->getProcessor()))
+				return csoundProcessor->getNumDroppedConsoleMessages();
+
+		return 0;
+	}
+
+#if Cabbage_Performance_Monitor
+	//audio callback timings for the node's processor, returns false if it isn't a Csound processor
+	bool getPerformanceSnapshot(AudioProcessorGraph::NodeID nodeId, CabbagePerformanceMonitor::Snapshot& snapshot)
+	{
+		if (graph.getNodeForId(nodeId) != nullptr)
+			if (auto* csoundProcessor = dynamic_cast<CsoundPluginProcessor*> (graph.getNodeForId(nodeId)->getProcessor()))
+			{
+				csoundProcessor->getPerformanceMonitor().getSnapshot(snapshot);
+				return true;
+			}
+
+		return false;
+	}
+#endif
+
 
 	bool addConnection(AudioProcessorGraph::NodeID  sourceFilterUID, int sourceFilterChannel,
 		AudioProcessorGraph::NodeID  destFilterUID, int destFilterChannel)
@@ -23,54 +23,304 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "../../CabbageCommonHeaders.h"
+#include <atomic>
 
-//simple channel message classe
-class CabbageChannelMessage
+//==============================================================================
+//numeric channel updates from the editor and the host, handed to Csound at the
+//next k-boundary. Channels are interned to small integer ids when widgets and
+//parameters are set up. A channel is in the ring at most once, so a value posted
+//for a channel that is already waiting just replaces the waiting one and Csound
+//only sees the newest value each k-cycle. Any thread can post, there is one reader.
+class CabbageMessageQueue
 {
 public:
-    String channelName;
-    float value;
-    String type;
-    String fStatement;
-    int tableNumber;
-    String stringVal;
-
-    CabbageChannelMessage(String chan, double val, String _type)
+    enum { maxChannels = 4096 };
+
+    struct Stats
+    {
+        int64 enqueued = 0;     //values posted and queued
+        int64 coalesced = 0;    //values that replaced one still waiting
+        int64 dropped = 0;      //values that couldn't be queued, written directly instead
+        int64 delivered = 0;    //values handed to Csound
+        int maxDrained = 0;     //most channels delivered in a single k-cycle
+    };
+
+    CabbageMessageQueue()
+        : channelIds (maxChannels + 1, true),
+          slots (new Slot[maxChannels])
+    {
+    }
+
+    //returns false if the channel can't be queued, the caller should write the value itself
+    bool postValue (int channelId, float value)
+    {
+        if (! isPositiveAndBelow (channelId, (int) maxChannels))
+        {
+            dropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Slot& slot = slots[channelId];
+        slot.value.store (value);
+
+        if (slot.queued.exchange (true))
+        {
+            coalesced.fetch_add (1, std::memory_order_relaxed);
+            return true;
+        }
+
+        {
+            //writers only hold this for the few instructions it takes to claim a position
+            const SpinLock::ScopedLockType sl (writeLock);
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+            //every channel fits in the ring, and is in it at most once, so there should always be room
+            if (size1 == 0)
+            {
+                jassertfalse;
+                slot.queued.store (false);
+                dropped.fetch_add (1, std::memory_order_relaxed);
+                return false;
+            }
+
+            channelIds[start1] = channelId;
+            fifo.finishedWrite (1);
+        }
+
+        enqueued.fetch_add (1, std::memory_order_relaxed);
+        return true;
+    }
+
+    //reader only. Calls callback (channelId, value) for each channel with a new value
+    template <typename Callback>
+    int drain (Callback&& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; i++)     deliver (channelIds[start1 + i], callback);
+        for (int i = 0; i < size2; i++)     deliver (channelIds[start2 + i], callback);
+
+        const int numDrained = size1 + size2;
+        fifo.finishedRead (numDrained);
+
+        if (numDrained > 0)
+        {
+            delivered.fetch_add (numDrained, std::memory_order_relaxed);
+
+            if (numDrained > maxDrained.load (std::memory_order_relaxed))
+                maxDrained.store (numDrained, std::memory_order_relaxed);
+        }
+
+        return numDrained;
+    }
+
+    Stats getStats() const
     {
-        channelName = chan;
-        value = val;
-        type = _type;
+        Stats stats;
+        stats.enqueued = enqueued.load();
+        stats.coalesced = coalesced.load();
+        stats.dropped = dropped.load();
+        stats.delivered = delivered.load();
+        stats.maxDrained = maxDrained.load();
+        return stats;
     }
 
-    CabbageChannelMessage(String chan, String val, String _type)
+    void resetStats()
     {
-        channelName = chan;
-        stringVal = val;
-        type = _type;
+        enqueued = 0;
+        coalesced = 0;
+        dropped = 0;
+        delivered = 0;
+        maxDrained = 0;
     }
 
-    ~CabbageChannelMessage(){}
+private:
+    struct Slot
+    {
+        std::atomic<float> value { 0 };
+        std::atomic<bool> queued { false };
+    };
 
+    template <typename Callback>
+    void deliver (int channelId, Callback& callback)
+    {
+        Slot& slot = slots[channelId];
+        //cleared before the value is read, so a value posted from now on queues the channel again
+        slot.queued.store (false);
+        callback (channelId, slot.value.load());
+    }
+
+    //one more than the number of channels, as AbstractFifo keeps a slot free
+    AbstractFifo fifo { maxChannels + 1 };
+    HeapBlock<int> channelIds;
+    std::unique_ptr<Slot[]> slots;
+    SpinLock writeLock;
+    std::atomic<int64> enqueued { 0 }, coalesced { 0 }, dropped { 0 }, delivered { 0 };
+    std::atomic<int> maxDrained { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (CabbageMessageQueue)
 };
 
-//message queue class
-class CabbageMessageQueue
+//==============================================================================
+//host parameter changes, stamped with the position on the processor's sample clock
+//that they belong to. The audio thread applies each one at the k-cycle containing that
+//position, rather than whenever the next k-cycle happens to run. A change can also
+//ramp linearly from the channel's current value, one step per k-cycle, over a fixed
+//number of samples. The ramp length doesn't depend on when the host sends changes, so
+//automation sounds the same at any block size. Any thread can post, there is one reader.
+class CabbageParameterEventList
 {
-    Array<CabbageChannelMessage, CriticalSection> outgoingChannelMessages;
-
 public:
-    CabbageMessageQueue() {}
-    ~CabbageMessageQueue() {}
+    enum { capacity = 4096, maxChannels = CabbageMessageQueue::maxChannels };
 
-    void addOutgoingChannelMessageToQueue(String _chan, double _val, String _type="");
-    void addOutgoingChannelMessageToQueue(String _chan, String _val, String _type="");
-    void addOutgoingTableUpdateMessageToQueue(String fStatement, int tableNumber);
-    CabbageChannelMessage &getOutgoingChannelMessageFromQueue(int index);
-    int getNumberOfOutgoingChannelMessagesInQueue();
-    void flushOutgoingChannelMessages();
+    struct Event
+    {
+        int channelId;
+        float value;
+        int64 time;
+        bool ramp;
+    };
 
-};
+    CabbageParameterEventList()
+        : events (capacity),
+          ramps (new Ramp[maxChannels]),
+          activeRamps (maxChannels)
+    {
+    }
+
+    //returns false if the change can't be queued, the caller should pass it on some other way
+    bool post (int channelId, float value, int64 time, bool ramp)
+    {
+        if (! isPositiveAndBelow (channelId, (int) maxChannels))
+            return false;
+
+        const SpinLock::ScopedLockType sl (writeLock);
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+            return false;
+
+        events[start1] = { channelId, value, time, ramp };
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    //reader only, once for each k-cycle, which covers numSamples from kCycleStart.
+    //Calls getValue (channelId) for the start of a ramp, and setValue (channelId, value)
+    //for each value to hand to Csound. Ramps last rampSamples, rounded to whole k-cycles
+    template <typename GetValue, typename SetValue>
+    void process (int64 kCycleStart, int numSamples, int rampSamples, GetValue&& getValue, SetValue&& setValue)
+    {
+        const int64 kCycleEnd = kCycleStart + numSamples;
+
+        //steps taken by ramps started in earlier k-cycles
+        for (int i = numActiveRamps; --i >= 0;)
+        {
+            const int channelId = activeRamps[i];
+            Ramp& ramp = ramps[channelId];
+
+            if (--ramp.stepsLeft <= 0)
+            {
+                ramp.value = ramp.target;
+                activeRamps[i] = activeRamps[--numActiveRamps];
+            }
+            else
+                ramp.value += ramp.increment;
+
+            setValue (channelId, (float) ramp.value);
+        }
+
+        //changes for later k-cycles are left in the list
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+        int numApplied = 0;
+
+        for (; numApplied < size1 + size2; numApplied++)
+        {
+            const Event& event = events[numApplied < size1 ? start1 + numApplied : start2 + numApplied - size1];
+
+            if (event.time >= kCycleEnd)
+                break;
+
+            apply (event, numSamples, rampSamples, getValue, setValue);
+        }
+
+        fifo.finishedRead (numApplied);
+    }
+
+    //reader only, while nothing is being processed
+    void reset()
+    {
+        for (int i = 0; i < maxChannels; i++)
+            ramps[i] = Ramp();
+
+        numActiveRamps = 0;
+    }
+
+private:
+    struct Ramp
+    {
+        double value = 0, target = 0, increment = 0;
+        int stepsLeft = 0;
+        int64 lastChangeTime = -1;
+    };
+
+    template <typename GetValue, typename SetValue>
+    void apply (const Event& event, int numSamples, int rampSamples, GetValue& getValue, SetValue& setValue)
+    {
+        Ramp& ramp = ramps[event.channelId];
+        const bool isRamping = ramp.stepsLeft > 0;
 
+        //another change for the same moment only moves the end of the ramp
+        if (event.ramp && isRamping && event.time == ramp.lastChangeTime)
+        {
+            ramp.target = event.value;
+            ramp.increment = (ramp.target - ramp.value) / ramp.stepsLeft;
+            return;
+        }
 
+        const int steps = numSamples > 0 ? roundToInt (rampSamples / (double) numSamples) : 0;
+        ramp.lastChangeTime = event.time;
+
+        if (! event.ramp || steps <= 1)
+        {
+            if (isRamping)
+                for (int i = 0; i < numActiveRamps; i++)
+                    if (activeRamps[i] == event.channelId)
+                        activeRamps[i] = activeRamps[--numActiveRamps];
+
+            ramp.value = ramp.target = event.value;
+            ramp.stepsLeft = 0;
+            setValue (event.channelId, event.value);
+            return;
+        }
+
+        if (! isRamping)
+        {
+            ramp.value = getValue (event.channelId);
+            activeRamps[numActiveRamps++] = event.channelId;
+        }
+
+        //the first step is taken now, and the target is reached on the last k-cycle of the ramp
+        ramp.target = event.value;
+        ramp.increment = (ramp.target - ramp.value) / steps;
+        ramp.stepsLeft = steps - 1;
+        ramp.value += ramp.increment;
+        setValue (event.channelId, (float) ramp.value);
+    }
+
+    AbstractFifo fifo { capacity };
+    HeapBlock<Event> events;
+    SpinLock writeLock;
+    std::unique_ptr<Ramp[]> ramps;
+    //the channels in ramps that are still moving, with storage for all of them so that it never grows
+    HeapBlock<int> activeRamps;
+    int numActiveRamps = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (CabbageParameterEventList)
+};
 
 #endif
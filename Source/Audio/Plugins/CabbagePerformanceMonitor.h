@@ -0,0 +1,254 @@
+/*
+  Copyright (C) 2019 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef CABBAGEPERFORMANCEMONITOR_H_INCLUDED
+#define CABBAGEPERFORMANCEMONITOR_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//the IDE is built with the monitor and everything else without it, unless the build says
+//otherwise. Without it the probes and the processor's monitor compile away to nothing
+#ifndef Cabbage_Performance_Monitor
+ #if defined(Cabbage_IDE_Build)
+  #define Cabbage_Performance_Monitor 1
+ #else
+  #define Cabbage_Performance_Monitor 0
+ #endif
+#endif
+
+//==============================================================================
+//wall clock timings from the audio thread, read by the GUI without locks. Every probe
+//keeps a running count, total, maximum and a histogram whose buckets double in width
+//every two steps, from 1us up to about three quarters of a second. Only the audio
+//thread writes, and a reader may see a snapshot that is a block out of date.
+class CabbagePerformanceMonitor
+{
+public:
+    enum Probe
+    {
+        processBlock = 0,   //the whole audio callback
+        performKsmps,       //Csound's k-cycles, including the MIDI read callback
+        hostData,           //sendHostDataToCsound()
+        csoundEvents,       //triggerCsoundEvents()
+        midiInput,          //ReadMidiData()
+        midiOutput,         //WriteMidiData()
+        numProbes
+    };
+
+    enum { numBuckets = 40, numLoadBuckets = 21 };
+
+    struct ProbeStats
+    {
+        uint32 count = 0;
+        double totalMicroseconds = 0, maxMicroseconds = 0;
+        uint32 histogram[numBuckets] = {};
+
+        double getMeanMicroseconds() const      { return count > 0 ? totalMicroseconds / count : 0; }
+
+        //upper edge of the bucket holding the given fraction of the timings
+        double getPercentileMicroseconds (double fraction) const
+        {
+            const uint32 target = (uint32) std::ceil (fraction * count);
+            uint32 total = 0;
+
+            for (int i = 0; i < numBuckets; i++)
+                if ((total += histogram[i]) >= target && total > 0)
+                    return getBucketLimit (i);
+
+            return 0;
+        }
+    };
+
+    struct Snapshot
+    {
+        ProbeStats probes[numProbes];
+        //share of each block's duration used by the callback, smoothed over a few blocks,
+        //and the highest seen since the previous snapshot
+        float load = 0, peakLoad = 0;
+        uint32 numOverruns = 0;
+        //blocks by load, in 5% steps, with the last bucket holding everything over 100%
+        uint32 loadHistogram[numLoadBuckets] = {};
+
+        //what happened between an earlier snapshot and this one. The maximums can't be
+        //taken apart, so they stay as they are
+        Snapshot since (const Snapshot& earlier) const
+        {
+            Snapshot difference (*this);
+
+            for (int probe = 0; probe < numProbes; probe++)
+            {
+                difference.probes[probe].count -= earlier.probes[probe].count;
+                difference.probes[probe].totalMicroseconds -= earlier.probes[probe].totalMicroseconds;
+
+                for (int i = 0; i < numBuckets; i++)
+                    difference.probes[probe].histogram[i] -= earlier.probes[probe].histogram[i];
+            }
+
+            difference.numOverruns -= earlier.numOverruns;
+
+            for (int i = 0; i < numLoadBuckets; i++)
+                difference.loadHistogram[i] -= earlier.loadHistogram[i];
+
+            return difference;
+        }
+    };
+
+    //times the enclosing scope
+    class ScopedProbe
+    {
+    public:
+        ScopedProbe (CabbagePerformanceMonitor& m, Probe p) : monitor (m), probe (p), start (Time::getHighResolutionTicks()) {}
+        ~ScopedProbe() { monitor.addTime (probe, start); }
+
+    private:
+        CabbagePerformanceMonitor& monitor;
+        const Probe probe;
+        const int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedProbe)
+    };
+
+    //audio thread only
+    void addTime (Probe probe, int64 startTicks)
+    {
+        addMicroseconds (probe, ticksToMicroseconds (Time::getHighResolutionTicks() - startTicks));
+    }
+
+    //audio thread only, call at the end of the callback with the ticks from its start
+    void addBlock (int64 startTicks, int numSamples, double sampleRate)
+    {
+        const double microseconds = ticksToMicroseconds (Time::getHighResolutionTicks() - startTicks);
+        addMicroseconds (processBlock, microseconds);
+
+        if (numSamples <= 0 || sampleRate <= 0)
+            return;
+
+        const float blockLoad = (float) (microseconds * sampleRate / (1000000.0 * numSamples));
+        const float smoothedLoad = load.load (std::memory_order_relaxed);
+        load.store (smoothedLoad + (blockLoad - smoothedLoad) * 0.1f, std::memory_order_relaxed);
+
+        if (blockLoad > peakLoad.load (std::memory_order_relaxed))
+            peakLoad.store (blockLoad, std::memory_order_relaxed);
+
+        if (blockLoad > 1.f)
+            increment (numOverruns);
+
+        increment (loadHistogram[jmin ((int) numLoadBuckets - 1, (int) (blockLoad * 20.f))]);
+    }
+
+    float getLoad() const               { return load.load (std::memory_order_relaxed); }
+    uint32 getNumOverruns() const       { return numOverruns.load (std::memory_order_relaxed); }
+
+    //the peak load is reset each time, so there should only be one thread taking snapshots
+    void getSnapshot (Snapshot& snapshot)
+    {
+        for (int probe = 0; probe < numProbes; probe++)
+        {
+            const ProbeCounters& counters = probes[probe];
+            ProbeStats& stats = snapshot.probes[probe];
+            stats.count = counters.count.load (std::memory_order_relaxed);
+            stats.totalMicroseconds = counters.totalMicroseconds.load (std::memory_order_relaxed);
+            stats.maxMicroseconds = counters.maxMicroseconds.load (std::memory_order_relaxed);
+
+            for (int i = 0; i < numBuckets; i++)
+                stats.histogram[i] = counters.histogram[i].load (std::memory_order_relaxed);
+        }
+
+        snapshot.load = getLoad();
+        snapshot.peakLoad = peakLoad.exchange (0.f, std::memory_order_relaxed);
+        snapshot.numOverruns = getNumOverruns();
+
+        for (int i = 0; i < numLoadBuckets; i++)
+            snapshot.loadHistogram[i] = loadHistogram[i].load (std::memory_order_relaxed);
+    }
+
+    //only while the audio callback isn't running, from prepareToPlay() for example
+    void reset()
+    {
+        for (auto& counters : probes)
+        {
+            counters.count = 0;
+            counters.totalMicroseconds = 0;
+            counters.maxMicroseconds = 0;
+
+            for (auto& bucket : counters.histogram)
+                bucket = 0;
+        }
+
+        load = 0.f;
+        peakLoad = 0.f;
+        numOverruns = 0;
+
+        for (auto& bucket : loadHistogram)
+            bucket = 0;
+    }
+
+    static double getBucketLimit (int bucket)
+    {
+        return std::pow (2.0, bucket * 0.5);
+    }
+
+private:
+    struct ProbeCounters
+    {
+        std::atomic<uint32> count { 0 };
+        std::atomic<double> totalMicroseconds { 0 }, maxMicroseconds { 0 };
+        std::atomic<uint32> histogram[numBuckets] = {};
+    };
+
+    //there is a single writer, so a load and a store don't need to be a read-modify-write
+    static void increment (std::atomic<uint32>& counter)
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static double ticksToMicroseconds (int64 ticks)
+    {
+        static const double microsecondsPerTick = 1000000.0 / (double) Time::getHighResolutionTicksPerSecond();
+        return ticks * microsecondsPerTick;
+    }
+
+    void addMicroseconds (Probe probe, double microseconds)
+    {
+        ProbeCounters& counters = probes[probe];
+        const int bucket = jlimit (0, (int) numBuckets - 1, (int) std::ceil (2.0 * std::log2 (jmax (1.0, microseconds))));
+
+        increment (counters.count);
+        increment (counters.histogram[bucket]);
+        counters.totalMicroseconds.store (counters.totalMicroseconds.load (std::memory_order_relaxed) + microseconds, std::memory_order_relaxed);
+
+        if (microseconds > counters.maxMicroseconds.load (std::memory_order_relaxed))
+            counters.maxMicroseconds.store (microseconds, std::memory_order_relaxed);
+    }
+
+    ProbeCounters probes[numProbes];
+    std::atomic<float> load { 0.f }, peakLoad { 0.f };
+    std::atomic<uint32> numOverruns { 0 };
+    std::atomic<uint32> loadHistogram[numLoadBuckets] = {};
+};
+
+#if Cabbage_Performance_Monitor
+ #define CABBAGE_PERFORMANCE_PROBE(monitor, probe) \
+    const CabbagePerformanceMonitor::ScopedProbe JUCE_JOIN_MACRO (performanceProbe, __LINE__) (monitor, CabbagePerformanceMonitor::probe)
+#else
+ #define CABBAGE_PERFORMANCE_PROBE(monitor, probe)
+#endif
+
+#endif  // CABBAGEPERFORMANCEMONITOR_H_INCLUDED
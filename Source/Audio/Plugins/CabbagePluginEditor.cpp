@@ -449,7 +449,7 @@ void CabbagePluginEditor::insertXYPad (ValueTree cabbageWidgetData)
     xyPad->getSliderX().addListener (this);
     xyPad->getSliderY().addListener (this);
     addToEditorAndMakeVisible (xyPad, cabbageWidgetData);
-    cabbageProcessor.addXYAutomator (xyPad, cabbageWidgetData);
+    cabbageProcessor.addXYAutomator (cabbageWidgetData);
     addMouseListenerAndSetVisibility (xyPad, cabbageWidgetData);
 }
 
@@ -605,16 +605,7 @@ void CabbagePluginEditor::insertLight (ValueTree cabbageWidgetData)
 //======================================================================================================
 CabbagePluginParameter* CabbagePluginEditor::getParameterForComponent (const String name)
 {
-    for (auto param : cabbageProcessor.getCabbageParameters())
-    {
-        if (CabbagePluginParameter* cabbageParam = dynamic_cast<CabbagePluginParameter*> (param))
-        {
-            if (name == cabbageParam->getWidgetName())
-                return cabbageParam;
-        }
-    }
-
-    return nullptr;
+    return cabbageProcessor.getParameterForWidgetName (name);
 }
 
 //======================================================================================================
@@ -965,13 +956,13 @@ void CabbagePluginEditor::updatefTableData (GenTable* table)
 void CabbagePluginEditor::sendChannelDataToCsound (String channel, float value)
 {
     if (csdCompiledWithoutError() && cabbageProcessor.getCsound())
-        cabbageProcessor.getCsound()->SetChannel (channel.getCharPointer(), value);
+        cabbageProcessor.postChannelValue (cabbageProcessor.getControlChannel (channel), value);
 }
 
 float CabbagePluginEditor::getChannelDataFromCsound (String channel)
 {
     if (csdCompiledWithoutError() && cabbageProcessor.getCsound())
-        return cabbageProcessor.getCsound()->GetChannel (channel.getCharPointer());
+        return cabbageProcessor.getControlChannel (channel)->getValue();
     
     return 0;
 }
@@ -988,10 +979,10 @@ void CabbagePluginEditor::sendScoreEventToCsound (String scoreEvent)
         cabbageProcessor.getCsound()->InputMessage(scoreEvent.toUTF8());
 }
 
-void CabbagePluginEditor::createEventMatrix(int cols, int rows, String channel)
+void CabbagePluginEditor::createEventMatrix(int cols, int rows, String channel, bool isVertical)
 {
     if (cabbageProcessor.csdCompiledWithoutError())
-        cabbageProcessor.createMatrixEventSequencer(cols, rows, channel);
+        cabbageProcessor.createMatrixEventSequencer(cols, rows, channel, isVertical);
 }
 
 void CabbagePluginEditor::setEventMatrixData(int cols, int rows, String channel, String data)
@@ -1001,14 +992,31 @@ void CabbagePluginEditor::setEventMatrixData(int cols, int rows, String channel,
 }
 
 
-const Array<float, CriticalSection> CabbagePluginEditor::getArrayForSignalDisplay (const String signalVariable, const String displayType)
+const Array<float, CriticalSection> CabbagePluginEditor::getArrayForSignalDisplay (const String signalVariable, const String displayType,
+                                                                                   CsoundPluginProcessor::SignalDisplay::Reduction* reduction)
 {
     if (csdCompiledWithoutError())
-        return cabbageProcessor.getSignalArray (signalVariable, displayType)->getPoints();
+    {
+        if (auto* display = cabbageProcessor.getSignalArray (signalVariable, displayType))
+        {
+            if (reduction != nullptr)
+                *reduction = display->getReduction();
+
+            return display->getPoints();
+        }
+    }
 
     return Array<float, CriticalSection>();
 }
 
+void CabbagePluginEditor::setSignalDisplayReduction (const String signalVariable, const String displayType,
+                                                     CsoundPluginProcessor::SignalDisplay::Reduction reduction, int numColumns)
+{
+    if (csdCompiledWithoutError())
+        if (auto* display = cabbageProcessor.getSignalArray (signalVariable, displayType))
+            display->setReduction (reduction, numColumns);
+}
+
 bool CabbagePluginEditor::shouldUpdateSignalDisplay(String signalVariableName)
 {
     return cabbageProcessor.shouldUpdateSignalDisplay(signalVariableName);
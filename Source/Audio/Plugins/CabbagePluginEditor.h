@@ -124,7 +124,7 @@ public:
     void sendChannelStringDataToCsound (String channel, String value);
     float getChannelDataFromCsound (String channel);
     void sendScoreEventToCsound (String scoreEvent);
-    void createEventMatrix(int cols, int rows, String channel);
+    void createEventMatrix(int cols, int rows, String channel, bool isVertical);
     void setEventMatrixData(int cols, int rows, String channel, String data);
     void setEventMatrixCurrentPosition(int cols, int rows, String channel, int position);
     bool isAudioUnit()
@@ -135,7 +135,10 @@ public:
     String currentPresetName;
     void savePluginStateToFile (File snapshotFile, String presetName="", bool remove = false);
     void restorePluginStateFrom (String childPreset, File xmlFile);
-    const Array<float, CriticalSection> getArrayForSignalDisplay (const String signalVariable, const String displayType);
+    const Array<float, CriticalSection> getArrayForSignalDisplay (const String signalVariable, const String displayType,
+                                                                  CsoundPluginProcessor::SignalDisplay::Reduction* reduction = nullptr);
+    void setSignalDisplayReduction (const String signalVariable, const String displayType,
+                                    CsoundPluginProcessor::SignalDisplay::Reduction reduction, int numColumns);
     const String getCsoundOutputFromProcessor();
     StringArray getTableStatement (int tableNumber);
     bool csdCompiledWithoutError();
@@ -57,10 +57,8 @@ createPluginFilter() {
 	if (csdFile.existsAsFile() == false)
 		Logger::writeToLog("Could not find .csd file " + csdFile.getFullPathName() + ", please make sure it's in the correct folder");
 
-	String csdString = csdFile.loadFileAsString();
 #ifdef CabbagePro
-	csdString = Encrypt::decode(csdFile);
-#endif
+	String csdString = Encrypt::decode(csdFile);
 
 	StringArray csdLines;
 	csdLines.addLines(csdString);
@@ -79,11 +77,21 @@ createPluginFilter() {
 	}
 
 	const int numOutChannels = CabbageUtilities::getHeaderInfo(csdString, "nchnls");
+	const int numInputHeader = CabbageUtilities::getHeaderInfo(csdString, "nchnls_i");
+#else
+	//hosts often create many instances of the same plugin, they all share one scan of the csd
+	CabbagePreprocessedCsd::Ptr csd = CabbagePreprocessedCsd::get(csdFile);
+	const ValueTree form = csd->getForm();
+	const int sideChainChannels = form.isValid() ? int (CabbageWidgetData::getProperty(form, CabbageIdentifierIds::sidechain)) : 0;
+	const int numOutChannels = csd->getHeaderInfo("nchnls");
+	const int numInputHeader = csd->getHeaderInfo("nchnls_i");
+#endif
+
 	int numInChannels = numOutChannels;
-	if (CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") != -1 && CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") != 0)
-		numInChannels = CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") - sideChainChannels;
+	if (numInputHeader != -1 && numInputHeader != 0)
+		numInChannels = numInputHeader - sideChainChannels;
 
-#if !Cabbage_IDE_Build && !Cabbage_Lite
+#if !Cabbage_IDE_Build && !Cabbage_Lite && !Cabbage_Benchmark
 	PluginHostType pluginHostType;
 	if (sideChainChannels != 0)
 		return new CabbagePluginProcessor(csdFile, AudioChannelSet::canonicalChannelSet(numInChannels), AudioChannelSet::canonicalChannelSet(numOutChannels), AudioChannelSet::canonicalChannelSet(sideChainChannels));
@@ -121,17 +129,25 @@ CabbagePluginProcessor::CabbagePluginProcessor(File inputFile, AudioChannelSet i
 	createCsound(inputFile);
 }
 
-void CabbagePluginProcessor::createCsound(File inputFile, bool shouldCreateParameters)
+void CabbagePluginProcessor::createCsound(File inputFile, bool shouldCreateParameters, bool compileInBackground)
 {
 	if (inputFile.existsAsFile()) {
+		loadTimings = {};
+		double stageStart = Time::getMillisecondCounterHiRes();
+		//the opcode directory is process-wide, so it is only set while nothing else is compiling
+		if (compileInBackground && !canRecompileCsoundInBackground(inputFile))
+			compileInBackground = false;
+
+		//a background compile leaves the running widgets alone until its instance is swapped in
+		ValueTree widgets(compileInBackground ? ValueTree("CabbageWidgetData") : cabbageWidgets);
+
 		setWidthHeight();
-		StringArray linesFromCsd;
-		linesFromCsd.addLines(inputFile.loadFileAsString());
+		StringArray linesFromCsd (CabbagePreprocessedCsd::get(inputFile)->lines);
 
 		//only create extended temp file if imported plants are being added...
 		if (addImportFiles(linesFromCsd) == true)
 		{
-			parseCsdFile(linesFromCsd);
+			parseCsdFile(linesFromCsd, widgets);
 
 
 			File tempFile = File::createTempFile(inputFile.getFileNameWithoutExtension() + "_temp.csd");
@@ -144,7 +160,12 @@ void CabbagePluginProcessor::createCsound(File inputFile, bool shouldCreateParam
 
 			CabbageUtilities::debug(tempFile.loadFileAsString());
 
-			if (setupAndCompileCsound(tempFile, inputFile.getParentDirectory(), samplingRate) == false)
+			loadTimings.parse = Time::getMillisecondCounterHiRes() - stageStart;
+			stageStart = Time::getMillisecondCounterHiRes();
+
+			if (compileInBackground)
+				recompileCsoundInBackground(tempFile, inputFile.getParentDirectory(), samplingRate, widgets);
+			else if (setupAndCompileCsound(tempFile, inputFile.getParentDirectory(), samplingRate) == false)
 				this->suspendProcessing(true);
 
 			csdFile = tempFile;
@@ -152,82 +173,102 @@ void CabbagePluginProcessor::createCsound(File inputFile, bool shouldCreateParam
 		}
 
 		else {
-			parseCsdFile(linesFromCsd);
+			parseCsdFile(linesFromCsd, widgets);
 			csdFile = inputFile;
-			if (setupAndCompileCsound(inputFile, inputFile.getParentDirectory(), samplingRate) == false)
+
+			loadTimings.parse = Time::getMillisecondCounterHiRes() - stageStart;
+			stageStart = Time::getMillisecondCounterHiRes();
+
+			if (compileInBackground)
+				recompileCsoundInBackground(inputFile, inputFile.getParentDirectory(), samplingRate, widgets);
+			else if (setupAndCompileCsound(inputFile, inputFile.getParentDirectory(), samplingRate) == false)
 				this->suspendProcessing(true);
 		}
 
+		loadTimings.compile = Time::getMillisecondCounterHiRes() - stageStart;
+		stageStart = Time::getMillisecondCounterHiRes();
+
 		if (shouldCreateParameters)
 			createCabbageParameters();
 
+		loadTimings.parameters = Time::getMillisecondCounterHiRes() - stageStart;
+
 		csoundChanList = NULL;
 
-		initAllCsoundChannels(cabbageWidgets);
+		//a background compile initialises its own channels before it is swapped in
+		if (!compileInBackground) {
+			stopRemovedXYAutomators();
+			initAllCsoundChannels(cabbageWidgets);
+		}
 
 		csdLastModifiedAt = csdFile.getLastModificationTime().toMilliseconds();
 
 	}
 }
 
-CabbagePluginProcessor::~CabbagePluginProcessor() {
-	for (auto xyAuto : xyAutomators)
-		xyAuto->removeAllChangeListeners();
+void CabbagePluginProcessor::previousCsoundInstanceDeleted() {
+	CsoundPluginProcessor::previousCsoundInstanceDeleted();
+	widgetUpdateCsound = nullptr;
+	widgetUpdates = nullptr;
+}
 
-	xyAutomators.clear();
+void CabbagePluginProcessor::csoundInstanceSwapped(ValueTree cabbageData) {
+	//the new instance was compiled against these widgets, so they only take over now
+	cabbageWidgets.removeAllChildren(nullptr);
 
+	while (cabbageData.getNumChildren() > 0) {
+		ValueTree widget = cabbageData.getChild(0);
+		cabbageData.removeChild(0, nullptr);
+		cabbageWidgets.addChild(widget, -1, nullptr);
+	}
+
+	stopRemovedXYAutomators();
+	channelPollPlanIsStale = true;
+}
+
+CabbagePluginProcessor::~CabbagePluginProcessor() {
 	//    cabbageWidgets.removeAllChildren(nullptr);
 	//    cabbageWidgets.removeAllProperties(nullptr);
 }
 
 void CabbagePluginProcessor::timerCallback()
 {
+	swapPendingCsoundInstanceIfStalled();
+
+	//pick up further edits once the current recompile has been swapped in
+	if (isRecompilingCsound())
+		return;
+
 	int64 modTime = csdFile.getLastModificationTime().toMilliseconds();
 
 	if (modTime != csdLastModifiedAt && csdFile.existsAsFile())
 	{
 		csdLastModifiedAt = csdFile.getLastModificationTime().toMilliseconds();
 		CabbageUtilities::debug("resetting file due to update of file on disk");
-		createCsound(csdFile, false);
+		createCsound(csdFile, false, true);
 	}
 }
 
 //==============================================================================
 void CabbagePluginProcessor::setWidthHeight() {
-	StringArray csdLines;
-	csdLines.addLines(csdFile.loadFileAsString());
+	const ValueTree form = CabbagePreprocessedCsd::get(csdFile)->getForm();
 
-	for (auto line : csdLines) {
-		if (line.contains("</Cabbage>"))
-			return;
-
-		ValueTree temp("temp");
-		CabbageWidgetData::setWidgetState(temp, line, 0);
-
-		if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form) {
-			screenHeight = CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::height);
-			screenWidth = CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::width);
-		}
+	if (form.isValid()) {
+		screenHeight = CabbageWidgetData::getNumProp(form, CabbageIdentifierIds::height);
+		screenWidth = CabbageWidgetData::getNumProp(form, CabbageIdentifierIds::width);
 	}
 }
 
-void CabbagePluginProcessor::parseCsdFile(StringArray& linesFromCsd)
+void CabbagePluginProcessor::parseCsdFile(StringArray& linesFromCsd, ValueTree widgets)
 {
 
 	for (auto line : linesFromCsd)
 	{
-		ValueTree temp("temp");
-		CabbageWidgetData::setWidgetState(temp, line, 0);
-
-		if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
-		{
-			if (line.contains("autoupdate()"))
-				startTimer(1000);
-		}
-
+		if (line.contains("autoupdate()") && CabbagePreprocessedCsd::isFormLine(line))
+			startTimer(1000);
 	}
 
-	cabbageWidgets.removeAllChildren(0);
+	widgets.removeAllChildren(0);
 	String parentComponent, previousComponent;
 	StringArray parents;
 
@@ -312,7 +353,7 @@ void CabbagePluginProcessor::parseCsdFile(StringArray& linesFromCsd)
 		const String widgetName = CabbageWidgetData::getStringProp(tempWidget, CabbageIdentifierIds::name);
 
 		if (widgetName.isNotEmpty())
-			cabbageWidgets.addChild(tempWidget, -1, 0);
+			widgets.addChild(tempWidget, -1, 0);
 
 		if (CabbageWidgetData::getProperty(tempWidget, CabbageIdentifierIds::widgetarray).size() > 0 &&
 			CabbageWidgetData::getProperty(tempWidget, CabbageIdentifierIds::identchannelarray).size() > 0) {
@@ -332,7 +373,7 @@ void CabbagePluginProcessor::parseCsdFile(StringArray& linesFromCsd)
 				CabbageWidgetData::setStringProp(copy, CabbageIdentifierIds::identchannel,
 					CabbageWidgetData::getProperty(tempWidget,
 						CabbageIdentifierIds::identchannelarray)[i]);
-				cabbageWidgets.addChild(copy, -1, 0);
+				widgets.addChild(copy, -1, 0);
 			}
 		}
 
@@ -345,6 +386,8 @@ void CabbagePluginProcessor::parseCsdFile(StringArray& linesFromCsd)
 
 
 	}
+
+	channelPollPlanIsStale = true;
 }
 
 bool CabbagePluginProcessor::isWidgetPlantParent(StringArray linesFromCsd, int lineNumber) {
@@ -372,6 +415,11 @@ bool CabbagePluginProcessor::addImportFiles(StringArray& linesFromCsd) {
 		ValueTree temp("temp");
 		String newCsdLine = linesFromCsd[i];
 		expandMacroText(newCsdLine, temp);
+
+		//only the form line can import files
+		if (!CabbagePreprocessedCsd::isFormLine(newCsdLine))
+			continue;
+
 		CabbageWidgetData::setWidgetState(temp, newCsdLine, 0);
 
 		if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form) {
@@ -700,7 +748,7 @@ void CabbagePluginProcessor::updateWidgets(String csdText) {
 	CabbagePluginEditor* editor = static_cast<CabbagePluginEditor*> (this->getActiveEditor());
 	StringArray strings;
 	strings.addLines(csdText);
-	parseCsdFile(strings);
+	parseCsdFile(strings, cabbageWidgets);
 	editor->createEditorInterface(cabbageWidgets);
 	editor->updateLayoutEditorFrames();
 }
@@ -711,7 +759,25 @@ void CabbagePluginProcessor::addCabbageParameter(std::unique_ptr<CabbagePluginPa
 		addParameter(parameter->releaseHostParameter());
 	}
 
+	//first parameter registered for a channel or widget wins, as with the old linear searches
+	if (!parametersByChannel.contains(parameter->getChannel()))
+		parametersByChannel.set(parameter->getChannel(), parameter.get());
+
+	if (!parametersByWidgetName.contains(parameter->getWidgetName()))
+		parametersByWidgetName.set(parameter->getWidgetName(), parameter.get());
+
 	parameters.add(parameter.release());
+	channelPollPlanIsStale = true;
+}
+
+CabbagePluginParameter* CabbagePluginProcessor::getParameterForChannel(const String& channel) const
+{
+	return parametersByChannel[channel];
+}
+
+CabbagePluginParameter* CabbagePluginProcessor::getParameterForWidgetName(const String& widgetName) const
+{
+	return parametersByWidgetName[widgetName];
 }
 
 //==============================================================================
@@ -957,7 +1023,7 @@ XmlElement CabbagePluginProcessor::savePluginState(String xmlTag, File xmlFile,
 	if (pd != nullptr)
 	{
 		auto pdClass = *pd;
-		xml->getChildByName(presetName)->setAttribute("cabbageJSONData", pdClass->data);
+		xml->getChildByName(presetName)->setAttribute("cabbageJSONData", String(pdClass->getJson()));
 	}
 
         
@@ -1056,6 +1122,18 @@ void CabbagePluginProcessor::setParametersFromXml(XmlElement* e)
 {
 	if (e)
 	{
+		//index widgets by their first channel once, rather than searching the tree for every attribute.
+		//Matches CabbageWidgetData::getValueTreeForComponent(), which returns a copy for single string channels
+		HashMap<String, int> widgetIndexByChannel;
+
+		for (int i = 0; i < cabbageWidgets.getNumChildren(); i++)
+		{
+			const String channel = CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::channel);
+
+			if (!widgetIndexByChannel.contains(channel))
+				widgetIndexByChannel.set(channel, i);
+		}
+
 		for (int i = 1; i < e->getNumAttributes(); i++)
 		{
 			//none of these are being updated in their respective valueTreeChanged listeners..
@@ -1071,7 +1149,13 @@ void CabbagePluginProcessor::setParametersFromXml(XmlElement* e)
             }
             
             
-			ValueTree valueTree = CabbageWidgetData::getValueTreeForComponent(cabbageWidgets, e->getAttributeName(i), true);
+			ValueTree valueTree("empty");
+
+			if (widgetIndexByChannel.contains(e->getAttributeName(i)))
+			{
+				const ValueTree widget = cabbageWidgets.getChild(widgetIndexByChannel[e->getAttributeName(i)]);
+				valueTree = widget.getProperty(CabbageIdentifierIds::channel).size() > 0 ? widget : widget.createCopy();
+			}
 
 
 			const String type = CabbageWidgetData::getStringProp(valueTree, CabbageIdentifierIds::type);
@@ -1126,14 +1210,11 @@ void CabbagePluginProcessor::setParametersFromXml(XmlElement* e)
 				//now make changes parameter changes so host can see them..
 				//getParameters().
 
-				for (auto cabbageParam : getCabbageParameters())
+				if (CabbagePluginParameter* cabbageParam = getParameterForWidgetName(widgetName))
 				{
-					if (widgetName == cabbageParam->getWidgetName())
-					{
-						cabbageParam->beginChangeGesture();
-						cabbageParam->setValueNotifyingHost(cabbageParam->getNormalisableRange().convertTo0to1(e->getAttributeValue(i).getFloatValue()));
-						cabbageParam->endChangeGesture();
-					}
+					cabbageParam->beginChangeGesture();
+					cabbageParam->setValueNotifyingHost(cabbageParam->getNormalisableRange().convertTo0to1(e->getAttributeValue(i).getFloatValue()));
+					cabbageParam->endChangeGesture();
 				}
 			}
 		}
@@ -1141,20 +1222,20 @@ void CabbagePluginProcessor::setParametersFromXml(XmlElement* e)
 }
 
 //==============================================================================
-// This method is responsible for updating widget valuetrees based on the current
-// data stored in each widget's software channel bus. 
+// Works out once which channels each widget listens to, so that the GUI poll
+// doesn't need to query every widget's properties on each update.
 //==============================================================================
-void CabbagePluginProcessor::getChannelDataFromCsound()
+void CabbagePluginProcessor::buildChannelPollPlan()
 {
-	if (!getCsound())
-		return;
+	channelPollPlan.clearQuick();
+	widgetUpdateNames.clearQuick();
 
 	for (int i = 0; i < cabbageWidgets.getNumChildren(); i++)
 	{
-		const var chanArray = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::channel);
+		ValueTree widget = cabbageWidgets.getChild(i);
+		const var chanArray = CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::channel);
 		const String channelName = (chanArray.size() > 0 ? chanArray[0].toString() : chanArray.toString());
-		const var widgetArray = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i),
-			CabbageIdentifierIds::widgetarray);
+		const var widgetArray = CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::widgetarray);
 
 		StringArray channels;
 
@@ -1167,217 +1248,512 @@ void CabbagePluginProcessor::getChannelDataFromCsound()
 				channels.add(var(chanArray[j]));
 		}
 
-		const var value = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::value);
+		const var value = CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::value);
+		const String typeOfWidget = CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::type);
 
-		const String identChannel = CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i),
-			CabbageIdentifierIds::identchannel);
-
-		const String typeOfWidget = CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i),
-			CabbageIdentifierIds::type);
-
-		const String chann = channels[0];
-
-		if (channels.size() == 1 && channels[0].isNotEmpty()) {
+		ChannelPollEntry entry;
+		entry.widget = widget;
+		entry.identChannel = CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::identchannel);
 
+		if (channels.size() == 1 && channels[0].isNotEmpty())
+		{
 			if (value.isString() == false)
 			{
-				if (getCsound()->GetChannel(channels[0].toUTF8()) != float(value))
-				{
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::value,
-						getCsound()->GetChannel(channels[0].toUTF8()));
-					//now update plugin parameters..
-					//const int automationMode = getAutomationMode();
-					if (automationMode == 1)
-					{
-						for (auto cabbageParam : getCabbageParameters())
-						{
-							if (cabbageParam->getChannel() == channels[0].toUTF8())
-							{
-								cabbageParam->beginChangeGesture();
-								cabbageParam->setValueNotifyingHost(cabbageParam->getNormalisableRange().convertTo0to1(getCsound()->GetChannel(channels[0].toUTF8())));
-								cabbageParam->endChangeGesture();
-							}
-						}
-					}
-				}
+				entry.type = ChannelPollEntry::numericValue;
+				entry.channels[0] = getControlChannel(channels[0]);
+				entry.lastValues[0] = float(value);
 
+				entry.parameters[0] = getParameterForChannel(channels[0]);
 			}
 			else
 			{
-				char tmp_str[4096] = { 0 };
-				getCsound()->GetStringChannel(channels[0].toUTF8(), tmp_str);
-				CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::value,
-					String(tmp_str));
+				entry.type = ChannelPollEntry::stringValue;
+				entry.stringChannel = channels[0];
+				entry.lastString = value.toString();
 			}
 		}
-
 		//currently only dealing with a max of 2 channels...
 		else if (channels.size() == 2 && channels[0].isNotEmpty() && channels[1].isNotEmpty() &&
 			typeOfWidget != CabbageWidgetTypes::eventsequencer)
 		{
-			const float valuex = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuex);
-			const float valuey = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuey);
-			if (getCsound()->GetChannel(channels[0].toUTF8()) != valuex
-				|| getCsound()->GetChannel(channels[1].toUTF8()) != valuey) {
-				if (typeOfWidget == CabbageWidgetTypes::xypad) {
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuex,
-						getCsound()->GetChannel(channels[0].toUTF8()));
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuey,
-						getCsound()->GetChannel(channels[1].toUTF8()));
-				}
-				else if (typeOfWidget.contains("range")) {
-					//                    const float minValue = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i),
-					//                        CabbageIdentifierIds::minvalue);
-					//                    const float maxValue = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i),
-					//                        CabbageIdentifierIds::maxvalue);
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::minvalue,
-						getCsound()->GetChannel(channels[0].toUTF8()));
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::maxvalue,
-						getCsound()->GetChannel(channels[1].toUTF8()));
-				}
+			if (typeOfWidget == CabbageWidgetTypes::xypad)
+			{
+				entry.type = ChannelPollEntry::xyValue;
+				entry.lastValues[0] = CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::valuex);
+				entry.lastValues[1] = CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::valuey);
+			}
+			else if (typeOfWidget.contains("range"))
+			{
+				entry.type = ChannelPollEntry::rangeValue;
+				entry.lastValues[0] = CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::minvalue);
+				entry.lastValues[1] = CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::maxvalue);
 			}
-		}
-
-		if (identChannel.isNotEmpty()) {
-			const String identChannelMessage = CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i),
-				CabbageIdentifierIds::identchannelmessage);
-			memset(&tmp_string[0], 0, sizeof(tmp_string));
-			getCsound()->GetStringChannel(identChannel.toUTF8(), tmp_string);
-
-			const String identifierText(tmp_string);
-			//CabbageUtilities::debug(identifierText);
-			if (identifierText.isNotEmpty() && identifierText != identChannelMessage) {
-				CabbageWidgetData::setCustomWidgetState(cabbageWidgets.getChild(i), " " + identifierText);
-
-				if (identifierText.contains("tablenumber")) //update even if table number has not changed
-					CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update, 1);
-				else if (identifierText == CabbageIdentifierIds::tofront.toString() + "()") {
-					CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::tofront,
-						Random::getSystemRandom().nextInt());
-				}
-
-				getCsound()->SetChannel(identChannel.toUTF8(), (char*) "");
 
-				CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update,
-					0); //reset value for further updates
+			entry.channels[0] = getControlChannel(channels[0]);
+			entry.channels[1] = getControlChannel(channels[1]);
 
-			}
-			else
+			//the x and y parameters, as an automating pad writes its channels directly
+			if (entry.type == ChannelPollEntry::xyValue)
 			{
-				float update = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update);
-				if (update == 1.0f)
-					CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update,
-						0);
+				entry.parameters[0] = getParameterForChannel(channels[0]);
+				entry.parameters[1] = getParameterForChannel(channels[1]);
 			}
 		}
 
-		// reset value for widgets without identchannel
-		else
-		{
-			CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update,
-				0);
-		}
+		channelPollPlan.add(entry);
 	}
+
+	channelPollPlanIsStale = false;
 }
 
-void CabbagePluginProcessor::triggerCsoundEvents() {
+//==============================================================================
+// This method is responsible for updating widget valuetrees based on the current
+// data stored in each widget's software channel bus. Only widgets whose channel
+// data has changed since the last call are touched.
+//==============================================================================
+void CabbagePluginProcessor::getChannelDataFromCsound()
+{
 	if (!getCsound())
 		return;
 
-	for (int x = 0; x < matrixEventSequencers.size(); x++) {
-		const ValueTree widgetData = CabbageWidgetData::getValueTreeForComponent(cabbageWidgets,
-			matrixEventSequencers[x]->channel,
-			true);
-		const String channel = CabbageWidgetData::getStringProp(widgetData, CabbageIdentifierIds::channel);
-		const int position = getCsound()->GetChannel(channel.toUTF8());
-
-		if (CabbageWidgetData::getStringProp(widgetData, CabbageIdentifierIds::orientation) == "vertical") {
-			for (int i = 0; i < CabbageWidgetData::getNumProp(widgetData, CabbageIdentifierIds::matrixcols); i++) {
-				if (matrixEventSequencers[x]->position != position) {
-					String event = matrixEventSequencers[x]->events.getUnchecked(i)->getReference(position);
-					if (event.isNotEmpty()) {
-						getCsound()->InputMessage(event.toUTF8());
-					}
-				}
+	if (channelPollPlanIsStale || channelPollPlan.size() != cabbageWidgets.getNumChildren())
+		buildChannelPollPlan();
+
+	widgetStatePublisher.update();
+
+	for (auto& entry : channelPollPlan)
+	{
+		if (entry.type == ChannelPollEntry::numericValue)
+		{
+			const MYFLT currentValue = entry.channels[0]->getValue();
+
+			if (currentValue != entry.lastValues[0])
+			{
+				entry.lastValues[0] = currentValue;
+				CabbageWidgetData::setNumProp(entry.widget, CabbageIdentifierIds::value, currentValue);
+				widgetNotificationCount++;
+				//now update plugin parameters..
+				notifyParameterOfChannelValue(entry.parameters[0], currentValue);
+			}
+		}
+		else if (entry.type == ChannelPollEntry::stringValue)
+		{
+			tmp_string[0] = 0;
+			getCsound()->GetStringChannel(entry.stringChannel.toUTF8(), tmp_string);
+
+			if (entry.lastString != tmp_string)
+			{
+				entry.lastString = String(tmp_string);
+				CabbageWidgetData::setProperty(entry.widget, CabbageIdentifierIds::value, entry.lastString);
+				widgetNotificationCount++;
 			}
 		}
-		else //horizontal
+		else if (entry.type == ChannelPollEntry::xyValue || entry.type == ChannelPollEntry::rangeValue)
 		{
-			for (int i = 0; i < CabbageWidgetData::getNumProp(widgetData, CabbageIdentifierIds::matrixrows); i++) {
-				if (matrixEventSequencers[x]->position != position) {
-					String event = matrixEventSequencers[x]->events.getUnchecked(position)->getReference(i);
-					if (event.isNotEmpty()) {
-						getCsound()->InputMessage(event.toUTF8());
+			const MYFLT firstValue = entry.channels[0]->getValue();
+			const MYFLT secondValue = entry.channels[1]->getValue();
+
+			if (firstValue != entry.lastValues[0] || secondValue != entry.lastValues[1])
+			{
+				entry.lastValues[0] = firstValue;
+				entry.lastValues[1] = secondValue;
+				const bool isXY = entry.type == ChannelPollEntry::xyValue;
+				CabbageWidgetData::setNumProp(entry.widget, isXY ? CabbageIdentifierIds::valuex : CabbageIdentifierIds::minvalue, firstValue);
+				CabbageWidgetData::setNumProp(entry.widget, isXY ? CabbageIdentifierIds::valuey : CabbageIdentifierIds::maxvalue, secondValue);
+				widgetNotificationCount += 2;
+
+				notifyParameterOfChannelValue(entry.parameters[0], firstValue);
+				notifyParameterOfChannelValue(entry.parameters[1], secondValue);
+			}
+		}
+
+		if (entry.identChannel.isNotEmpty()) {
+			tmp_string[0] = 0;
+			getCsound()->GetStringChannel(entry.identChannel.toUTF8(), tmp_string);
+
+			//ident channels are cleared once read, so most of the time there is nothing to do
+			if (tmp_string[0] != 0)
+			{
+				const String identifierText(tmp_string);
+				const String identChannelMessage = CabbageWidgetData::getStringProp(entry.widget,
+					CabbageIdentifierIds::identchannelmessage);
+				//CabbageUtilities::debug(identifierText);
+				if (identifierText != identChannelMessage) {
+					CabbageWidgetData::setCustomWidgetState(entry.widget, " " + identifierText);
+
+					if (identifierText.contains("tablenumber")) //update even if table number has not changed
+						CabbageWidgetData::setProperty(entry.widget, CabbageIdentifierIds::update, 1);
+					else if (identifierText == CabbageIdentifierIds::tofront.toString() + "()") {
+						CabbageWidgetData::setProperty(entry.widget, CabbageIdentifierIds::tofront,
+							Random::getSystemRandom().nextInt());
 					}
+
+					getCsound()->SetChannel(entry.identChannel.toUTF8(), (char*) "");
+					widgetNotificationCount++;
 				}
 			}
 		}
-		matrixEventSequencers[x]->position = position;
+
+		//reset value for further updates. update can be set from anywhere, so it is checked every time
+		if (float(entry.widget.getProperty(CabbageIdentifierIds::update)) != 0.0f)
+			CabbageWidgetData::setProperty(entry.widget, CabbageIdentifierIds::update, 0);
 	}
+
+	applyWidgetUpdates();
 }
 
-//================================================================================
-void CabbagePluginProcessor::addXYAutomator(CabbageXYPad* xyPad, ValueTree wData) {
-	int indexOfAutomator = -1;
+//==============================================================================
+// Applies the updates sent by cabbageSet since the last call. The queue only keeps
+// the last update for each widget and identifier, so a widget animated at k-rate is
+// only touched once per GUI update.
+//==============================================================================
+void CabbagePluginProcessor::applyWidgetUpdates()
+{
+	CSOUND* cs = getCsound()->GetCsound();
+
+	//name ids are handed out again by each new instance
+	if (cs != widgetUpdateCsound)
+	{
+		widgetUpdateCsound = cs;
+		widgetUpdates = WidgetUpdateQueue::find(cs);
+		widgetUpdateNames.clearQuick();
+	}
+
+	WidgetUpdateQueue* queue = widgetUpdates;
+
+	if (queue == nullptr)
+		return;
+
+	queue->readAll([this, queue](const WidgetUpdateQueue::Update& update)
+	{
+		applyWidgetUpdate(update, *queue);
+	});
+}
+
+const CabbagePluginProcessor::WidgetUpdateName& CabbagePluginProcessor::getWidgetUpdateName(WidgetUpdateQueue& queue, int nameId)
+{
+	while (widgetUpdateNames.size() <= nameId)
+		widgetUpdateNames.add(WidgetUpdateName());
 
-	for (int i = 0; i < xyAutomators.size(); i++) {
-		if (xyPad->getName() == xyAutomators[i]->getName())
-			indexOfAutomator = i;
+	WidgetUpdateName& name = widgetUpdateNames.getReference(nameId);
+
+	if (name.resolved == false)
+	{
+		const String text(queue.getName(nameId));
+		name.resolved = true;
+
+		if (text.isEmpty())
+			return name;
+
+		name.identifier = text;
+
+		//widgets are found by their first channel, then by their identchannel
+		for (int i = 0; i < cabbageWidgets.getNumChildren() && name.widget.isValid() == false; i++)
+		{
+			const var channels = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::channel);
+
+			if ((channels.size() > 0 ? channels[0].toString() : channels.toString()) == text)
+				name.widget = cabbageWidgets.getChild(i);
+		}
+
+		for (int i = 0; i < cabbageWidgets.getNumChildren() && name.widget.isValid() == false; i++)
+			if (CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::identchannel) == text)
+				name.widget = cabbageWidgets.getChild(i);
 	}
 
-	if (indexOfAutomator == -1) {
-		XYPadAutomator* xyAuto;
-		CabbagePluginParameter* xParameter = getParameterForXYPad(xyPad->getName() + "_x");
-		CabbagePluginParameter* yParameter = getParameterForXYPad(xyPad->getName() + "_y");
-
-		if (xParameter && yParameter) {
-			xyAutomators.add(xyAuto = new XYPadAutomator(xyPad->getName(), xParameter, yParameter, this));
-			xyAuto->setXMin(CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::minx));
-			xyAuto->setYMin(CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::miny));
-			xyAuto->setXMax(CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::maxx));
-			xyAuto->setYMax(CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::maxy));
-			xyAuto->removeAllChangeListeners();
-			xyAuto->addChangeListener(xyPad);
+	return name;
+}
+
+//==============================================================================
+CabbagePluginProcessor::WidgetStatePublisher::WidgetStatePublisher(CabbagePluginProcessor& p) : owner(p)
+{
+	owner.cabbageWidgets.addListener(this);
+}
+
+CabbagePluginProcessor::WidgetStatePublisher::~WidgetStatePublisher()
+{
+	owner.cabbageWidgets.removeListener(this);
+}
+
+void CabbagePluginProcessor::WidgetStatePublisher::update()
+{
+	WidgetStateSnapshot* current = owner.getCsound() != nullptr ? WidgetStateSnapshot::find(owner.getCsound()->GetCsound()) : nullptr;
+
+	if (current == snapshot)
+		return;
+
+	snapshot = current;
+	entriesByWidget.clearQuick();
+
+	if (snapshot == nullptr)
+		return;
+
+	//a background compile lays the snapshot out from a copy of the widgets, which may since have changed
+	const std::vector<WidgetStateSnapshot::Entry>& entries = snapshot->getEntries();
+	entriesByWidget.resize(owner.cabbageWidgets.getNumChildren());
+
+	for (int i = 0; i < (int)entries.size(); i++)
+	{
+		if (isPositiveAndBelow(entries[i].widget, entriesByWidget.size()))
+		{
+			entriesByWidget.getReference(entries[i].widget).add(i);
+			publish(entries[i]);
 		}
 	}
-	else {
-		xyAutomators[indexOfAutomator]->removeAllChangeListeners();
-		xyAutomators[indexOfAutomator]->addChangeListener(xyPad);
+}
+
+void CabbagePluginProcessor::WidgetStatePublisher::valueTreePropertyChanged(ValueTree& tree, const Identifier& property)
+{
+	update();
+
+	const int widget = owner.cabbageWidgets.indexOf(tree);
+
+	if (snapshot == nullptr || isPositiveAndBelow(widget, entriesByWidget.size()) == false)
+		return;
+
+	const std::vector<WidgetStateSnapshot::Entry>& entries = snapshot->getEntries();
+	const String name = property.toString();
+
+	//a combobox's currenttext follows its value and text
+	for (int entry : entriesByWidget.getReference(widget))
+		if (name == entries[entry].identifier.c_str() || CabbageIdentifierIds::currenttext.toString() == entries[entry].identifier.c_str())
+			publish(entries[entry]);
+}
+
+void CabbagePluginProcessor::WidgetStatePublisher::publish(const WidgetStateSnapshot::Entry& entry)
+{
+	const var value = getWidgetStateValue(owner.cabbageWidgets.getChild(entry.widget), Identifier(entry.identifier.c_str()));
+
+	if (entry.isString)
+		snapshot->setString(entry.valueIndex, value.toString().toUTF8());
+	else if (value.isDouble() || value.isInt() || value.isInt64() || value.isBool())
+		snapshot->setNumber(entry.valueIndex, MYFLT(double(value)));
+}
+
+//==============================================================================
+//sets the same properties, in the same form, as the equivalent identchannel message
+void CabbagePluginProcessor::applyWidgetUpdate(const WidgetUpdateQueue::Update& update, WidgetUpdateQueue& queue)
+{
+	ValueTree widget = getWidgetUpdateName(queue, update.widget).widget;
+
+	if (widget.isValid() == false)
+		return;
+
+	const Identifier identifier = getWidgetUpdateName(queue, update.property).identifier;
+	const MYFLT* values = update.values;
+
+	switch (update.type)
+	{
+	case WidgetUpdateQueue::number:
+		CabbageWidgetData::setNumProp(widget, identifier, values[0]);
+		break;
+
+	case WidgetUpdateQueue::position:
+		CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::left, values[0]);
+		CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::top, values[1]);
+		break;
+
+	case WidgetUpdateQueue::size:
+		CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::width, values[0]);
+		CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::height, values[1]);
+		break;
+
+	case WidgetUpdateQueue::bounds:
+		CabbageWidgetData::setBounds(widget, Rectangle<int>(int(values[0]), int(values[1]), int(values[2]), int(values[3])));
+		break;
+
+	case WidgetUpdateQueue::rotate:
+		CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::rotate, values[0]);
+		CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::pivotx, values[1]);
+		CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::pivoty, values[2]);
+		break;
+
+	case WidgetUpdateQueue::colour:
+	{
+		Identifier colourIdentifier = identifier;
+		const String typeOfWidget = CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::type);
+
+		//see CabbageWidgetData::setColourByNumber()
+		if (identifier == Identifier("colour:0"))
+			colourIdentifier = CabbageIdentifierIds::colour;
+		else if (identifier == Identifier("colour:1") || identifier == CabbageIdentifierIds::colour)
+			colourIdentifier = typeOfWidget.contains("checkbox") || typeOfWidget.contains("button") ? CabbageIdentifierIds::oncolour
+																									: CabbageIdentifierIds::colour;
+		else if (identifier == Identifier("fontcolour:0"))
+			colourIdentifier = CabbageIdentifierIds::fontcolour;
+		else if (identifier == Identifier("fontcolour:1"))
+			colourIdentifier = CabbageIdentifierIds::onfontcolour;
+
+		const Colour colour = Colour::fromRGBA(uint8(jlimit(0, 255, int(values[0]))), uint8(jlimit(0, 255, int(values[1]))),
+											   uint8(jlimit(0, 255, int(values[2]))), uint8(jlimit(0, 255, int(values[3]))));
+		CabbageWidgetData::setProperty(widget, colourIdentifier, colour.toString());
+		break;
+	}
+
+	default:
+		return;
 	}
+
+	widgetNotificationCount++;
 }
 
+void CabbagePluginProcessor::triggerCsoundEvents() {
+	if (!getCsound())
+		return;
+
+	//the cells were parsed when they were set, so a step only has to send them
+	for (auto* matrix : matrixEventSequencers) {
+		const int position = int(matrix->stepChannel->getValue());
+
+		if (position == matrix->position)
+			continue;
+
+		matrix->position = position;
+
+		if (!isPositiveAndBelow(position, matrix->vertical ? matrix->numRows : matrix->numColumns))
+			continue;
+
+		const int numEvents = matrix->vertical ? matrix->numColumns : matrix->numRows;
+
+		for (int i = 0; i < numEvents; i++) {
+			const MatrixEventSequencer::Event& event = matrix->vertical ? matrix->getEvent(i, position)
+																		: matrix->getEvent(position, i);
+
+			if (event.type != 0)
+				getCsound()->ScoreEvent(event.type, event.pFields, event.numPFields);
+			else if (event.text.getSize() > 0)
+				getCsound()->InputMessage(static_cast<const char*>(event.text.getData()));
+		}
+	}
+}
+
+void CabbagePluginProcessor::notifyParameterOfChannelValue(CabbagePluginParameter* parameter, MYFLT value) {
+	if (automationMode != 1 || parameter == nullptr)
+		return;
+
+	parameter->beginChangeGesture();
+	parameter->setValueNotifyingHost(parameter->getNormalisableRange().convertTo0to1(value));
+	parameter->endChangeGesture();
+}
+
+//================================================================================
+void CabbagePluginProcessor::addXYAutomator(ValueTree wData) {
+	const String name = CabbageWidgetData::getStringProp(wData, CabbageIdentifierIds::name);
+	const var channels = CabbageWidgetData::getProperty(wData, CabbageIdentifierIds::channel);
+
+	if (channels.size() < 2)
+		return;
+
+	XYPadAutomator* xyAuto = nullptr;
+
+	for (auto* automator : xyAutomators) {
+		if (automator->getName() == name)
+			xyAuto = automator;
+	}
+
+	if (xyAuto == nullptr) {
+		const ScopedLock sl(getCallbackLock());
+		xyAuto = xyAutomators.add(new XYPadAutomator(name));
+	}
+
+	//the channels and ranges may have changed if the csd was recompiled
+	xyAuto->setChannels(getControlChannel(channels[0].toString()), getControlChannel(channels[1].toString()),
+		{ CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::minx), CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::maxx) },
+		{ CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::miny), CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::maxy) });
+}
+
+
+void CabbagePluginProcessor::stopRemovedXYAutomators() {
+	for (auto* xyAuto : xyAutomators) {
+		bool padExists = false;
+
+		for (int i = 0; i < cabbageWidgets.getNumChildren() && !padExists; i++) {
+			const ValueTree widget = cabbageWidgets.getChild(i);
+			padExists = CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::type) == CabbageWidgetTypes::xypad
+				&& CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::name) == xyAuto->getName();
+		}
+
+		if (!padExists)
+			xyAuto->stop();
+	}
+}
 
 void CabbagePluginProcessor::enableXYAutomator(String name, bool enable, Line<float> dragLine) {
 
 	for (XYPadAutomator* xyAuto : xyAutomators) {
 		if (name == xyAuto->getName()) {
-			if (enable == true) {
-				xyAuto->setDragLine(dragLine);
-				xyAuto->setXValue(dragLine.getEndX());
-				xyAuto->setYValue(dragLine.getEndY());
-				xyAuto->setXValueIncrement((dragLine.getEndX() - dragLine.getStartX()) * .05);
-				xyAuto->setYValueIncrement((dragLine.getEndY() - dragLine.getStartY()) * .05);
-				xyAuto->setRepaintBackground(true);
-				xyAuto->setIsPluginEditorOpen(getActiveEditor() != nullptr ? true : false);
-				xyAuto->startTimer(20);
-			}
+			if (enable == true)
+				xyAuto->start(dragLine);
 			else
-				xyAuto->stopTimer();
+				xyAuto->stop();
 		}
 	}
 }
 
-//======================================================================================================
-CabbagePluginParameter* CabbagePluginProcessor::getParameterForXYPad(String name) {
-	for (auto param : getCabbageParameters()) {
-		if (CabbagePluginParameter * cabbageParam = dynamic_cast<CabbagePluginParameter*> (param)) {
-			DBG(cabbageParam->getWidgetName());
-			if (name == cabbageParam->getWidgetName())
-				return dynamic_cast<CabbagePluginParameter*> (cabbageParam);
-		}
+void CabbagePluginProcessor::performAutomation() {
+	if (xyAutomators.isEmpty() || !getCsound())
+		return;
+
+	const double secondsPerKCycle = getCsound()->GetKsmps() / getCsound()->GetSr();
+
+	for (auto* xyAuto : xyAutomators)
+		xyAuto->process(secondsPerKCycle);
+}
+
+//==============================================================================
+void CabbagePluginProcessor::XYPadAutomator::setChannels(ControlChannel* x, ControlChannel* y, Range<float> xValueRange, Range<float> yValueRange) {
+	const SpinLock::ScopedLockType sl(lock);
+	xChannel = x;
+	yChannel = y;
+	xRange = xValueRange;
+	yRange = yValueRange;
+}
+
+void CabbagePluginProcessor::XYPadAutomator::start(const Line<float>& dragLine) {
+	const SpinLock::ScopedLockType sl(lock);
+	//the pad's y runs down the screen, its channel runs up
+	x = xRange.clipValue(dragLine.getEndX());
+	y = yRange.clipValue(yRange.getStart() + yRange.getEnd() - dragLine.getEndY());
+	xVelocity = (dragLine.getEndX() - dragLine.getStartX()) * 2.5;
+	yVelocity = (dragLine.getStartY() - dragLine.getEndY()) * 2.5;
+	isRunning = true;
+}
+
+void CabbagePluginProcessor::XYPadAutomator::stop() {
+	const SpinLock::ScopedLockType sl(lock);
+	isRunning = false;
+}
+
+void CabbagePluginProcessor::XYPadAutomator::process(double secondsPerKCycle) {
+	const GenericScopedTryLock<SpinLock> sl(lock);
+
+	if (!sl.isLocked() || !isRunning || xChannel == nullptr || yChannel == nullptr)
+		return;
+
+	x = bounce(x + xVelocity * secondsPerKCycle, xRange, xVelocity);
+	y = bounce(y + yVelocity * secondsPerKCycle, yRange, yVelocity);
+	xChannel->setValue(x);
+	yChannel->setValue(y);
+}
+
+//reflects a value that has gone past either end of the range back inside it, turning it around
+double CabbagePluginProcessor::XYPadAutomator::bounce(double value, Range<float> range, double& velocity) {
+	if (value < range.getStart()) {
+		value = 2.0 * range.getStart() - value;
+		velocity = -velocity;
 	}
+	else if (value > range.getEnd()) {
+		value = 2.0 * range.getEnd() - value;
+		velocity = -velocity;
+	}
+
+	//in case a single step is longer than the range
+	return jlimit((double)range.getStart(), (double)range.getEnd(), value);
+}
 
-	return nullptr;
+//======================================================================================================
+CabbagePluginParameter* CabbagePluginProcessor::getParameterForXYPad(String name) {
+	return getParameterForWidgetName(name);
 }
 
 //==============================================================================
@@ -1388,10 +1764,18 @@ void CabbagePluginProcessor::setCabbageParameter(String channel, float value) {
 	getCsound()->SetChannel(channel.toUTF8().getAddress(), value);
 }
 
+void CabbagePluginProcessor::setCabbageParameter(ControlChannel* channel, float value, bool ramp) {
+	if (!getCsound())
+		return;
+
+	postParameterChange(channel, value, ramp);
+}
+
 void CabbagePluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
 	bool csoundRecompiled = false;
 	samplesInBlock = samplesPerBlock;
+	allocateCrossfadeBuffers(samplesPerBlock);
 #if !Cabbage_IDE_Build && !Cabbage_Lite
 	if (this->getBusesLayout().getMainOutputChannelSet() == AudioChannelSet::mono())
 		hostRequestedMono = true;
@@ -67,7 +67,7 @@ public:
 
 	CabbagePluginProcessor (File inputFile, AudioChannelSet ins, AudioChannelSet outs);
     CabbagePluginProcessor (File inputFile, AudioChannelSet ins, AudioChannelSet outs, AudioChannelSet sidechain);
-	void createCsound(File inputFile, bool shouldCreateParameters = true);
+	void createCsound(File inputFile, bool shouldCreateParameters = true, bool compileInBackground = false);
     ~CabbagePluginProcessor();
 
     ValueTree cabbageWidgets;
@@ -75,7 +75,7 @@ public:
     void triggerCsoundEvents() override;
     void setWidthHeight();
     bool addImportFiles (StringArray& lineFromCsd);
-    void parseCsdFile (StringArray& linesFromCsd);
+    void parseCsdFile (StringArray& linesFromCsd, ValueTree widgets);
     // use this instead of AudioProcessor::addParameter
     void addCabbageParameter(std::unique_ptr<CabbagePluginParameter> parameter);
     void createCabbageParameters();
@@ -92,12 +92,13 @@ public:
     void expandMacroText (String &line, ValueTree wData);
 	void prepareToPlay(double sampleRate, int samplesPerBlock) override;
 	void setCabbageParameter(String channel, float value);
+	void setCabbageParameter(ControlChannel* channel, float value, bool ramp);
     CabbagePluginParameter* getParameterForXYPad (String name);
     //==============================================================================
     AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
     //===== XYPad methods =========
-    void addXYAutomator (CabbageXYPad* xyPad, ValueTree wData);
+    void addXYAutomator (ValueTree wData);
     void enableXYAutomator (String name, bool enable, Line<float> dragLine);
     //==============================================================================
     void getStateInformation (MemoryBlock& destData) override;
@@ -128,6 +129,21 @@ public:
     
     // use this instead of AudioProcessor::getParameters
     const OwnedArray<CabbagePluginParameter>& getCabbageParameters() const { return parameters; }
+    //hashed lookups, return nullptr if no parameter has been added for the channel or widget
+    CabbagePluginParameter* getParameterForChannel (const String& channel) const;
+    CabbagePluginParameter* getParameterForWidgetName (const String& widgetName) const;
+
+    //number of widget property changes getChannelDataFromCsound() has made so far
+    int64 getNumWidgetNotifications() const { return widgetNotificationCount; }
+
+    //how long the last createCsound() spent in each stage, in milliseconds. A compile
+    //in the background only counts the time taken to start it
+    struct LoadTimings
+    {
+        double parse = 0, compile = 0, parameters = 0;
+    };
+
+    const LoadTimings& getLoadTimings() const { return loadTimings; }
     
 private:
     controlChannelInfo_s* csoundChanList;
@@ -138,14 +154,121 @@ private:
     NamedValueSet macroText;
     var macroNames;
     var macroStrings;
-    bool xyAutosCreated = false;
+
+    //bounces an xypad's ball along the line it was right-dragged over, moving it once per
+    //k-cycle on the audio thread and writing the x and y channels directly. The pad only
+    //shows where the ball has got to, through getChannelDataFromCsound(), so the motion
+    //carries on at the same speed whatever the message thread is doing
+    class XYPadAutomator
+    {
+    public:
+        explicit XYPadAutomator (const String& padName) : name (padName) {}
+
+        const String& getName() const   { return name; }
+
+        //message thread
+        void setChannels (ControlChannel* x, ControlChannel* y, Range<float> xValueRange, Range<float> yValueRange);
+        //starts from the end of the line, covering its length every 0.4 seconds like the old 20ms
+        //timer did. The line is in the pad's values, with y running down the pad as it does on screen
+        void start (const Line<float>& dragLine);
+        void stop();
+
+        //audio thread, once for each k-cycle
+        void process (double secondsPerKCycle);
+
+    private:
+        static double bounce (double value, Range<float> range, double& velocity);
+
+        const String name;
+        //held briefly by the message thread, the audio thread skips a k-cycle rather than wait
+        SpinLock lock;
+        ControlChannel* xChannel = nullptr;
+        ControlChannel* yChannel = nullptr;
+        Range<float> xRange, yRange;
+        bool isRunning = false;
+        //channel values, and how far they move each second
+        double x = 0, y = 0, xVelocity = 0, yVelocity = 0;
+    };
+
+    //added under the callback lock, and never removed while the processor is running
     OwnedArray<XYPadAutomator> xyAutomators;
+    //stops the automators whose pads went away when the csd was recompiled
+    void stopRemovedXYAutomators();
+    void performAutomation() override;
+    void csoundInstanceSwapped (ValueTree cabbageData) override;
+    void previousCsoundInstanceDeleted() override;
 	int samplingRate = 44100;
     int samplesInBlock = 64;
 	int screenWidth, screenHeight;
 	bool isUnityPlugin = false;
     int automationMode = 0;
     OwnedArray<CabbagePluginParameter> parameters;
+    HashMap<String, CabbagePluginParameter*> parametersByChannel, parametersByWidgetName;
+
+    //what getChannelDataFromCsound() needs to poll for each widget, rebuilt whenever
+    //the widgets or parameters change
+    struct ChannelPollEntry
+    {
+        enum Type { none, numericValue, stringValue, xyValue, rangeValue };
+        Type type = none;
+        ValueTree widget;
+        ControlChannel* channels[2] = { nullptr, nullptr };
+        MYFLT lastValues[2] = { 0, 0 };
+        String stringChannel, lastString, identChannel;
+        CabbagePluginParameter* parameters[2] = { nullptr, nullptr };
+    };
+
+    Array<ChannelPollEntry> channelPollPlan;
+    bool channelPollPlanIsStale = true;
+    void buildChannelPollPlan();
+    //sends a polled channel value to its host parameter when automationMode is on
+    void notifyParameterOfChannelValue (CabbagePluginParameter* parameter, MYFLT value);
+
+    //updates sent by the cabbageSet opcodes, applied in one go by getChannelDataFromCsound().
+    //The queue's name ids are resolved to widgets and identifiers the first time they turn up
+    struct WidgetUpdateName
+    {
+        bool resolved = false;
+        ValueTree widget;
+        Identifier identifier;
+    };
+
+    Array<WidgetUpdateName> widgetUpdateNames;
+    CSOUND* widgetUpdateCsound = nullptr;
+    WidgetUpdateQueue* widgetUpdates = nullptr;
+    void applyWidgetUpdates();
+    const WidgetUpdateName& getWidgetUpdateName (WidgetUpdateQueue& queue, int nameId);
+    void applyWidgetUpdate (const WidgetUpdateQueue::Update& update, WidgetUpdateQueue& queue);
+
+    //keeps the current instance's WidgetStateSnapshot up to date with the widgets, so that
+    //cabbageGet sees every change as soon as it is made on the message thread
+    class WidgetStatePublisher : public ValueTree::Listener
+    {
+    public:
+        explicit WidgetStatePublisher (CabbagePluginProcessor& p);
+        ~WidgetStatePublisher();
+
+        //publishes everything again if the instance has changed since the last call
+        void update();
+
+        void valueTreePropertyChanged (ValueTree& tree, const Identifier& property) override;
+        void valueTreeChildAdded (ValueTree&, ValueTree&) override {}
+        void valueTreeChildRemoved (ValueTree&, ValueTree&, int) override {}
+        void valueTreeChildOrderChanged (ValueTree&, int, int) override {}
+        void valueTreeParentChanged (ValueTree&) override {}
+
+    private:
+        void publish (const WidgetStateSnapshot::Entry& entry);
+
+        CabbagePluginProcessor& owner;
+        WidgetStateSnapshot* snapshot = nullptr;
+        //indices of the snapshot's entries, by the position of their widget in cabbageWidgets
+        Array<Array<int>> entriesByWidget;
+    };
+
+    WidgetStatePublisher widgetStatePublisher { *this };
+    int64 widgetNotificationCount = 0;
+    LoadTimings loadTimings;
 
 };
 
@@ -235,6 +358,7 @@ public:
     const NormalisableRange<float>& getNormalisableRange() const { return parameter->getNormalisableRange(); }
     
     const String getChannel() const { return parameter->getChannel(); }
+    bool getAutomationRamp() const { return parameter->automationRamp; }
     const String getWidgetName() { return widgetName; }
     bool getIsAutomatable() const { return isAutomatable; }
     
@@ -248,7 +372,7 @@ private:
         void setValue(float newValue) override
         {
             currentValue = isCombo ? juce::roundToInt(range.convertFrom0to1 (newValue)) : range.convertFrom0to1 (newValue);
-            processor->setCabbageParameter(channel, currentValue);
+            processor->setCabbageParameter(controlChannel, currentValue, automationRamp);
         }
         
         String getText(float normalizedValue, int length) const override
@@ -317,8 +441,10 @@ private:
         postfix(postfixToUse),
         currentValue(def),
         isCombo(isCombo),
+        automationRamp(CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::automationramp) == 1),
         owner(owner),
-        processor(proc)
+        processor(proc),
+        controlChannel(proc->getControlChannel(channelToUse))
         {
             
         }
@@ -328,9 +454,12 @@ private:
         const String postfix { };
         float currentValue;
         bool isCombo = false;
+        //glide to each new value over a fixed 20ms, for automation sent once per block
+        const bool automationRamp;
         
         CabbagePluginParameter& owner;
         CabbagePluginProcessor* processor;
+        CsoundPluginProcessor::ControlChannel* controlChannel;
         
         mutable bool showingAffixes = true;
         
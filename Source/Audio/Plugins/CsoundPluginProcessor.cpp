@@ -43,6 +43,7 @@ CsoundPluginProcessor::CsoundPluginProcessor (File csdFile, const AudioChannelSe
     numCsoundInputChannels = getBus(true, 0)->getNumberOfChannels();
     CabbageUtilities::debug("Constructor - Requested input channels:", numCsoundInputChannels);
 #endif
+    consoleThread->addTimeSliceClient (&consoleReader);
 }
 
 //==============================================================================
@@ -70,10 +71,14 @@ CsoundPluginProcessor::CsoundPluginProcessor(File csdFile, const AudioChannelSet
 	matchingNumberOfIOChannels = false;
 	supportsSidechain = true;
     numSideChainChannels = getBus(true, 1)->getNumberOfChannels();
+    consoleThread->addTimeSliceClient (&consoleReader);
 }
 
 CsoundPluginProcessor::~CsoundPluginProcessor()
 {
+	consoleThread->removeTimeSliceClient (&consoleReader);
+	discardPendingCsoundInstance();
+	cancelPendingUpdate();
 	resetCsound();
 }
 
@@ -87,6 +92,9 @@ void CsoundPluginProcessor::resetCsound()
 	if (csound)
 	{
 #if !defined(Cabbage_Lite)
+		resolveControlChannels (nullptr);
+		const ScopedLock sl (consoleLock);
+		consoleCsound = nullptr;
 		csound = nullptr;
 #endif
 		csoundParams = nullptr;
@@ -98,49 +106,117 @@ void CsoundPluginProcessor::resetCsound()
 //==============================================================================
 bool CsoundPluginProcessor::setupAndCompileCsound(File currentCsdFile, File filePath, int sr, bool isMono, bool debugMode)
 {
-    
+    //a synchronous compile replaces anything still being compiled in the background
+    discardPendingCsoundInstance();
+
     csdFile = currentCsdFile;
-    
-    StringArray csdLines;
-    csdLines.addLines(csdFile.loadFileAsString());
-    for (auto line : csdLines)
+    csdFilePath = filePath;
+
+    CsoundInstance instance;
+    prepareCsoundInstance (instance, csdFile, csdFilePath, sr, isMono, debugMode);
+
+    if (instance.opcodeDir.isNotEmpty())
+        csoundSetOpcodedir (instance.opcodeDir.toUTF8().getAddress());
+
+    compileCsoundInstance (instance);
+
+    if (isMono && supportsSidechain)
+        getBus(true, 1)->setNumberOfChannels(1);
+
+    //any cached channel pointers belong to the old instance
+    resolveControlChannels (nullptr);
+    midiInputEvents.ensureStorageAllocated(maxMidiInputEvents);
+    installCsoundInstance (instance);
+
     {
-        ValueTree temp("temp");
-        CabbageWidgetData::setWidgetState(temp, line, 0);
+        //the console thread may still be reading the old instance's messages
+        const ScopedLock sl (consoleLock);
+        instance.csound = nullptr;
+    }
 
-        if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
-        {
-            if(CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::opcodedir).isNotEmpty()) {
-                const String opcodeDir = csdFile.getParentDirectory().getChildFile(
-                        CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::opcodedir)).getFullPathName();
-                csoundSetOpcodedir(opcodeDir.toUTF8().getAddress());
-            }
-            if (CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::latency) == -1) {
-                preferredLatency = -1;
-            }
+    previousCsoundInstanceDeleted();
+
+    if (csdCompiledWithoutError())
+    {
+        resolveControlChannels (csound->GetCsound());
+        registerHostDataChannels();
+    }
+    else
+        CabbageUtilities::debug("Csound could not compile your file?");
+
+    return csdCompiledWithoutError();
+
+}
+
+bool CsoundPluginProcessor::canRecompileCsoundInBackground (File csdFile)
+{
+    const ValueTree form = CabbagePreprocessedCsd::get(csdFile)->getForm();
+    return ! form.isValid() || CabbageWidgetData::getStringProp(form, CabbageIdentifierIds::opcodedir).isEmpty();
+}
+
+void CsoundPluginProcessor::prepareCsoundInstance (CsoundInstance& instance, File currentCsdFile, File filePath, int sr, bool isMono, bool debugMode)
+{
+    instance.csdFile = currentCsdFile;
+    instance.filePath = filePath;
+    instance.sampleRate = sr;
+    instance.isMono = isMono;
+    instance.debugMode = debugMode;
+    instance.supportsSidechain = supportsSidechain;
+    instance.internalState = getInternalState();
+    instance.preferredLatency = preferredLatency;
+    instance.numSideChainChannels = numSideChainChannels;
+    instance.matchingNumberOfIOChannels = matchingNumberOfIOChannels;
+
+    //the file is only read and scanned once, however many times it gets compiled
+    const ValueTree form = CabbagePreprocessedCsd::get(currentCsdFile)->getForm();
+
+    if (form.isValid())
+    {
+        if(CabbageWidgetData::getStringProp(form, CabbageIdentifierIds::opcodedir).isNotEmpty()) {
+            instance.opcodeDir = currentCsdFile.getParentDirectory().getChildFile(
+                    CabbageWidgetData::getStringProp(form, CabbageIdentifierIds::opcodedir)).getFullPathName();
+        }
+        if (CabbageWidgetData::getNumProp(form, CabbageIdentifierIds::latency) == -1) {
+            instance.preferredLatency = -1;
         }
     }
-    
-    CabbageUtilities::debug(csdFile.getFullPathName());
-    
+
     // the host should respect the default inputs and outs, which are determined by the
     // nhcnls and nchnls_i variables in Csound. But the host is king. If it requested a different
     // config, we must adhere to it.
-    numCsoundOutputChannels = getBus(false, 0)->getNumberOfChannels();
-    CabbageUtilities::debug("SetupAndCompile - Requested output channels:", numCsoundOutputChannels);
+    instance.numOutputChannels = getBus(false, 0)->getNumberOfChannels();
+    CabbageUtilities::debug("SetupAndCompile - Requested output channels:", instance.numOutputChannels);
 #if ! JucePlugin_IsSynth && ! JucePlugin_IsSynth
     const int inputs = getBus(true, 0)->getNumberOfChannels();
-    numCsoundInputChannels = inputs + numSideChainChannels;
-    CabbageUtilities::debug("SetupAndCompile - Requested input channels:", numCsoundInputChannels);
+    instance.numInputChannels = inputs + instance.numSideChainChannels;
+    CabbageUtilities::debug("SetupAndCompile - Requested input channels:", instance.numInputChannels);
 #endif
+}
+
+void CsoundPluginProcessor::compileCsoundInstance (CsoundInstance& instance)
+{
+    const File currentCsdFile (instance.csdFile);
+    CabbagePreprocessedCsd::Ptr csd = CabbagePreprocessedCsd::get(currentCsdFile);
+
+    CabbageUtilities::debug(currentCsdFile.getFullPathName());
+
     //int test = csound->SetGlobalEnv("OPCODE6DIR64", );
     CabbageUtilities::debug("Env var set");
     //csoundSetOpcodedir("/Library/Frameworks/CsoundLib64.framework/Versions/6.0/Resources/Opcodes64");
     //Logger::writeToLog(String::formatted("Resetting csound ...\ncsound = 0x%p", csound.get()));
-	csound.reset (new Csound());
+	instance.csound.reset (new Csound());
+	Csound* csound = instance.csound.get();
     
-	csdFilePath = filePath;
-	csdFilePath.setAsCurrentWorkingDirectory();
+	//the working directory is process-wide and the running instance may still be opening files
+	//relative to it, so a background compile searches the csd's directory until it is swapped in
+	if (instance.compiledInBackground)
+	{
+		for (auto* searchPath : { "SSDIR", "SADIR", "MFDIR", "INCDIR" })
+			csound->SetOption ((String ("--env:") + searchPath + "+=" + instance.filePath.getFullPathName()).toUTF8().getAddress());
+	}
+	else
+		instance.filePath.setAsCurrentWorkingDirectory();
+
 	csound->SetHostImplementedMIDIIO(true);
 	csound->SetHostImplementedAudioIO(1, 0);
 	csound->SetHostData(this);
@@ -149,13 +225,26 @@ bool CsoundPluginProcessor::setupAndCompileCsound(File currentCsdFile, File file
     csnd::plugin<FileToStr>((csnd::Csound*) csound->GetCsound(), "fileToStr.i", "S", "S", csnd::thread::i);
 
     csnd::plugin<ChannelStateSave>((csnd::Csound*) csound->GetCsound(), "channelStateSave.i", "i", "S", csnd::thread::i);
-    csnd::plugin<ChannelStateSave>((csnd::Csound*) csound->GetCsound(), "channelStateSave.k", "k", "S", csnd::thread::k);
+    csnd::plugin<ChannelStateSaveAsync>((csnd::Csound*) csound->GetCsound(), "channelStateSave.k", "k", "S", csnd::thread::ik);
 
     csnd::plugin<ChannelStateRecall>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.i", "i", "S", csnd::thread::i);
-    csnd::plugin<ChannelStateRecall>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.k", "k", "SO", csnd::thread::k);
-    csnd::plugin<ChannelStateRecall>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.k", "k", "SS[]", csnd::thread::k);
+    csnd::plugin<ChannelStateRecallAsync>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.k", "k", "SO", csnd::thread::ik);
+    csnd::plugin<ChannelStateRecallAsync>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.k", "k", "SS[]", csnd::thread::ik);
 
     
+    csnd::plugin<TableChangedInit>((csnd::Csound*) csound->GetCsound(), "tableChanged.i", "", "ioj", csnd::thread::i);
+    csnd::plugin<TableChanged>((csnd::Csound*) csound->GetCsound(), "tableChanged.k", "", "kOJ", csnd::thread::ik);
+
+    csnd::plugin<CabbageSetWidgetInit>((csnd::Csound*) csound->GetCsound(), "cabbageSet.i", "", "SSiooo", csnd::thread::i);
+    csnd::plugin<CabbageSetWidget>((csnd::Csound*) csound->GetCsound(), "cabbageSet.k", "", "kSSkOOO", csnd::thread::ik);
+    csnd::plugin<CabbageGetWidgetNumber>((csnd::Csound*) csound->GetCsound(), "cabbageGet.i", "i", "SS", csnd::thread::i);
+    csnd::plugin<CabbageGetWidgetNumber>((csnd::Csound*) csound->GetCsound(), "cabbageGet.k", "k", "SS", csnd::thread::ik);
+    csnd::plugin<CabbageGetWidgetString>((csnd::Csound*) csound->GetCsound(), "cabbageGet.S", "S", "SS", csnd::thread::ik);
+
+    //the opcodes above only look these up, so they have to exist before the orchestra runs
+    TableChangeQueue::create (csound->GetCsound());
+    WidgetUpdateQueue::create (csound->GetCsound());
+
     csnd::plugin<StrToArray>((csnd::Csound*) csound->GetCsound(), "strToArray.ii", "S[]", "SS", csnd::thread::i);
     csnd::plugin<StrRemove>((csnd::Csound*) csound->GetCsound(), "strRemove.ii", "S", "SSo", csnd::thread::i);
 
@@ -195,8 +284,8 @@ bool CsoundPluginProcessor::setupAndCompileCsound(File currentCsdFile, File file
 	csound->SetExternalMidiReadCallback(ReadMidiData);
 	csound->SetExternalMidiOutOpenCallback(OpenMidiOutputDevice);
 	csound->SetExternalMidiWriteCallback(WriteMidiData);
-	csoundParams = nullptr;
-	csoundParams.reset (new CSOUND_PARAMS());
+	instance.params.reset (new CSOUND_PARAMS());
+	CSOUND_PARAMS* csoundParams = instance.params.get();
 
 	csoundParams->displays = 0;
 
@@ -209,9 +298,9 @@ bool CsoundPluginProcessor::setupAndCompileCsound(File currentCsdFile, File file
 	csound->SetOption((char*)"-d");
 	csound->SetOption((char*)"-b0");
     
-    addMacros(csdFile.loadFileAsString());
+    addMacros(csound, *csd);
 
-	if (debugMode)
+	if (instance.debugMode)
 	{
 		csoundDebuggerInit(csound->GetCsound());
 		csoundSetBreakpointCallback(csound->GetCsound(), breakpointCallback, (void*)this);
@@ -220,63 +309,83 @@ bool CsoundPluginProcessor::setupAndCompileCsound(File currentCsdFile, File file
 	}
 
 	
-    if(isMono)
+    if(instance.isMono)
     {
         //this mode is for logic and cubase
-        numCsoundOutputChannels = 1;
-        numCsoundInputChannels = 1 + (numSideChainChannels > 0 ? 1 : 0);
-        csoundParams->nchnls_override = numCsoundOutputChannels;
-        csoundParams->nchnls_i_override = numCsoundInputChannels;
-        if (supportsSidechain)
-        {
-            getBus(true, 1)->setNumberOfChannels(1);
-            numSideChainChannels = 1;
-        }
+        instance.numOutputChannels = 1;
+        instance.numInputChannels = 1 + (instance.numSideChainChannels > 0 ? 1 : 0);
+        csoundParams->nchnls_override = instance.numOutputChannels;
+        csoundParams->nchnls_i_override = instance.numInputChannels;
+        if (instance.supportsSidechain)
+            instance.numSideChainChannels = 1;
     }
     else
     {
-        csoundParams->nchnls_override = numCsoundOutputChannels;
-        csoundParams->nchnls_i_override = numCsoundInputChannels;
+        csoundParams->nchnls_override = instance.numOutputChannels;
+        csoundParams->nchnls_i_override = instance.numInputChannels;
     }
     
     // Update the matchingNumberOfIOChannels flag so the MacOS auval tool doesn't crash when validating
     // different I/O channel configurations.
     if (csoundParams->nchnls_i_override != csoundParams->nchnls_override)
     {
-        matchingNumberOfIOChannels = false;
+        instance.matchingNumberOfIOChannels = false;
     }
-	
+    
 #ifdef CabbagePro
-	const int requestedSampleRate = CabbageUtilities::getHeaderInfo(Encrypt::decode(csdFile), "sr");
-	const int requestedKsmpsRate = CabbageUtilities::getHeaderInfo(Encrypt::decode(csdFile), "ksmps");
+    const int requestedSampleRate = CabbageUtilities::getHeaderInfo(Encrypt::decode(currentCsdFile), "sr");
+    const int requestedKsmpsRate = CabbageUtilities::getHeaderInfo(Encrypt::decode(currentCsdFile), "ksmps");
 #else
-	const int requestedKsmpsRate = CabbageUtilities::getHeaderInfo(csdFile.loadFileAsString(), "ksmps");
-	const int requestedSampleRate = CabbageUtilities::getHeaderInfo(csdFile.loadFileAsString(), "sr");
+    const int requestedKsmpsRate = csd->getHeaderInfo("ksmps");
+    const int requestedSampleRate = csd->getHeaderInfo("sr");
 #endif
-	
-	if (requestedKsmpsRate == -1)
-		csoundParams->ksmps_override = 32;
+    
+    if (requestedKsmpsRate == -1)
+        csoundParams->ksmps_override = 32;
 
-	csoundParams->sample_rate_override = requestedSampleRate>0 ? requestedSampleRate : sr;
+    csoundParams->sample_rate_override = requestedSampleRate>0 ? requestedSampleRate : instance.sampleRate;
 
-    if(preferredLatency == -1)
+    if(instance.preferredLatency == -1)
         csoundParams->ksmps_override = 1;
 
-	csound->SetParams(csoundParams.get());
+    csound->SetParams(csoundParams);
     
-    if (csdFile.loadFileAsString().contains("<Csound") || csdFile.loadFileAsString().contains("</Csound"))
+    if (csd->hasCsoundTags())
     {
-        compileCsdFile(csdFile);
+        instance.compileResult = csound->Compile (const_cast<char*> (currentCsdFile.getFullPathName().toUTF8().getAddress()));
     }
     else
 	{
 #ifdef CabbagePro
-		compileCsdString(Encrypt::decode(csdFile));
+		instance.compileResult = csound->CompileCsdText (const_cast<char*> (Encrypt::decode(currentCsdFile).toUTF8().getAddress()));
 		csound->Start();
 #endif
 }
 
 
+	if (instance.compileResult == 0)
+	{
+        const String version = String("Cabbage version:")+ProjectInfo::versionString+String("\n");
+        csound->Message(version.toRawUTF8());
+    }
+}
+
+void CsoundPluginProcessor::installCsoundInstance (CsoundInstance& instance)
+{
+	std::swap (csound, instance.csound);
+	consoleCsound = csound.get();
+	std::swap (csoundParams, instance.params);
+	std::swap (csCompileResult, instance.compileResult);
+	std::swap (numCsoundInputChannels, instance.numInputChannels);
+	std::swap (numCsoundOutputChannels, instance.numOutputChannels);
+	std::swap (numSideChainChannels, instance.numSideChainChannels);
+	std::swap (matchingNumberOfIOChannels, instance.matchingNumberOfIOChannels);
+	std::swap (preferredLatency, instance.preferredLatency);
+
+	//MIDI left over from the previous instance's last k-cycle is dropped
+	midiInputEvents.clearQuick();
+	midiInputReadPosition = 0;
+
 	if (csdCompiledWithoutError())
 	{
 		csdKsmps = csound->GetKsmps();
@@ -284,15 +393,200 @@ bool CsoundPluginProcessor::setupAndCompileCsound(File currentCsdFile, File file
 		CSspin = csound->GetSpin();
 		cs_scale = csound->Get0dBFS();
 		csndIndex = csound->GetKsmps();
-        const String version = String("Cabbage version:")+ProjectInfo::versionString+String("\n");
-        csound->Message(version.toRawUTF8());
+	}
+}
 
-    }
+void CsoundPluginProcessor::registerHostDataChannels()
+{
+	if (hostDataChannels.isEmpty())
+	{
+		for (auto channelName : { CabbageIdentifierIds::hostbpm, CabbageIdentifierIds::timeinseconds,
+								  CabbageIdentifierIds::isplaying, CabbageIdentifierIds::isrecording,
+								  CabbageIdentifierIds::hostppqpos, CabbageIdentifierIds::timeinsamples,
+								  CabbageIdentifierIds::timeSigDenom, CabbageIdentifierIds::timeSigNum })
+			hostDataChannels.add (getControlChannel (channelName));
+
+#if Cabbage_Performance_Monitor
+		dspLoadChannel = getControlChannel (CabbageIdentifierIds::dspload);
+		dspOverrunsChannel = getControlChannel (CabbageIdentifierIds::dspoverruns);
+#endif
+	}
+}
+
+//==============================================================================
+bool CsoundPluginProcessor::recompileCsoundInBackground (File currentCsdFile, File filePath, int sr, ValueTree cabbageData)
+{
+	if (isRecompilingCsound() || ! canRecompileCsoundInBackground (currentCsdFile))
+		return false;
+
+	if (compileThread == nullptr)
+		compileThread.reset (new CsoundCompileThread (*this));
+	else
+		compileThread->waitForThreadToExit (-1);
+
+	csdFile = currentCsdFile;
+	csdFilePath = filePath;
+	compilingInstance.reset (new CsoundInstance());
+	prepareCsoundInstance (*compilingInstance, csdFile, csdFilePath, sr, hostRequestedMono, false);
+	compilingInstance->compiledInBackground = true;
+	pendingCabbageData = cabbageData;
+	readyToSwapTicks = 0;
+	midiInputEvents.ensureStorageAllocated(maxMidiInputEvents);
+
+	instanceSwapState = compiling;
+	compileThread->startThread();
+	return true;
+}
+
+bool CsoundPluginProcessor::isRecompilingCsound() const
+{
+	return instanceSwapState.load() != idle;
+}
+
+//runs on the compile thread, with only what the message thread gathered in compilingInstance.
+//The new instance isn't performed here, its first k-cycle runs once it has been swapped in
+void CsoundPluginProcessor::compilePendingCsoundInstance()
+{
+	std::unique_ptr<CsoundInstance> instance (std::move (compilingInstance));
+	compileCsoundInstance (*instance);
+
+	if (instance->compileResult == 0)
+		initCsoundInstanceChannels (instance->csound.get(), pendingCabbageData, instance->internalState,
+		                            instance->filePath, instance->preferredLatency, false);
+
+	const bool compiled = instance->compileResult == 0;
+
+	//the audio thread switches the channels over to these when it swaps the instance in
+	if (compiled)
+		resolvePendingControlChannels (instance->csound->GetCsound());
+
+	pendingInstance = std::move (instance);
+	instanceSwapState = compiled ? readyToSwap : failed;
+
+	if (! compiled)
+		triggerAsyncUpdate();
+}
+
+//called on the message thread once the audio thread has swapped instances, or the compile failed
+void CsoundPluginProcessor::handlePendingCsoundInstance()
+{
+	const int state = instanceSwapState.load();
+
+	if (state != swapped && state != failed)
+		return;
+
+	compileThread->waitForThreadToExit (-1);
+
+	if (state == swapped)
+	{
+		//left alone while the old instance was performing
+		csdFilePath.setAsCurrentWorkingDirectory();
+		registerHostDataChannels();
+
+		if (isZeroLatency())
+			setLatencySamples(0);
+		else
+			setLatencySamples(preferredLatency > 0 ? preferredLatency : csdKsmps);
+	}
 	else
+	{
 		CabbageUtilities::debug("Csound could not compile your file?");
 
-    return csdCompiledWithoutError();
+		if (pendingInstance->csound != nullptr)
+			forwardCsoundMessages (*pendingInstance->csound);
+	}
+
+	//the audio thread has finished with the old instance, or never saw the failed one
+	resolvePendingControlChannels (nullptr);
+
+	{
+		const ScopedLock sl (consoleLock);
+		pendingInstance = nullptr;
+	}
+
+	const ValueTree cabbageData (pendingCabbageData);
+	pendingCabbageData = ValueTree();
+	instanceSwapState = idle;
+
+	if (state == swapped)
+	{
+		previousCsoundInstanceDeleted();
+		csoundInstanceSwapped (cabbageData);
+	}
+}
+
+void CsoundPluginProcessor::installPendingCsoundInstance()
+{
+	installCsoundInstance (*pendingInstance);
+	liveChannelBinding.store (1 - liveChannelBinding.load(), std::memory_order_release);
+	instanceSwapState = swapped;
+}
 
+void CsoundPluginProcessor::forwardCsoundMessages (Csound& instanceCsound)
+{
+	while (instanceCsound.GetMessageCnt() > 0)
+	{
+		const int type = instanceCsound.GetFirstMessageAttr() & CSOUNDMSG_TYPE_MASK;
+		const int severity = type == CSOUNDMSG_ERROR ? CabbageConsoleLog::error
+		                     : type == CSOUNDMSG_WARNING ? CabbageConsoleLog::warning
+		                     : CabbageConsoleLog::message;
+		const String message (String::fromUTF8 (instanceCsound.GetFirstMessage()));
+		instanceCsound.PopFirstMessage();
+
+		//the console thread may be adding lines from the running instance
+		const ScopedLock sl (consoleLock);
+		consoleLog.addText (message, severity, Time::currentTimeMillis());
+		Logger::writeToLog (message.trimCharactersAtEnd ("\n\r"));
+	}
+}
+
+void CsoundPluginProcessor::swapPendingCsoundInstanceIfStalled()
+{
+	if (instanceSwapState.load() != readyToSwap)
+	{
+		readyToSwapTicks = 0;
+		return;
+	}
+
+	//give the audio callback a couple of ticks to pick it up first
+	if (++readyToSwapTicks < 2)
+		return;
+
+	{
+		const ScopedLock sl (getCallbackLock());
+
+		if (instanceSwapState.load() == readyToSwap)
+			installPendingCsoundInstance();
+	}
+
+	handlePendingCsoundInstance();
+}
+
+//only call this when the audio callback isn't running
+void CsoundPluginProcessor::discardPendingCsoundInstance()
+{
+	if (compileThread != nullptr)
+		compileThread->waitForThreadToExit (-1);
+
+	resolvePendingControlChannels (nullptr);
+
+	{
+		const ScopedLock sl (consoleLock);
+		pendingInstance = nullptr;
+	}
+
+	pendingCabbageData = ValueTree();
+	instanceSwapState = idle;
+}
+
+void CsoundPluginProcessor::allocateCrossfadeBuffers (int samplesPerBlock)
+{
+	const int numChannels = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+	if (isUsingDoublePrecision())
+		crossfadeBufferDouble.setSize (numChannels, samplesPerBlock);
+	else
+		crossfadeBufferFloat.setSize (numChannels, samplesPerBlock);
 }
 
 
@@ -322,12 +616,84 @@ void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
         Logger::writeToLog("csound not compiled");
         return;
     }
-    
-    getCsound()->CreateGlobalVariable("cabbageData", sizeof(CabbagePersistentData*));
-    CabbagePersistentData** pd = (CabbagePersistentData**)getCsound()->QueryGlobalVariable("cabbageData");
+
+    initCsoundInstanceChannels (csound.get(), cabbageData, getInternalState(), csdFilePath, preferredLatency, true);
+
+    Logger::writeToLog("initAllCsoundChannels (ValueTree cabbageData) - done");
+}
+
+//==============================================================================
+static const Identifier widgetStateIdentifiers[] = { CabbageIdentifierIds::value, CabbageIdentifierIds::valuex, CabbageIdentifierIds::valuey,
+                                                     CabbageIdentifierIds::minvalue, CabbageIdentifierIds::maxvalue, CabbageIdentifierIds::left,
+                                                     CabbageIdentifierIds::top, CabbageIdentifierIds::width, CabbageIdentifierIds::height,
+                                                     CabbageIdentifierIds::visible, CabbageIdentifierIds::active, CabbageIdentifierIds::alpha,
+                                                     CabbageIdentifierIds::text, CabbageIdentifierIds::file, CabbageIdentifierIds::currenttext };
+
+var CsoundPluginProcessor::getWidgetStateValue (ValueTree widget, const Identifier& identifier)
+{
+    if (identifier != CabbageIdentifierIds::currenttext)
+        return widget.getProperty (identifier);
+
+    if (CabbageWidgetData::getStringProp (widget, CabbageIdentifierIds::type) != CabbageWidgetTypes::combobox)
+        return var();
+
+    //string comboboxes hold the selected text, the rest the index of an item in text()
+    const var value = widget.getProperty (CabbageIdentifierIds::value);
+
+    if (value.isString())
+        return value;
+
+    const var items = widget.getProperty (CabbageIdentifierIds::text);
+    int index = int (value) - 1;
+
+    for (int i = 0; i < items.size(); i++)
+        if (! items[i].toString().contains ("subM:") && index-- == 0)
+            return items[i].toString();
+
+    return String();
+}
+
+//every widget with a channel or identchannel gets an entry for each of the properties above
+//that it has, as a number or as a string depending on what the property holds now
+void CsoundPluginProcessor::createWidgetStateSnapshot (CSOUND* csound, ValueTree cabbageData)
+{
+    WidgetStateSnapshot* snapshot = WidgetStateSnapshot::create (csound);
+    //an instance that already has one is laid out again from scratch
+    snapshot->clear();
+
+    for (int i = 0; i < cabbageData.getNumChildren(); i++)
+    {
+        const ValueTree widget = cabbageData.getChild (i);
+        const var channels = widget.getProperty (CabbageIdentifierIds::channel);
+        const String channel = channels.size() > 0 ? channels[0].toString() : channels.toString();
+        const String identChannel = CabbageWidgetData::getStringProp (widget, CabbageIdentifierIds::identchannel);
+
+        if (channel.isEmpty() && identChannel.isEmpty())
+            continue;
+
+        snapshot->addWidget (i, channel.toStdString(), identChannel.toStdString());
+
+        for (auto& identifier : widgetStateIdentifiers)
+        {
+            const var value = getWidgetStateValue (widget, identifier);
+
+            if (value.isString())
+                snapshot->addString (i, identifier.toString().toStdString(), value.toString().toUTF8());
+            else if (value.isDouble() || value.isInt() || value.isInt64() || value.isBool())
+                snapshot->addNumber (i, identifier.toString().toStdString(), MYFLT (double (value)));
+        }
+    }
+}
+
+//onMessageThread is false when the instance is being set up on the compile thread, while
+//another one is performing. Nothing process-wide or shared with the processor is touched then
+void CsoundPluginProcessor::initCsoundInstanceChannels (Csound* csound, ValueTree cabbageData, const String& internalState, File filePath, int& instanceLatency, bool onMessageThread)
+{
+    csound->CreateGlobalVariable("cabbageData", sizeof(CabbagePersistentData*));
+    CabbagePersistentData** pd = (CabbagePersistentData**)csound->QueryGlobalVariable("cabbageData");
     *pd = new CabbagePersistentData();
     auto pdClass = *pd;
-    pdClass->data = getInternalState().toStdString();
+    pdClass->setJson(internalState.toStdString(), false);
 
 
     for (int i = 0; i < cabbageData.getNumChildren(); i++)
@@ -336,7 +702,7 @@ void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
         if(typeOfWidget == CabbageWidgetTypes::form)
         {
             const int latency = CabbageWidgetData::getNumProp (cabbageData.getChild (i), CabbageIdentifierIds::latency);
-            preferredLatency = latency;
+            instanceLatency = latency;
         }
 
         if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::channeltype) == "string")
@@ -436,17 +802,19 @@ void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
 
     if (CabbageUtilities::getTargetPlatform() == CabbageUtilities::TargetPlatformTypes::Win32)
     {
-        csound->SetChannel ("CSD_PATH", csdFilePath.getParentDirectory().getFullPathName().replace ("\\", "\\\\").toUTF8().getAddress());
+        csound->SetChannel ("CSD_PATH", filePath.getParentDirectory().getFullPathName().replace ("\\", "\\\\").toUTF8().getAddress());
     }
     else
     {
-        csound->SetChannel ("CSD_PATH", csdFilePath.getFullPathName().toUTF8().getAddress());
+        csound->SetChannel ("CSD_PATH", filePath.getFullPathName().toUTF8().getAddress());
     }
 
     csound->SetStringChannel ("LAST_FILE_DROPPED", const_cast<char*> (""));
 
     csound->SetChannel ("IS_EDITOR_OPEN", 0.0);
-    csdFilePath.setAsCurrentWorkingDirectory();
+
+    if (onMessageThread)
+        filePath.setAsCurrentWorkingDirectory();
 
 
     time_t seconds_past_epoch = time(0);
@@ -476,7 +844,12 @@ void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
     }
 
     csound->SetChannel ("AUTOMATION", 0.0);
-#if !defined(Cabbage_IDE_Build)
+
+    //initAllCsoundChannels() is called again when state is restored, by which time the instance may be running
+    if (WidgetStateSnapshot::find (csound->GetCsound()) == nullptr)
+        createWidgetStateSnapshot (csound->GetCsound(), cabbageData);
+
+#if !defined(Cabbage_IDE_Build) && !defined(Cabbage_Benchmark)
     PluginHostType pluginType;
     if (pluginType.isFruityLoops())
         csound->SetChannel ("FLStudio", 1.0);
@@ -484,7 +857,9 @@ void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
         csound->SetChannel ("AbletonLive", 1.0);
     else if (pluginType.isLogic()){
         csound->SetChannel ("Logic", 1.0);
-        isLogic = true;
+        //the processor's first compile is synchronous, so this is set before any background one
+        if (onMessageThread)
+            isLogic = true;
     }
     else if (pluginType.isArdour())
         csound->SetChannel ("Ardour", 1.0);
@@ -520,7 +895,7 @@ void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
         csound->SetChannel("IS_A_PLUGIN", 1.0);
     }
 
-    if (getPlayHead() != 0 && getPlayHead()->getCurrentPosition (hostInfo))
+    if (onMessageThread && getPlayHead() != 0 && getPlayHead()->getCurrentPosition (hostInfo))
     {
         csound->SetChannel (CabbageIdentifierIds::hostbpm.toUTF8(), hostInfo.bpm);
         csound->SetChannel (CabbageIdentifierIds::timeinseconds.toUTF8(), hostInfo.timeInSeconds);
@@ -532,89 +907,96 @@ void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
         csound->SetChannel (CabbageIdentifierIds::timeSigNum.toUTF8(), hostInfo.timeSigNumerator);
     }
 
-
-    csound->PerformKsmps();
-
-    Logger::writeToLog("initAllCsoundChannels (ValueTree cabbageData) - done");
-
+    //a background instance runs its first k-cycle on the audio thread once it has been swapped
+    //in, so it never reaches the processor's MIDI and display callbacks before then
+    if (onMessageThread)
+        csound->PerformKsmps();
 }
 //==============================================================================
-void CsoundPluginProcessor::addMacros (String csdText)
+void CsoundPluginProcessor::addMacros (Csound* target, const CabbagePreprocessedCsd& csd)
 {
-    StringArray csdArray;
-    String macroName, macroText;
+    for (const auto& macro : csd.getMacroOptions())
+        target->SetOption (macro.toUTF8().getAddress());
+}
 
-    csdArray.addLines (csdText);
-//
-//    String width = "--macro:SCREEN_WIDTH="+String(screenWidth);
-//    String height = "--macro:SCREEN_HEIGHT="+String(screenHeight);
-//    csound->SetOption (width.toUTF8().getAddress());
-//    csound->SetOption (height.toUTF8().getAddress());
-    
-    auto inCabbageSection = false;
+//==============================================================================
+CsoundPluginProcessor::MatrixEventSequencer::MatrixEventSequencer (String csoundChannel, ControlChannel* positionChannel, int columns, int rows, bool isVertical)
+    : channel (csoundChannel), stepChannel (positionChannel), numColumns (jmax (0, columns)), numRows (jmax (0, rows)), vertical (isVertical)
+{
+    events.resize (numColumns * numRows);
+}
 
-    for (int i = 0; i < csdArray.size(); i++)
-    {
-        if (!inCabbageSection && csdArray[i].contains ("<Cabbage"))
-            inCabbageSection = true;
+void CsoundPluginProcessor::MatrixEventSequencer::swapEvent (int col, int row, Event& event)
+{
+    if (isPositiveAndBelow (col, numColumns) && isPositiveAndBelow (row, numRows))
+        std::swap (events.getReference (col * numRows + row), event);
+}
 
-        if (inCabbageSection)
-        {
-            if (csdArray[i].trim().substring (0, 7) == "#define")
-            {
-			    StringArray tokens;
-//              CabbageUtilities::debug(csdArray[i]);
-                tokens.addTokens (csdArray[i].replace ("#", "").trim() , " ");
-//              CabbageUtilities::debug(tokens[0]);
-                macroName = tokens[1];
-                tokens.remove (0);
-                tokens.remove (0);
-                macroText = "\"" + tokens.joinIntoString (" ").replace (" ", "\ ").replace("\"", "\\\"")+"\"";
-                macroText = tokens.joinIntoString(" ");
-                String fullMacro = "--omacro:" + macroName + "=" + macroText;// + "\"";
-                csound->SetOption (fullMacro.toUTF8().getAddress());
-            }
-        }
+void CsoundPluginProcessor::MatrixEventSequencer::parseEvent (const String& data, Event& event)
+{
+    const String line (data.trim());
+    event.type = 0;
+    event.numPFields = 0;
+    event.text.reset();
 
-        if (csdArray[i].contains ("</Cabbage>"))
-            i = csdArray.size();
-    }
+    if (line.isEmpty())
+        return;
 
-}
+    StringArray tokens;
+    tokens.addTokens (line.substring (1), " \t", "");
+    tokens.removeEmptyStrings();
 
-//==============================================================================
-void CsoundPluginProcessor::createMatrixEventSequencer(int rows, int cols, String channel)
-{
-    MatrixEventSequencer* matrix = new MatrixEventSequencer(channel);
+    bool isNumeric = String ("ifqae").containsChar (line[0]) && tokens.size() <= maxPFields
+                     && ! line.containsAnyOf ("\r\n;[]$");
 
-    for (int i = 0 ; i < cols ; i++)
+    for (int i = 0; i < tokens.size() && isNumeric; i++)
     {
-        matrix->events.add (new StringArray());
+        const char* token = tokens[i].toRawUTF8();
+        char* end = nullptr;
+        event.pFields[i] = (MYFLT) std::strtod (token, &end);
+        isNumeric = end != token && *end == 0;
+    }
 
-        for ( int y = 0 ; y < rows ; y++)
-        {
-            matrix->events[i]->add(" ");
-        }
+    if (isNumeric)
+    {
+        event.type = (char) line[0];
+        event.numPFields = tokens.size();
     }
+    else
+        event.text = MemoryBlock (line.toRawUTF8(), line.getNumBytesAsUTF8() + 1);
+}
 
-    matrixEventSequencers.add(matrix);
-	numMatrixEventSequencers = matrixEventSequencers.size();
+void CsoundPluginProcessor::createMatrixEventSequencer (int cols, int rows, String channel, bool isVertical)
+{
+    //the editor creates a sequencer each time it opens
+    std::unique_ptr<MatrixEventSequencer> matrix (new MatrixEventSequencer (channel, getControlChannel (channel), cols, rows, isVertical));
+    const ScopedLock sl (getCallbackLock());
 
+    for (int i = matrixEventSequencers.size(); --i >= 0;)
+        if (matrixEventSequencers[i]->channel == channel)
+            matrixEventSequencers.remove (i);
 
+    matrixEventSequencers.add (matrix.release());
 }
 
-void CsoundPluginProcessor::setMatrixEventSequencerCellData(int col, int row, String channel, String data)
+void CsoundPluginProcessor::setMatrixEventSequencerCellData (int col, int row, String channel, String data)
 {
-	if (numMatrixEventSequencers > 0)
-	{
-		for (int i = 0; i < matrixEventSequencers.size(); i++)
-		{
-			if (matrixEventSequencers[i]->channel == channel)
-			{
-				matrixEventSequencers[i]->setEventString(col, row, data);
-			}
-		}
-	}
+    //parsed before taking the lock, and swapped in, so the audio thread never waits for an
+    //allocation. The replaced cell is freed once the lock has been released
+    MatrixEventSequencer::Event event;
+    MatrixEventSequencer::parseEvent (data, event);
+
+    const ScopedLock sl (getCallbackLock());
+
+    //there is at most one sequencer on a channel
+    for (auto* matrix : matrixEventSequencers)
+    {
+        if (matrix->channel == channel)
+        {
+            matrix->swapEvent (col, row, event);
+            break;
+        }
+    }
 }
 
 //==============================================================================
@@ -676,35 +1058,247 @@ int CsoundPluginProcessor::checkTable (int tableNum)
     return  csound->TableLength (tableNum);
 }
 
-
 //==============================================================================
-const String CsoundPluginProcessor::getCsoundOutput()
+void CsoundPluginProcessor::addTableListener (int tableNumber, TableListener* listener)
 {
-    if (csound!=nullptr)
+    ObservedTable* table = getObservedTable (tableNumber);
+
+    if (table == nullptr)
     {
-        const int messageCnt = csound->GetMessageCnt();
-        csoundOutput = "";
+        table = observedTables.add (new ObservedTable());
+        table->tableNumber = tableNumber;
+        //listeners have just read the table themselves
+        table->values = getTableFloats (tableNumber);
+    }
+
+    table->listeners.addIfNotAlreadyThere (listener);
+}
 
-        if (messageCnt == 0)
-            return csoundOutput;
+void CsoundPluginProcessor::removeTableListener (TableListener* listener)
+{
+    for (int i = observedTables.size(); --i >= 0;)
+    {
+        observedTables[i]->listeners.removeFirstMatchingValue (listener);
 
-        while (csound->GetMessageCnt() > 0)
+        if (observedTables[i]->listeners.isEmpty())
+            observedTables.remove (i);
+    }
+}
+
+CsoundPluginProcessor::ObservedTable* CsoundPluginProcessor::getObservedTable (int tableNumber)
+{
+    for (auto* table : observedTables)
+        if (table->tableNumber == tableNumber)
+            return table;
+
+    return nullptr;
+}
+
+void CsoundPluginProcessor::previousCsoundInstanceDeleted()
+{
+    //a new instance can be given the same address as the one just deleted
+    observedCsound = nullptr;
+    observedTableChanges = nullptr;
+}
+
+void CsoundPluginProcessor::updateObservedTables()
+{
+    if (observedTables.isEmpty() || csound == nullptr || csCompileResult != OK)
+        return;
+
+    const Range<int> wholeTable (0, std::numeric_limits<int>::max());
+    CSOUND* cs = csound->GetCsound();
+
+    //a new instance starts out with all its tables polled again
+    if (cs != observedCsound)
+    {
+        observedCsound = cs;
+        observedTableChanges = TableChangeQueue::find (cs);
+
+        for (auto* table : observedTables)
+            table->reportedByOrchestra = false;
+    }
+
+    if (TableChangeQueue* queue = observedTableChanges)
+    {
+        const bool reportsLost = queue->readAll ([this] (const TableChangeQueue::Change& change)
         {
-            csoundOutput += csound->GetFirstMessage();
-            csound->PopFirstMessage();
+            if (ObservedTable* table = getObservedTable (change.tableNumber))
+            {
+                const Range<int> range (jmax (0, change.start), change.end < 0 ? std::numeric_limits<int>::max() : change.end);
+
+                if (table->reportedByOrchestra && ! table->reportedRange.isEmpty())
+                    table->reportedRange = table->reportedRange.getUnionWith (range);
+                else
+                    table->reportedRange = range;
+
+                table->reportedByOrchestra = true;
+            }
+        });
+
+        if (reportsLost)
+            for (auto* table : observedTables)
+                if (table->reportedByOrchestra)
+                    table->reportedRange = wholeTable;
+    }
+
+    for (auto* table : observedTables)
+    {
+        if (table->reportedByOrchestra)
+        {
+            if (! table->reportedRange.isEmpty())
+                checkObservedTable (*table, table->reportedRange);
+
+            table->reportedRange = Range<int>();
         }
+        else if (csound->TableLength (table->tableNumber) <= maxPolledTableSize)
+            checkObservedTable (*table, wholeTable);
+    }
+}
 
-        Logger::writeToLog (csoundOutput);
+void CsoundPluginProcessor::updateObservedTable (int tableNumber)
+{
+    if (csound == nullptr || csCompileResult != OK)
+        return;
+
+    if (ObservedTable* table = getObservedTable (tableNumber))
+        checkObservedTable (*table, Range<int> (0, std::numeric_limits<int>::max()));
+}
+
+void CsoundPluginProcessor::checkObservedTable (ObservedTable& table, Range<int> rangeToCheck)
+{
+    const int tableSize = csound->TableLength (table.tableNumber);
+
+    if (tableSize <= 0)
+        return;
+
+    const bool resized = tableSize != table.values.size();
+
+    if (resized)
+    {
+        table.values.resize (tableSize);
+        rangeToCheck = Range<int> (0, tableSize);
+    }
+
+    //only the reported span is read, straight from the table. TableCopyOut would copy all of it
+    //while holding Csound's API lock, stalling the audio thread on big tables. A value written
+    //while it is being read is reported again, and picked up on the next update
+    MYFLT* csoundValues = nullptr;
+
+    if (csoundGetTable (csound->GetCsound(), &csoundValues, table.tableNumber) != tableSize || csoundValues == nullptr)
+        return;
+
+    rangeToCheck = rangeToCheck.getIntersectionWith (Range<int> (0, tableSize));
+    float* const values = table.values.getRawDataPointer();
+    int firstChanged = rangeToCheck.getEnd(), lastChanged = rangeToCheck.getStart() - 1;
+
+    for (int i = rangeToCheck.getStart(); i < rangeToCheck.getEnd(); i++)
+    {
+        const float newValue = (float) csoundValues[i];
+
+        if (values[i] != newValue)
+        {
+            values[i] = newValue;
+            firstChanged = jmin (firstChanged, i);
+            lastChanged = i;
+        }
+    }
+
+    if (! resized && lastChanged < firstChanged)
+        return;
+
+    const Range<int> changedRange = resized ? Range<int> (0, tableSize) : Range<int> (firstChanged, lastChanged + 1);
+
+    for (int i = table.listeners.size(); --i >= 0;)
+        table.listeners[i]->tableChanged (table.tableNumber, table.values, changedRange);
+}
+
+
+//==============================================================================
+const String CsoundPluginProcessor::getCsoundOutput()
+{
+    if (csound != nullptr)
+    {
+        const String newOutput = consoleLog.getTextSince (consoleReadPosition);
 
         if (disableLogging == true)
             this->suspendProcessing (true);
 
-        return csoundOutput;
+        return newOutput;
     }
 
     return String();
 }
 
+bool CsoundPluginProcessor::readConsoleLines (CabbageConsoleLog& dest)
+{
+    const bool added = dest.addLinesFrom (consoleLog, consoleReadPosition);
+
+    if (csound != nullptr && disableLogging == true)
+        this->suspendProcessing (true);
+
+    return added;
+}
+
+//runs on the console thread. Messages are split into lines, and a line that
+//arrives in pieces is only added once it's complete
+int CsoundPluginProcessor::readCsoundMessages()
+{
+    //an instance the audio thread has swapped out is only deleted under this lock
+    const ScopedLock sl (consoleLock);
+    Csound* const cs = consoleCsound.load();
+
+    if (cs == nullptr)
+        return consoleReadInterval;
+
+    while (cs->GetMessageCnt() > 0)
+    {
+        const int type = cs->GetFirstMessageAttr() & CSOUNDMSG_TYPE_MASK;
+        const int severity = type == CSOUNDMSG_ERROR ? CabbageConsoleLog::error
+                             : type == CSOUNDMSG_WARNING ? CabbageConsoleLog::warning
+                             : CabbageConsoleLog::message;
+        const String message (String::fromUTF8 (cs->GetFirstMessage()));
+        cs->PopFirstMessage();
+
+        partialConsoleLineSeverity = jmax (partialConsoleLineSeverity, severity);
+
+        for (int start = 0;;)
+        {
+            const int end = message.indexOfChar (start, '\n');
+
+            if (end < 0)
+            {
+                partialConsoleLine += message.substring (start);
+                break;
+            }
+
+            addConsoleLine (partialConsoleLine + message.substring (start, end), partialConsoleLineSeverity);
+            partialConsoleLine.clear();
+            partialConsoleLineSeverity = severity;
+            start = end + 1;
+        }
+
+        if (partialConsoleLine.length() > CabbageConsoleLog::maxLineLength)
+        {
+            addConsoleLine (partialConsoleLine, partialConsoleLineSeverity);
+            partialConsoleLine.clear();
+        }
+
+        if (partialConsoleLine.isEmpty())
+            partialConsoleLineSeverity = CabbageConsoleLog::message;
+    }
+
+    return consoleReadInterval;
+}
+
+void CsoundPluginProcessor::addConsoleLine (const String& line, int severity)
+{
+    const String text (line.trimCharactersAtEnd ("\r"));
+
+    if (consoleLog.add (text, severity, Time::currentTimeMillis()))
+        Logger::writeToLog (text);
+}
+
 //==============================================================================
 const String CsoundPluginProcessor::getName() const
 {
@@ -761,11 +1355,19 @@ void CsoundPluginProcessor::changeProgramName (int index, const String& newName)
 //==============================================================================
 void CsoundPluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-#if !defined(Cabbage_IDE_Build)
+#if !defined(Cabbage_IDE_Build) && !defined(Cabbage_Benchmark)
     PluginHostType pluginType;
     if (pluginType.isCubase())
         hostIsCubase = true;
 #endif
+#if Cabbage_Performance_Monitor
+    performanceMonitor.reset();
+#endif
+    parameterEvents.reset();
+    channelMessages.resetStats();
+    droppedMidiInputEvents = 0;
+
+    allocateCrossfadeBuffers(samplesPerBlock);
     
 #if ! JucePlugin_IsSynth
     const int inputs = getBus(true, 0)->getNumberOfChannels();
@@ -800,10 +1402,10 @@ void CsoundPluginProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
             setupAndCompileCsound(csdFile, csdFilePath, samplingRate);
     }
 
-    if (preferredLatency == -1)
+    if (isZeroLatency())
         this->setLatencySamples(0);
     else
-	    this->setLatencySamples(preferredLatency == 0 ? csound->GetKsmps() : preferredLatency);
+	    this->setLatencySamples(preferredLatency > 0 ? preferredLatency : csound->GetKsmps());
 }
 
 void CsoundPluginProcessor::releaseResources()
@@ -838,7 +1440,7 @@ bool CsoundPluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
             return true;
 
 #else
-#if !defined(Cabbage_IDE_Build) && !defined(Cabbage_Lite)
+#if !defined(Cabbage_IDE_Build) && !defined(Cabbage_Lite) && !defined(Cabbage_Benchmark)
         if (PluginHostType().isReaper())
         {
             if(numSideChainChannels > 0)
@@ -882,7 +1484,7 @@ bool CsoundPluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 //    if(numSideChainChannels==0)
     if (mainInput.size() == 1 && mainOutput.size() == 1)
     {
-#if defined(Cabbage_IDE_Build)
+#if defined(Cabbage_IDE_Build) || defined(Cabbage_Benchmark)
         return true;
 #else
         if (PluginHostType().isReaper())
@@ -912,7 +1514,9 @@ void CsoundPluginProcessor::triggerCsoundEvents()
 
 void CsoundPluginProcessor::handleAsyncUpdate()
 {
+    handlePendingCsoundInstance();
     getChannelDataFromCsound();
+    updateObservedTables();
     sendChannelDataToCsound();
 }
 
@@ -926,22 +1530,96 @@ void CsoundPluginProcessor::sendHostDataToCsound()
             
             if (ph->getCurrentPosition (hostPlayHeadInfo))
             {
-                csound->SetChannel (CabbageIdentifierIds::hostbpm.toUTF8(), hostPlayHeadInfo.bpm);
-                csound->SetChannel (CabbageIdentifierIds::timeinseconds.toUTF8(), hostPlayHeadInfo.timeInSeconds);
-                csound->SetChannel (CabbageIdentifierIds::isplaying.toUTF8(), hostPlayHeadInfo.isPlaying);
-                csound->SetChannel (CabbageIdentifierIds::isrecording.toUTF8(), hostPlayHeadInfo.isRecording);
-                csound->SetChannel (CabbageIdentifierIds::hostppqpos.toUTF8(), hostPlayHeadInfo.ppqPosition);
-                csound->SetChannel (CabbageIdentifierIds::timeinsamples.toUTF8(), hostPlayHeadInfo.timeInSamples);
-                csound->SetChannel (CabbageIdentifierIds::timeSigDenom.toUTF8(), hostPlayHeadInfo.timeSigDenominator);
-                csound->SetChannel (CabbageIdentifierIds::timeSigNum.toUTF8(), hostPlayHeadInfo.timeSigNumerator);
+                //same order as the channels registered in setupAndCompileCsound()
+                hostDataChannels[0]->setValue (hostPlayHeadInfo.bpm);
+                hostDataChannels[1]->setValue (hostPlayHeadInfo.timeInSeconds);
+                hostDataChannels[2]->setValue (hostPlayHeadInfo.isPlaying);
+                hostDataChannels[3]->setValue (hostPlayHeadInfo.isRecording);
+                hostDataChannels[4]->setValue (hostPlayHeadInfo.ppqPosition);
+                hostDataChannels[5]->setValue ((MYFLT) hostPlayHeadInfo.timeInSamples);
+                hostDataChannels[6]->setValue (hostPlayHeadInfo.timeSigDenominator);
+                hostDataChannels[7]->setValue (hostPlayHeadInfo.timeSigNumerator);
             }
         }
 //    }
 }
 
+CsoundPluginProcessor::ControlChannel* CsoundPluginProcessor::getControlChannel (const String& channelName)
+{
+    if (controlChannelMap.contains (channelName))
+        return controlChannelMap[channelName];
+
+    const ScopedLock sl (channelBindingLock);
+    ControlChannel* channel = controlChannels.add (new ControlChannel (channelName, controlChannels.size(), liveChannelBinding));
+
+    for (int binding = 0; binding < 2; binding++)
+        channel->resolve (binding, channelBindingCsounds[binding]);
+
+    controlChannelMap.set (channelName, channel);
+
+    if (channel->id < CabbageMessageQueue::maxChannels)
+        channelsById[channel->id] = channel;
+
+    return channel;
+}
+
+void CsoundPluginProcessor::postChannelValue (ControlChannel* channel, float value)
+{
+    if (! channelMessages.postValue (channel->id, value))
+        channel->setValue (value);
+}
+
+void CsoundPluginProcessor::postParameterChange (ControlChannel* channel, float value, bool ramp)
+{
+    if (! parameterEvents.post (channel->id, value, blockStartSample.load (std::memory_order_relaxed), ramp))
+        postChannelValue (channel, value);
+}
+
+void CsoundPluginProcessor::resolveControlChannels (CSOUND* cs)
+{
+    resolveControlChannelBinding (liveChannelBinding.load(), cs);
+}
+
+void CsoundPluginProcessor::resolvePendingControlChannels (CSOUND* cs)
+{
+    resolveControlChannelBinding (1 - liveChannelBinding.load(), cs);
+}
+
+void CsoundPluginProcessor::resolveControlChannelBinding (int binding, CSOUND* cs)
+{
+    const ScopedLock sl (channelBindingLock);
+    channelBindingCsounds[binding] = cs;
+
+    for (auto* channel : controlChannels)
+        channel->resolve (binding, cs);
+}
+
 void CsoundPluginProcessor::performCsoundKsmps()
 {
-	result = csound->PerformKsmps();
+	//values posted by the editor and host since the last k-cycle
+	channelMessages.drain ([this] (int channelId, float value) { channelsById[channelId]->setValue (value); });
+	//host automation due in this k-cycle, and the next step of any ramps. Ramps take 20ms
+	parameterEvents.process (kCycleStartSample, csdKsmps, roundToInt (getSampleRate() * 0.02),
+	                         [this] (int channelId) { return channelsById[channelId]->getValue(); },
+	                         [this] (int channelId, float value) { channelsById[channelId]->setValue (value); });
+	performAutomation();
+
+#if Cabbage_Performance_Monitor
+	dspLoadChannel->setValue (performanceMonitor.getLoad());
+	dspOverrunsChannel->setValue (performanceMonitor.getNumOverruns());
+#endif
+
+	{
+		CABBAGE_PERFORMANCE_PROBE (performanceMonitor, performKsmps);
+		result = csound->PerformKsmps();
+	}
+
+	//anything Csound didn't read this k-cycle is kept for the next one
+	if (midiInputReadPosition >= midiInputEvents.size())
+		midiInputEvents.clearQuick();
+	else
+		midiInputEvents.removeRange(0, midiInputReadPosition);
+	midiInputReadPosition = 0;
 
 	if (result == 0)
 	{
@@ -955,8 +1633,14 @@ void CsoundPluginProcessor::performCsoundKsmps()
 			++guiCycles;
 
 		//trigger any Csound score event on each k-boundary
-		triggerCsoundEvents();
-		sendHostDataToCsound();
+		{
+			CABBAGE_PERFORMANCE_PROBE (performanceMonitor, csoundEvents);
+			triggerCsoundEvents();
+		}
+		{
+			CABBAGE_PERFORMANCE_PROBE (performanceMonitor, hostData);
+			sendHostDataToCsound();
+		}
 
 		disableLogging = false;
 	}
@@ -968,51 +1652,48 @@ void CsoundPluginProcessor::performCsoundKsmps()
 }
 
 template< typename Type >
-void CsoundPluginProcessor::processCsoundIOBuffers(int bufferType, Type*& buffer, int pos)
+void CsoundPluginProcessor::writeCsoundInputChannel(const Type* source, int channel, int numChannels, int startFrame, int numFrames)
 {
-	if (bufferType == BufferType::inputOutput)
+	MYFLT* destination = CSspin + startFrame * numChannels + channel;
+
+	if (source == nullptr)
 	{
-		Type*& current_sample = buffer;
-		MYFLT sample = *current_sample * cs_scale;
-		CSspin[pos] = sample;
-        //if we want 0 latency, we have to fill Csound spin buffer before we call performKsmps()
-        if (preferredLatency == -1)
-            performCsoundKsmps();
-		*current_sample = (CSspout[pos] / cs_scale);
-		++current_sample;
+		for (int i = 0; i < numFrames; i++)
+			destination[i * numChannels] = 0;
+		return;
 	}
-	else if (bufferType == BufferType::output)
+
+	const MYFLT scale = cs_scale;
+
+	//mono input is contiguous in spin, so let the compiler vectorise it
+	if (numChannels == 1)
 	{
-		Type*& current_sample = buffer;
-		*current_sample = (CSspout[pos] / cs_scale);
-		++current_sample;
+		for (int i = 0; i < numFrames; i++)
+			destination[i] = source[i] * scale;
 	}
-	else //input
+	else
 	{
-        if(buffer != nullptr)
-        {
-			Type*& current_sample = buffer;
-            MYFLT newSamp = *current_sample * cs_scale;
-            CSspin[pos] = newSamp;
-            current_sample++;
-        }
-        else
-            CSspin[pos] = 0;
+		for (int i = 0; i < numFrames; i++)
+			destination[i * numChannels] = source[i] * scale;
 	}
 }
 
 template< typename Type >
-void CsoundPluginProcessor::processCsoundIOSideChainBuffers(int bufferType, Type* buffer, int pos)
+void CsoundPluginProcessor::readCsoundOutputChannel(Type* destination, int channel, int numChannels, int startFrame, int numFrames)
 {
-    if (buffer != nullptr)
-    {
-        Type* current_sample = buffer;
-        MYFLT newSamp = *current_sample * cs_scale;
-        CSspin[pos] = newSamp;
-        current_sample++;
-    }
-    else
-        CSspin[pos] = 0;
+	const MYFLT* source = CSspout + startFrame * numChannels + channel;
+	const MYFLT scale = cs_scale;
+
+	if (numChannels == 1)
+	{
+		for (int i = 0; i < numFrames; i++)
+			destination[i] = Type (source[i] / scale);
+	}
+	else
+	{
+		for (int i = 0; i < numFrames; i++)
+			destination[i] = Type (source[i * numChannels] / scale);
+	}
 }
 
 void CsoundPluginProcessor::processBlock(AudioBuffer< float >& buffer, MidiBuffer& midiMessages)
@@ -1028,26 +1709,84 @@ void CsoundPluginProcessor::processBlock(AudioBuffer< double >& buffer, MidiBuff
 template< typename Type >
 void CsoundPluginProcessor::processSamples(AudioBuffer< Type >& buffer, MidiBuffer& midiMessages)
 {
+#if Cabbage_Performance_Monitor
+	const int64 blockStartTicks = Time::getHighResolutionTicks();
+#endif
 	ScopedNoDenormals noDenormals;
-	auto mainOutput = getBusBuffer(buffer, false, 0);
-#if !JucePlugin_IsSynth
-	auto mainInput = getBusBuffer(buffer, true, 0);
+	keyboardState.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
+
+	if (instanceSwapState.load() == readyToSwap)
+		swapCsoundInstance(buffer, midiMessages);
+	else
+		renderCsound(buffer, midiMessages);
+
+#if JucePlugin_ProducesMidiOutput
+
+	if (!midiOutputBuffer.isEmpty())
+	{
+		midiMessages.clear();
+		midiMessages.swapWith(midiOutputBuffer);
+	}
+	else
+		midiMessages.clear();
+
 #endif
-    
-    const Type** sideChainCubase = nullptr;
-    Type** sideChainBuffer = nullptr;
+	blockStartSample.store (blockStartSample.load (std::memory_order_relaxed) + buffer.getNumSamples(), std::memory_order_relaxed);
 
-	if (supportsSidechain)
+#if Cabbage_Performance_Monitor
+	performanceMonitor.addBlock(blockStartTicks, buffer.getNumSamples(), getSampleRate());
+#endif
+}
+
+//renders the outgoing instance into the buffer and the new one into a copy of the input, then
+//crossfades between them over the block. Without a large enough copy it just cuts over
+template< typename Type >
+void CsoundPluginProcessor::swapCsoundInstance(AudioBuffer< Type >& buffer, MidiBuffer& midiMessages)
+{
+	AudioBuffer< Type >& crossfadeBuffer = getCrossfadeBuffer(buffer);
+	const int numChannels = buffer.getNumChannels();
+	const int numSamples = buffer.getNumSamples();
+	const bool shouldCrossfade = csdCompiledWithoutError()
+		&& numChannels <= crossfadeBuffer.getNumChannels()
+		&& numSamples <= crossfadeBuffer.getNumSamples();
+
+	if (shouldCrossfade)
 	{
-        sideChainCubase = getBusBuffer(buffer, true, 1).getArrayOfReadPointers();
-		sideChainBuffer = getBusBuffer(buffer, true, 1).getArrayOfWritePointers();
-		numSideChainChannels = getBusBuffer(buffer, true, 1).getNumChannels();
+		for (int channel = 0; channel < numChannels; channel++)
+			crossfadeBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+
+		renderCsound(buffer, midiMessages);
 	}
 
-    Type** outputBuffer = mainOutput.getArrayOfWritePointers();
+	installPendingCsoundInstance();
+	triggerAsyncUpdate();
+
+	if (shouldCrossfade)
+	{
+		AudioBuffer< Type > newOutput(crossfadeBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+		renderCsound(newOutput, midiMessages);
+
+		buffer.applyGainRamp(0, numSamples, Type (1), Type (0));
+		for (int channel = 0; channel < numChannels; channel++)
+			buffer.addFromWithRamp(channel, 0, newOutput.getReadPointer(channel), numSamples, Type (0), Type (1));
+	}
+	else
+		renderCsound(buffer, midiMessages);
+}
+
+template< typename Type >
+void CsoundPluginProcessor::renderCsound(AudioBuffer< Type >& buffer, MidiBuffer& midiMessages)
+{
+	auto mainOutput = getBusBuffer(buffer, false, 0);
 #if !JucePlugin_IsSynth
-	Type** inputBuffer = mainInput.getArrayOfWritePointers();
+	auto mainInput = getBusBuffer(buffer, true, 0);
+	auto sideChainInput = supportsSidechain ? getBusBuffer(buffer, true, 1) : AudioBuffer< Type >();
+
+	if (supportsSidechain)
+		numSideChainChannels = sideChainInput.getNumChannels();
 #endif
+
+    Type** outputBuffer = mainOutput.getArrayOfWritePointers();
     const int numSamples = buffer.getNumSamples();
 
 	const int outputChannelCount = (numCsoundOutputChannels > getTotalNumOutputChannels() ? getTotalNumOutputChannels() : numCsoundOutputChannels);
@@ -1057,14 +1796,11 @@ void CsoundPluginProcessor::processSamples(AudioBuffer< Type >& buffer, MidiBuff
 	if (getTotalNumInputChannels() == 0)
 		buffer.clear();
 
-	keyboardState.processNextMidiBuffer(midiMessages, 0, numSamples, true);
-    
-    //events need to be added at the correct time...
-	//midiBuffer.addEvents(midiMessages, 0, numSamples, 0);
-    
-    int samplePos = 0;
-    MidiMessage message;
-    MidiBuffer::Iterator iter (midiMessages);
+	//MIDI events are handed to Csound in the k-cycle they fall in, stepping through the buffer only once
+	MidiBuffer::Iterator midiIterator(midiMessages);
+	const uint8* midiEventData = nullptr;
+	int midiEventSize = 0, midiEventPos = 0;
+	bool hasPendingMidiEvent = midiIterator.getNextEvent(midiEventData, midiEventSize, midiEventPos);
 
 	if (csdCompiledWithoutError())
 	{
@@ -1074,84 +1810,71 @@ void CsoundPluginProcessor::processSamples(AudioBuffer< Type >& buffer, MidiBuff
 			buffer.clear(channelsToClear, 0, buffer.getNumSamples());
 		}
 
-		for (int i = 0; i < numSamples; i++, ++csndIndex)
+#if !JucePlugin_IsSynth
+		//returns the host channel feeding a given Csound input channel, or nullptr for silence
+		auto getInputChannel = [&](int channel) -> const Type*
+		{
+			//if using Logic process inputs and outputs separately - otherwise its mono to stereo features break...
+			if (matchingNumberOfIOChannels && !isLogic)
+				return outputBuffer[channel];
+
+			if (supportsSidechain && channel >= numSideChainChannels)
+			{
+				const int sideChainChannel = channel - numSideChainChannels;
+				return sideChainChannel < sideChainInput.getNumChannels() ? sideChainInput.getReadPointer(sideChainChannel) : nullptr;
+			}
+
+			return channel < mainInput.getNumChannels() ? mainInput.getReadPointer(channel) : nullptr;
+		};
+
+		const int csoundInputChannels = (matchingNumberOfIOChannels && !isLogic) ? outputChannelCount : inputChannelCount;
+#endif
+
+		const int64 blockStart = blockStartSample.load (std::memory_order_relaxed);
+		const bool zeroLatency = isZeroLatency();
+
+		//walk the host buffer in runs that never cross a k-cycle boundary
+		for (int samplePos = 0; samplePos < numSamples;)
 		{
 			if (csndIndex == csdKsmps)
 			{
                 //don't call performKsmps here if we want 0 latency
-                if(preferredLatency != -1)
+                if(! zeroLatency)
+                {
+                    kCycleStartSample = blockStart + samplePos;
 				    performCsoundKsmps();
+                }
 				csndIndex = 0;
 			}
-            
-            while(iter.getNextEvent (message, samplePos))
+
+			const int numFrames = jmin(numSamples - samplePos, csdKsmps - csndIndex);
+
+            while (hasPendingMidiEvent && midiEventPos < samplePos + numFrames)
             {
-                //if current sample position matches time code for MIDI event, add it to buffer...
-                if(samplePos == i)
-                    midiBuffer.addEvent(message, samplePos);
+                addMidiInputEvent(midiEventData, midiEventSize);
+                hasPendingMidiEvent = midiIterator.getNextEvent(midiEventData, midiEventSize, midiEventPos);
             }
-            
-            //reset the iterator each time, so that we can step through the events again to see if they should be added
-            iter.setNextSamplePosition(0);
-	
+
 #if !JucePlugin_IsSynth
-            //if using Logic process inputs and outputs separately - otherwise its mono to stereo features break...
-			if (matchingNumberOfIOChannels && !isLogic)
-			{
-				pos = csndIndex * outputChannelCount;
-				for (int channel = 0; channel < outputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::inputOutput, outputBuffer[channel], pos);
-					pos++;
-				}
-			}
-			else if (!supportsSidechain)
+			for (int channel = 0; channel < csoundInputChannels; channel++)
 			{
-				pos = csndIndex * inputChannelCount;
-				for (int channel = 0; channel < inputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::input, inputBuffer[channel], pos);
-					pos++;
-				}
-
-				pos = csndIndex * outputChannelCount;
-				for (int channel = 0; channel < outputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::output, outputBuffer[channel], pos);
-					pos++;
-				}
+				const Type* source = getInputChannel(channel);
+				writeCsoundInputChannel(source != nullptr ? source + samplePos : nullptr, channel, csoundInputChannels, csndIndex, numFrames);
 			}
-			else {
-				//sidechain processing
-				pos = csndIndex * inputChannelCount;
-				for (int channel = 0; channel < inputChannelCount; channel++)
-				{
-					if(channel< numSideChainChannels)
-						processCsoundIOBuffers(BufferType::input, inputBuffer[channel], pos);
-                    else{
-                        if(hostIsCubase)
-                            processCsoundIOSideChainBuffers(BufferType::input, sideChainCubase[channel-numSideChainChannels], pos);
-                        else
-                            processCsoundIOBuffers(BufferType::input, sideChainBuffer[channel-numSideChainChannels], pos);
-                    }
-					pos++;
-				}
-
-				pos = csndIndex * outputChannelCount;
-				for (int channel = 0; channel < outputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::output, outputBuffer[channel], pos);
-					pos++;
-				}
-			}
-#else
-            pos = csndIndex * outputChannelCount;
-            for (int channel = 0; channel < outputChannelCount; channel++)
+#endif
+            //if we want 0 latency, we have to fill Csound spin buffer before we call performKsmps().
+            //With ksmps 1 every run is a whole k-cycle, so nothing is read before it is computed
+            if (zeroLatency && csndIndex + numFrames == csdKsmps)
             {
-                processCsoundIOBuffers(BufferType::output, outputBuffer[channel], pos);
-                pos++;
+                kCycleStartSample = blockStart + samplePos + numFrames - csdKsmps;
+                performCsoundKsmps();
             }
-#endif
+
+			for (int channel = 0; channel < outputChannelCount; channel++)
+				readCsoundOutputChannel(outputBuffer[channel] + samplePos, channel, outputChannelCount, csndIndex, numFrames);
+
+			csndIndex += numFrames;
+			samplePos += numFrames;
 		}
     }//if not compiled just mute output
     else
@@ -1161,18 +1884,6 @@ void CsoundPluginProcessor::processSamples(AudioBuffer< Type >& buffer, MidiBuff
             buffer.clear (channel, 0, buffer.getNumSamples());
         }
     }
-
-#if JucePlugin_ProducesMidiOutput
-
-	if (!midiOutputBuffer.isEmpty())
-	{
-		midiMessages.clear();
-		midiMessages.swapWith(midiOutputBuffer);
-	}
-	else
-		midiMessages.clear();
-
-#endif
 }
 
 //==============================================================================
@@ -1220,31 +1931,43 @@ void CsoundPluginProcessor::breakpointCallback (CSOUND* csound, debug_bkpt_info_
 //==============================================================================
 CsoundPluginProcessor::SignalDisplay* CsoundPluginProcessor::getSignalArray (String variableName, String displayType)
 {
-    for (int i = 0; i < signalArrays.size(); i++)
+    //newest first, a recompile with a larger display size adds a new display for the same caption
+    for (int i = signalArrays.size(); --i >= 0;)
     {
-        const String test = signalArrays[i]->caption;
-        if (signalArrays[i]->caption.isNotEmpty() && signalArrays[i]->caption.contains (variableName))
+        SignalDisplay* const display = signalArrays[i];
+
+        if (display->caption.isNotEmpty() && display->caption.contains (variableName))
         {
-            const String varName = signalArrays[i]->variableName;
             if (displayType.isEmpty()){
-                return signalArrays[i];
+                return display;
             }
 
-            else if (displayType == "waveform" && !signalArrays[i]->caption.contains ("fft")){
-                return signalArrays[i];
+            else if (displayType == "waveform" && !display->caption.contains ("fft")){
+                return display;
             }
 
-            else if (displayType == "lissajous" && !signalArrays[i]->caption.contains ("fft")){
-                return signalArrays[i];
+            else if (displayType == "lissajous" && !display->caption.contains ("fft")){
+                return display;
             }
 
-            else if (displayType != "waveform" && signalArrays[i]->caption.contains ("fft")){
-                return signalArrays[i];
+            else if (displayType != "waveform" && display->caption.contains ("fft")){
+                return display;
             }
         }
     }
 
-    return new SignalDisplay ("", -1, 0, 0, 0, 0);
+    return nullptr;
+}
+
+bool CsoundPluginProcessor::shouldUpdateSignalDisplay (String signalDisplayName)
+{
+    bool hasNewFrame = false;
+
+    for (int i = 0; i < signalArrays.size(); i++)
+        if (signalArrays[i]->variableName == signalDisplayName && signalArrays[i]->pullLatestFrame())
+            hasNewFrame = true;
+
+    return hasNewFrame;
 }
 //==============================================================================
 bool CsoundPluginProcessor::hasEditor() const
@@ -1281,7 +2004,7 @@ int CsoundPluginProcessor::OpenMidiInputDevice (CSOUND* csound, void** userData,
 //==============================================================================
 // Reads MIDI input data from host, gets called every time there is MIDI input to our plugin
 //==============================================================================
-int CsoundPluginProcessor::ReadMidiData (CSOUND* /*csound*/, void* userData,
+int CsoundPluginProcessor::ReadMidiData (CSOUND* csound, void* userData,
                                          unsigned char* mbuf, int nbytes)
 {
     CsoundPluginProcessor* midiData = static_cast<CsoundPluginProcessor*>(userData);
@@ -1292,41 +2015,51 @@ int CsoundPluginProcessor::ReadMidiData (CSOUND* /*csound*/, void* userData,
         return 0;
     }
 
+    //an instance being set up on the compile thread mustn't touch the live MIDI queue
+    if (midiData->csound == nullptr || midiData->csound->GetCsound() != csound)
+        return 0;
+
+    CABBAGE_PERFORMANCE_PROBE (midiData->performanceMonitor, midiInput);
     int cnt = 0;
 
-    
-    if (!midiData->midiBuffer.isEmpty() && cnt <= (nbytes - 3))
+    //only the events collected for the current k-cycle are waiting here
+    while (midiData->midiInputReadPosition < midiData->midiInputEvents.size())
     {
-        MidiMessage message (0xf4, 0, 0, 0);
-        MidiBuffer::Iterator i (midiData->midiBuffer);
-        int messageFrameRelativeTothisProcess;
+        const MidiInputEvent& event = midiData->midiInputEvents.getReference (midiData->midiInputReadPosition);
 
-        while (i.getNextEvent (message, messageFrameRelativeTothisProcess))
-        {
-            
-            const uint8* data = message.getRawData();
-            *mbuf++ = *data++;
+        if (cnt + event.size > nbytes)
+            break;
 
-            if(message.isChannelPressure() || message.isProgramChange())
-            {
-                *mbuf++ = *data++;
-                cnt += 2;
-            }
-            else
-            {
-                *mbuf++ = *data++;
-                *mbuf++ = *data++;
-                cnt  += 3;
-            }
-        }
+        for (int i = 0; i < event.size; i++)
+            *mbuf++ = event.data[i];
 
-        midiData->midiBuffer.clear();
-        
+        cnt += event.size;
+        midiData->midiInputReadPosition++;
     }
 
-    
     return cnt;
+}
+
+void CsoundPluginProcessor::addMidiInputEvent (const uint8* data, int numBytes)
+{
+    //Csound only parses short messages from this callback, so sysex is dropped
+    if (numBytes <= 0 || numBytes > 3 || data[0] == 0xf0)
+        return;
+
+    //never grow past the storage reserved up front, which would allocate on the audio thread
+    if (midiInputEvents.size() >= maxMidiInputEvents)
+    {
+        droppedMidiInputEvents.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
 
+    MidiInputEvent event;
+    event.size = numBytes;
+
+    for (int i = 0; i < numBytes; i++)
+        event.data[i] = data[i];
+
+    midiInputEvents.add (event);
 }
 
 //==============================================================================
@@ -1343,7 +2076,7 @@ int CsoundPluginProcessor::OpenMidiOutputDevice (CSOUND* csound, void** userData
 // Write MIDI data to plugin's MIDI output. Each time Csound outputs a midi message this
 // method should be called. Note: you must have -Q set in your CsOptions
 //==============================================================================
-int CsoundPluginProcessor::WriteMidiData (CSOUND* /*csound*/, void* _userData,
+int CsoundPluginProcessor::WriteMidiData (CSOUND* csound, void* _userData,
                                           const unsigned char* mbuf, int nbytes)
 {
     CsoundPluginProcessor* userData = static_cast<CsoundPluginProcessor*>(_userData);
@@ -1354,6 +2087,10 @@ int CsoundPluginProcessor::WriteMidiData (CSOUND* /*csound*/, void* _userData,
         return 0;
     }
 
+    if (userData->csound == nullptr || userData->csound->GetCsound() != csound)
+        return nbytes;
+
+    CABBAGE_PERFORMANCE_PROBE (userData->performanceMonitor, midiOutput);
     MidiMessage message (mbuf, nbytes, 0);
     userData->midiOutputBuffer.addEvent (message, 0);
     return nbytes;
@@ -1366,44 +2103,51 @@ int CsoundPluginProcessor::WriteMidiData (CSOUND* /*csound*/, void* _userData,
 void CsoundPluginProcessor::makeGraphCallback (CSOUND* csound, WINDAT* windat, const char* name)
 {
     CsoundPluginProcessor* ud = static_cast<CsoundPluginProcessor*>(csoundGetHostData (csound));
-    SignalDisplay* display = new SignalDisplay (String (windat->caption), (int)windat->windid, windat->oabsmax, windat->min, windat->max, windat->npts);
+    const String caption (windat->caption);
+
+    const int windid = (int) windat->windid;
 
-    bool addDisplay = true;
+    //windid is ours to set, it hands drawGraphCallback its display without a lookup
+    windat->windid = 0;
 
-    for (int i = 0; i < ud->signalArrays.size(); i++)
+    if (caption.contains("ftable"))
+        return;
+
+    for (int i = ud->signalArrays.size(); --i >= 0;)
     {
-        if (ud->signalArrays[i]->caption == windat->caption)
-            addDisplay  = false;
+        if (ud->signalArrays[i]->caption == caption && ud->signalArrays[i]->size >= windat->npts)
+        {
+            ud->signalArrays[i]->window = windat;
+            windat->windid = (uintptr_t) ud->signalArrays[i];
+            return;
+        }
     }
 
-    if (addDisplay && !String(windat->caption).contains("ftable"))
-    {
-        const String captionName = String(windat->caption).substring(String(windat->caption).indexOf("signal ")+7);
-        const int posColon = String(captionName).indexOf(":");
-        const int posComma = String(captionName).indexOf(",");
-        String variableName = "";
-        if(posComma != -1)
-            variableName = captionName.substring(0, posComma);
-        else
-            variableName = captionName.substring(0, posColon);
+    SignalDisplay* display = new SignalDisplay (caption, windid, windat->oabsmax, windat->min, windat->max, windat->npts);
 
-        display->variableName = variableName;
-        ud->signalArrays.add (display);
-        ud->updateSignalDisplay.set(variableName, false);
-    }
+    const String captionName = caption.substring(caption.indexOf("signal ")+7);
+    const int posColon = String(captionName).indexOf(":");
+    const int posComma = String(captionName).indexOf(",");
+    String variableName = "";
+    if(posComma != -1)
+        variableName = captionName.substring(0, posComma);
+    else
+        variableName = captionName.substring(0, posColon);
+
+    display->variableName = variableName;
+    display->window = windat;
+    ud->signalArrays.add (display);
+    windat->windid = (uintptr_t) display;
 }
 
 void CsoundPluginProcessor::drawGraphCallback (CSOUND* csound, WINDAT* windat)
 {
-    CsoundPluginProcessor* ud = static_cast<CsoundPluginProcessor*> (csoundGetHostData (csound));
-    Array<float, CriticalSection> tablePoints;
-    //only take all samples if dealing with fft, waveforms and lissajous curves can be drawn with less samples
-    tablePoints = Array<float, CriticalSection> (&windat->fdata[0], windat->npts);
-    ud->getSignalArray (windat->caption)->setPoints (tablePoints);
-    const String test = ud->getSignalArray (windat->caption)->variableName;
-    if(ud->getSignalArray (windat->caption)->variableName.isNotEmpty())
-        ud->updateSignalDisplay.set(ud->getSignalArray (windat->caption)->variableName, true);
-    
+    ignoreUnused (csound);
+
+    //a window whose display has been taken over keeps its windid, but no longer draws
+    if (SignalDisplay* display = reinterpret_cast<SignalDisplay*> (windat->windid))
+        if (display->window.load() == windat)
+            display->pushFrame (windat->fdata, windat->npts);
 }
 
 void CsoundPluginProcessor::killGraphCallback (CSOUND* csound, WINDAT* windat)
@@ -27,7 +27,11 @@
 #include <cwindow.h>
 #include "../../Opcodes/opcodes.hpp"
 #include "../../Utilities/CabbageUtilities.h"
+#include "../../Utilities/CabbagePreprocessedCsd.h"
+#include "../../Utilities/CabbageConsoleLog.h"
 #include "CabbageCsoundBreakpointData.h"
+#include "CabbageMessageSystem.h"
+#include "CabbagePerformanceMonitor.h"
 #ifdef CabbagePro
 #include "../../Utilities/encrypt.h"
 #endif
@@ -53,6 +57,17 @@ public:
 	//==============================================================================
 	//pass the path to the temp file, along with the path to the original csd file so we can set correct working dir
 	bool setupAndCompileCsound(File csdFile, File filePath, int sr = 44100, bool isMono = false, bool debugMode = false);
+	//compiles and initialises a new instance on a background thread while the current one keeps
+	//playing, then crossfades to it at the start of the next audio block. If the new instance
+	//fails to compile the current one is kept. Returns false if a recompile is already under way,
+	//or if the csd can't be compiled in the background
+	bool recompileCsoundInBackground(File csdFile, File filePath, int sr, ValueTree cabbageData);
+	//false for csds that set the process-wide opcode directory, which only a synchronous compile does
+	static bool canRecompileCsoundInBackground(File csdFile);
+	bool isRecompilingCsound() const;
+	//swaps a compiled instance in from the message thread when the audio callback isn't running
+	void swapPendingCsoundInstanceIfStalled();
+	void allocateCrossfadeBuffers(int samplesPerBlock);
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
@@ -69,16 +84,12 @@ public:
 
     virtual void processBlockBypassed (AudioBuffer< float > &buffer, MidiBuffer &midiMessages) override {}
 
-	enum BufferType {
-		inputOutput,
-		output,
-		input
-	};
-
+	//de/interleave a run of frames between a host channel and Csound's spin/spout buffers.
+	//startFrame is the frame offset within the current k-cycle
 	template< typename Type >
-	void processCsoundIOBuffers(int bufferType, Type*& buffer, int pos);
-    template< typename Type >
-    void processCsoundIOSideChainBuffers(int bufferType, Type* buffer, int pos);
+	void writeCsoundInputChannel(const Type* source, int channel, int numChannels, int startFrame, int numFrames);
+	template< typename Type >
+	void readCsoundOutputChannel(Type* destination, int channel, int numChannels, int startFrame, int numFrames);
 
 	int numSideChainChannels = 0;
     //==============================================================================
@@ -140,25 +151,50 @@ public:
     int checkTable (int tableNum);
     AudioPlayHead::CurrentPositionInfo hostInfo = {};
 
+    class ControlChannel;
+
+    //an eventsequencer's cells, parsed into score events as they are set, so that
+    //triggerCsoundEvents() only needs to send them when the step channel moves on.
+    //Sequencers and their cells only change while holding the callback lock
     class MatrixEventSequencer
     {
     public:
-        String channel = "";
-        OwnedArray<StringArray> events;
-        int position = 0;
-        void setEventString(int col, int row, String data)
+        enum { maxPFields = 32 };
+
+        struct Event
         {
-            events[col]->set(row, data);
-        }
+            //'i', 'f', 'q', 'a' or 'e', or 0 if the cell is empty
+            char type = 0;
+            int numPFields = 0;
+            MYFLT pFields[maxPFields] = {};
+            //cells that aren't a plain list of numbers, using named instruments or carry
+            //symbols for example, are sent to Csound as they were typed. Held as null
+            //terminated UTF-8, so that sending one doesn't touch a String
+            MemoryBlock text;
+        };
+
+        MatrixEventSequencer (String csoundChannel, ControlChannel* positionChannel, int columns, int rows, bool isVertical);
+
+        //swaps event into the cell, leaving the cell's old contents in event to be freed later
+        void swapEvent (int col, int row, Event& event);
+        const Event& getEvent (int col, int row) const     { return events.getReference (col * numRows + row); }
+
+        const String channel;
+        ControlChannel* const stepChannel;
+        const int numColumns, numRows;
+        //vertical sequencers step through rows, horizontal ones through columns
+        const bool vertical;
+        int position = 0;
 
-        explicit MatrixEventSequencer(String csoundChannel):channel(csoundChannel){}
-        ~MatrixEventSequencer(){ events.clear();}
+        static void parseEvent (const String& data, Event& event);
 
+    private:
+        Array<Event> events;
     };
 
-	int numMatrixEventSequencers = 0;
-    void createMatrixEventSequencer(int rows, int cols, String channel);
-    void setMatrixEventSequencerCellData(int row, int col, String channel, String data);
+    //replaces any sequencer already on the channel
+    void createMatrixEventSequencer (int cols, int rows, String channel, bool isVertical);
+    void setMatrixEventSequencerCellData (int col, int row, String channel, String data);
     //=============================================================================
     //Implement these to init, send and receive channel data to Csound. Typically used when
     //a component is updated and its value is sent to Csound, or when a Csound channel
@@ -167,12 +203,23 @@ public:
     //as is done in CabbagePluginprocessor.
     virtual void triggerCsoundEvents();
     virtual void sendChannelDataToCsound() {};
+    //audio thread, before each k-cycle, for channels that move by themselves
+    virtual void performAutomation() {};
     void sendHostDataToCsound();
     virtual void getChannelDataFromCsound() {};
     virtual void initAllCsoundChannels (ValueTree cabbageData);
+    //the value cabbageGet reads for a widget property. Comboboxes also have a currenttext
+    static var getWidgetStateValue (ValueTree widget, const Identifier& identifier);
     //=============================================================================
-    void addMacros (String csdText);
+    void addMacros (Csound* target, const CabbagePreprocessedCsd& csd);
+    //any console output that has arrived since the last call
     const String getCsoundOutput();
+    //Csound's console output, read from its message buffer on a background thread
+    const CabbageConsoleLog& getConsoleLog() const { return consoleLog; }
+    //copies the lines that have arrived since the last call, or the last getCsoundOutput(),
+    //into another log. Returns true if there were any
+    bool readConsoleLines (CabbageConsoleLog& dest);
+    int64 getNumDroppedConsoleMessages() const { return consoleLog.getNumDropped(); }
 
     void compileCsdFile (File csoundFile)
     {
@@ -206,16 +253,27 @@ public:
         guiRefreshRate = rate;
     }
 
+    int getGUIRefreshRate() const
+    {
+        return guiRefreshRate;
+    }
+
     MidiKeyboardState keyboardState;
     bool hostIsCubase = false;
 
     //==================================================================================
+    //the audio thread publishes each frame from Csound's draw callback into a triple buffer
+    //that is allocated when the display is made, so drawing never locks or allocates. The
+    //message thread picks up the newest frame by swapping buffer indices.
     class SignalDisplay
     {
     public:
         float yScale = 0.f;
         int windid = 0, min = 0, max = 0, size = 0;
         String caption = {}, variableName = {};
+        //the Csound window drawing into this display. A newer window with the same caption
+        //takes the display over, so frames only ever come from one window at a time
+        std::atomic<const WINDAT*> window { nullptr };
 
         SignalDisplay (String _caption, int _id, float _scale, int _min, int _max, int _size):
             yScale (_scale),
@@ -224,34 +282,237 @@ public:
             max (_max),
             size (_size),
             caption (_caption)
-        {}
+        {
+            for (auto& buffer : buffers)
+                buffer.calloc ((size_t) jmax (1, size));
+        }
+
+        //how frames are cut down to display resolution before they are published
+        enum class Reduction
+        {
+            none,
+            minMax,     //min/max pair per column, from the first half of the frame as waveforms are drawn
+            peak,       //largest value per column, for spectra
+            subsample   //first value per column, keeps x/y pairs lined up for lissajous curves
+        };
+
+        //can be called from any thread, takes effect from the next frame
+        void setReduction (Reduction reduction, int numColumns)
+        {
+            requestedReduction = (int) reduction | (jmax (0, numColumns) << 2);
+        }
+
+        //audio thread only
+        void pushFrame (const MYFLT* data, int numPoints)
+        {
+            const int request = requestedReduction.load();
+            const Reduction reduction = (Reduction) (request & 3);
+            const int numColumns = request >> 2;
+            numPoints = jlimit (0, size, numPoints);
+            float* const dest = buffers[backBuffer].getData();
+
+            if (reduction == Reduction::none || numColumns == 0)
+            {
+                for (int i = 0; i < numPoints; i++)
+                    dest[i] = (float) data[i];
+
+                bufferSizes[backBuffer] = numPoints;
+                bufferReductions[backBuffer] = Reduction::none;
+            }
+            else
+            {
+                bufferSizes[backBuffer] = reduce (reduction, data, numPoints, numColumns, dest);
+                bufferReductions[backBuffer] = reduction;
+            }
+
+            backBuffer = middleBuffer.exchange (backBuffer | newFrameFlag) & bufferIndexMask;
+        }
 
-        ~SignalDisplay()
+        //message thread only, returns false if no frame has been published since the last call
+        bool pullLatestFrame()
         {
-            points.clear();
+            if ((middleBuffer.load() & newFrameFlag) == 0)
+                return false;
+
+            frontBuffer = middleBuffer.exchange (frontBuffer) & bufferIndexMask;
+            return true;
         }
 
-        Array<float, CriticalSection> getPoints()
+        //the frame last picked up by pullLatestFrame()
+        Array<float, CriticalSection> getPoints() const
         {
-            return points;
+            return Array<float, CriticalSection> (buffers[frontBuffer].getData(), bufferSizes[frontBuffer]);
         }
 
-        void setPoints (Array <float, CriticalSection > tablePoints)
+        Reduction getReduction() const
         {
-            points.swapWith (tablePoints);
+            return bufferReductions[frontBuffer];
         }
 
     private:
-        Array <float, CriticalSection > points;
+        //one pass over the frame, writes at most numPoints values to dest and returns how many
+        static int reduce (Reduction reduction, const MYFLT* data, int numPoints, int numColumns, float* dest)
+        {
+            const int numSource = reduction == Reduction::minMax ? numPoints / 2 : numPoints;
+            numColumns = jmin (numColumns, numSource);
+
+            for (int column = 0; column < numColumns; column++)
+            {
+                const int start = (int) (((int64) column * numSource) / numColumns);
+                const int end = (int) (((int64) (column + 1) * numSource) / numColumns);
+                float low = (float) data[start], high = low;
+
+                if (reduction != Reduction::subsample)
+                {
+                    for (int i = start + 1; i < end; i++)
+                    {
+                        low = jmin (low, (float) data[i]);
+                        high = jmax (high, (float) data[i]);
+                    }
+                }
+
+                if (reduction == Reduction::minMax)
+                {
+                    dest[column * 2] = low;
+                    dest[column * 2 + 1] = high;
+                }
+                else
+                    dest[column] = reduction == Reduction::peak ? high : low;
+            }
+
+            return reduction == Reduction::minMax ? numColumns * 2 : numColumns;
+        }
+
+        enum { bufferIndexMask = 3, newFrameFlag = 4 };
+
+        HeapBlock<float> buffers[3];
+        int bufferSizes[3] = { 0, 0, 0 };
+        Reduction bufferReductions[3] = { Reduction::none, Reduction::none, Reduction::none };
+        std::atomic<int> requestedReduction { 0 };
+        int backBuffer = 0, frontBuffer = 1;
+        std::atomic<int> middleBuffer { 2 };
+
+        JUCE_DECLARE_NON_COPYABLE (SignalDisplay)
     };
 
-    bool shouldUpdateSignalDisplay(String signalDisplayName)
+    //message thread only. Picks up the newest frame of every display showing this variable
+    bool shouldUpdateSignalDisplay (String signalDisplayName);
+
+    //==================================================================================
+    //holds a pointer into Csound's channel bus so that channel reads and writes don't need
+    //a name lookup each time. There are two sets of pointers, one for the running instance
+    //and one for an instance compiled in the background, and the audio thread swaps them
+    //over with the instances. Pointers are re-resolved whenever Csound is recompiled.
+    class ControlChannel
     {
-        bool returnVal = bool(updateSignalDisplay.getWithDefault(signalDisplayName, false));
-        updateSignalDisplay.set(signalDisplayName, false);
-        return returnVal;
+    public:
+        ControlChannel (String channelName, int channelId, const std::atomic<int>& liveBindingIndex)
+            : name (channelName), id (channelId), liveBinding (liveBindingIndex) {}
+
+        //only for the binding that isn't live, or while the audio callback isn't running
+        void resolve (int binding, CSOUND* cs)
+        {
+            Binding& b = bindings[binding];
+            b.csound = cs;
+            b.value = nullptr;
+            b.lock = nullptr;
+
+            if (cs == nullptr)
+                return;
+
+            if (csoundGetChannelPtr (cs, &b.value, name.toUTF8(), CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
+                b.lock = csoundGetChannelLock (cs, name.toUTF8());
+            else
+                b.value = nullptr;
+        }
+
+        void setValue (MYFLT newValue)
+        {
+            const Binding& b = getLiveBinding();
+
+            if (b.value != nullptr)
+            {
+                if (b.lock != nullptr) csoundSpinLock (b.lock);
+                *b.value = newValue;
+                if (b.lock != nullptr) csoundSpinUnLock (b.lock);
+            }
+            else if (b.csound != nullptr)
+                csoundSetControlChannel (b.csound, name.toUTF8(), newValue);
+        }
+
+        MYFLT getValue() const
+        {
+            const Binding& b = getLiveBinding();
+
+            if (b.value != nullptr)
+            {
+                if (b.lock != nullptr) csoundSpinLock (b.lock);
+                const MYFLT currentValue = *b.value;
+                if (b.lock != nullptr) csoundSpinUnLock (b.lock);
+                return currentValue;
+            }
+
+            return b.csound != nullptr ? csoundGetControlChannel (b.csound, name.toUTF8(), nullptr) : 0;
+        }
+
+        const String name;
+        //interned id, used to queue values for the audio thread
+        const int id;
+
+    private:
+        struct Binding
+        {
+            CSOUND* csound = nullptr;
+            MYFLT* value = nullptr;
+            int* lock = nullptr;
+        };
+
+        const Binding& getLiveBinding() const   { return bindings[liveBinding.load (std::memory_order_acquire)]; }
+
+        Binding bindings[2];
+        const std::atomic<int>& liveBinding;
     };
 
+    //returns a cached channel, creating it if needed. Only call this from the message thread,
+    //the returned pointer stays valid for the lifetime of the processor
+    ControlChannel* getControlChannel (const String& channelName);
+    //writes from the editor and the host, applied at the next k-boundary. Only the newest
+    //value posted for a channel before then is passed on to Csound
+    void postChannelValue (ControlChannel* channel, float value);
+    //host parameter changes, applied at the k-cycle holding the sample they were made at and
+    //optionally ramped there from the channel's current value. Falls back to postChannelValue()
+    void postParameterChange (ControlChannel* channel, float value, bool ramp);
+    //counted since the last prepareToPlay()
+    CabbageMessageQueue::Stats getChannelMessageStats() const { return channelMessages.getStats(); }
+    //MIDI input events that arrived while Csound still had maxMidiInputEvents waiting, counted since the last prepareToPlay()
+    int64 getNumDroppedMidiInputEvents() const { return droppedMidiInputEvents.load(); }
+
+#if Cabbage_Performance_Monitor
+    //timings from the audio thread, also sent to Csound on the DSP_LOAD and DSP_OVERRUNS channels
+    CabbagePerformanceMonitor& getPerformanceMonitor() { return performanceMonitor; }
+#endif
+
+    //==================================================================================
+    //gentable widgets subscribe to the function tables they show. At the GUI rate each
+    //observed table is compared with the copy sent out last time, and listeners are only
+    //told about the index range that changed. Once the orchestra reports changes to a table
+    //with tableChanged, that table is only read when a report comes in.
+    class TableListener
+    {
+    public:
+        virtual ~TableListener() {}
+        virtual void tableChanged (int tableNumber, const Array<float, CriticalSection>& values, Range<int> changedRange) = 0;
+    };
+
+    //message thread only
+    void addTableListener (int tableNumber, TableListener* listener);
+    void removeTableListener (TableListener* listener);
+    void updateObservedTables();
+    //checks the whole table now, whether or not the orchestra reports its changes
+    void updateObservedTable (int tableNumber);
+    //message thread, once the instance that was replaced has been deleted. Drops anything cached from it
+    virtual void previousCsoundInstanceDeleted();
+
     OwnedArray<MatrixEventSequencer> matrixEventSequencers;
     OwnedArray <SignalDisplay, CriticalSection> signalArrays;   //holds values from FFT function table created using dispfft
     CsoundPluginProcessor::SignalDisplay* getSignalArray (String variableName, String displayType = "");
@@ -271,14 +532,52 @@ private:
     MidiBuffer midiOutputBuffer;
     int guiCycles = 0;
     int guiRefreshRate = 128;
-    MidiBuffer midiBuffer = {};
-    String csoundOutput = {};
+    //raw MIDI events waiting to be read by Csound at the next k-boundary
+    struct MidiInputEvent
+    {
+        uint8 data[3];
+        int size;
+    };
+    enum { maxMidiInputEvents = 1024 };
+    Array<MidiInputEvent> midiInputEvents;
+    int midiInputReadPosition = 0;
+    std::atomic<int64> droppedMidiInputEvents { 0 };
+    void addMidiInputEvent (const uint8* data, int numBytes);
+    //one thread, shared by every instance, moves messages from Csound into consoleLog
+    class ConsoleThread : public TimeSliceThread
+    {
+    public:
+        ConsoleThread() : TimeSliceThread ("Csound console") { startThread (3); }
+        ~ConsoleThread() { stopThread (1000); }
+    };
+
+    class ConsoleReader : public TimeSliceClient
+    {
+    public:
+        explicit ConsoleReader (CsoundPluginProcessor& p) : owner (p) {}
+        int useTimeSlice() override { return owner.readCsoundMessages(); }
+
+    private:
+        CsoundPluginProcessor& owner;
+    };
+
+    enum { maxConsoleLinesPerSecond = 200, consoleReadInterval = 20 };
+    CabbageConsoleLog consoleLog { maxConsoleLinesPerSecond };
+    //held while messages are read, and while an instance is being deleted
+    CriticalSection consoleLock;
+    //the instance the console thread reads from, swapped over with the instance on the audio thread
+    std::atomic<Csound*> consoleCsound { nullptr };
+    String partialConsoleLine;
+    int partialConsoleLineSeverity = CabbageConsoleLog::message;
+    uint64 consoleReadPosition = 0;
+    SharedResourcePointer<ConsoleThread> consoleThread;
+    ConsoleReader consoleReader { *this };
+    int readCsoundMessages();
+    void addConsoleLine (const String& line, int severity);
     std::unique_ptr<CSOUND_PARAMS> csoundParams;
     int csCompileResult = -1;
     int numCsoundOutputChannels = 0;
     int numCsoundInputChannels = 0;
-    int pos = 0;
-    NamedValueSet updateSignalDisplay;
     MYFLT cs_scale = 0.0;
     bool testLogicForMono = true;
     MYFLT *CSspin = nullptr;
@@ -292,8 +591,130 @@ private:
     int busIndex = 0;
     bool disableLogging = false;
 	int preferredLatency = 32;
+    //latency -1 compiles Csound with ksmps 1, so that each sample is computed before it is read
+    //back. With a larger ksmps a k-cycle can only run once all of its input is in, and its output
+    //is then read during the next k-cycle, ksmps samples late, whatever latency was asked for
+    bool isZeroLatency() const { return preferredLatency == -1 && csdKsmps == 1; }
     String internalStateData = {};
+    //cached channel pointers, never removed so that pointers handed out remain valid
+    OwnedArray<ControlChannel> controlChannels;
+    HashMap<String, ControlChannel*> controlChannelMap;
+    //which of each channel's bindings belongs to the running instance. Only flipped when
+    //instances are swapped, by the audio thread or under the callback lock
+    std::atomic<int> liveChannelBinding { 0 };
+    //the instance each binding is resolved against. The compile thread resolves the
+    //other binding while the message thread may be adding channels, so both hold this
+    CriticalSection channelBindingLock;
+    CSOUND* channelBindingCsounds[2] = { nullptr, nullptr };
+    CabbageMessageQueue channelMessages;
+    CabbageParameterEventList parameterEvents;
+    //the processor's sample clock, the position of the current block's first sample. Parameter
+    //changes are stamped with it, and kCycleStartSample is where the next k-cycle begins on it
+    std::atomic<int64> blockStartSample { 0 };
+    int64 kCycleStartSample = 0;
+    //the audio thread's view of controlChannels, by id. Allocated once so it never moves
+    HeapBlock<ControlChannel*> channelsById { (size_t) CabbageMessageQueue::maxChannels, true };
+    Array<ControlChannel*> hostDataChannels;
+    //points the running instance's bindings at cs
+    void resolveControlChannels (CSOUND* cs);
+    //points the other bindings at an instance that is about to be swapped in, or the one swapped out
+    void resolvePendingControlChannels (CSOUND* cs);
+    void resolveControlChannelBinding (int binding, CSOUND* cs);
+    void registerHostDataChannels();
+#if Cabbage_Performance_Monitor
+    CabbagePerformanceMonitor performanceMonitor;
+    ControlChannel* dspLoadChannel = nullptr;
+    ControlChannel* dspOverrunsChannel = nullptr;
+#endif
+
+    struct ObservedTable
+    {
+        int tableNumber = 0;
+        Array<float, CriticalSection> values;
+        Array<TableListener*> listeners;
+        bool reportedByOrchestra = false;
+        Range<int> reportedRange;
+    };
+
+    //bigger tables, usually sound files, are only read when a change is reported or asked for
+    enum { maxPolledTableSize = 8192 };
+    OwnedArray<ObservedTable> observedTables;
+    CSOUND* observedCsound = nullptr;
+    TableChangeQueue* observedTableChanges = nullptr;
+    ObservedTable* getObservedTable (int tableNumber);
+    void checkObservedTable (ObservedTable& table, Range<int> rangeToCheck);
+
+    //everything setupAndCompileCsound() builds, so that a new instance can be compiled
+    //while the current one is still running
+    struct CsoundInstance
+    {
+        //read from the processor and the host on the message thread, before compiling
+        File csdFile, filePath;
+        int sampleRate = 44100;
+        bool isMono = false;
+        bool debugMode = false;
+        bool supportsSidechain = false;
+        bool compiledInBackground = false;
+        String opcodeDir;
+        String internalState;
+
+        std::unique_ptr<Csound> csound;
+        std::unique_ptr<CSOUND_PARAMS> params;
+        int compileResult = -1;
+        int numInputChannels = 0;
+        int numOutputChannels = 0;
+        int numSideChainChannels = 0;
+        bool matchingNumberOfIOChannels = true;
+        int preferredLatency = 32;
+    };
+
+    void prepareCsoundInstance (CsoundInstance& instance, File currentCsdFile, File filePath, int sr, bool isMono, bool debugMode);
+    //only reads what prepareCsoundInstance() gathered, so it can run on the compile thread
+    void compileCsoundInstance (CsoundInstance& instance);
+    void initCsoundInstanceChannels (Csound* csound, ValueTree cabbageData, const String& internalState, File filePath, int& instanceLatency, bool onMessageThread);
+    //lays out the widget properties that cabbageGet can read, see WidgetStateSnapshot
+    static void createWidgetStateSnapshot (CSOUND* csound, ValueTree cabbageData);
+    //makes the instance live, and leaves the previous one in its place
+    void installCsoundInstance (CsoundInstance& instance);
+    //installs pendingInstance and switches the channels over to the bindings resolved for it
+    void installPendingCsoundInstance();
+    //reports what Csound said about an instance that never made it to the audio thread
+    void forwardCsoundMessages (Csound& instanceCsound);
+
+    class CsoundCompileThread : public Thread
+    {
+    public:
+        explicit CsoundCompileThread (CsoundPluginProcessor& p) : Thread ("Csound compile"), owner (p) {}
+        void run() override { owner.compilePendingCsoundInstance(); }
+
+    private:
+        CsoundPluginProcessor& owner;
+    };
+
+    //idle -> compiling -> readyToSwap -> swapped -> idle, or compiling -> failed -> idle
+    enum InstanceSwapState { idle = 0, compiling, readyToSwap, swapped, failed };
+    std::atomic<int> instanceSwapState { idle };
+    //prepared on the message thread and handed to the compile thread
+    std::unique_ptr<CsoundInstance> compilingInstance;
+    //the new instance until the audio thread swaps it in, the old one after that
+    std::unique_ptr<CsoundInstance> pendingInstance;
+    std::unique_ptr<CsoundCompileThread> compileThread;
+    ValueTree pendingCabbageData;
+    int readyToSwapTicks = 0;
+    AudioBuffer<float> crossfadeBufferFloat;
+    AudioBuffer<double> crossfadeBufferDouble;
+    AudioBuffer<float>& getCrossfadeBuffer (AudioBuffer<float>&) { return crossfadeBufferFloat; }
+    AudioBuffer<double>& getCrossfadeBuffer (AudioBuffer<double>&) { return crossfadeBufferDouble; }
+    void compilePendingCsoundInstance();
+    void handlePendingCsoundInstance();
+    //message thread, once a background compile has been swapped in, with the widgets it was compiled with
+    virtual void csoundInstanceSwapped (ValueTree cabbageData) {}
+    void discardPendingCsoundInstance();
 
+    template< typename Type >
+    void renderCsound (AudioBuffer< Type >&, MidiBuffer&);
+    template< typename Type >
+    void swapCsoundInstance (AudioBuffer< Type >&, MidiBuffer&);
 
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CsoundPluginProcessor)
@@ -0,0 +1,360 @@
+/*
+  Copyright (C) 2019 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../Audio/Plugins/CabbagePluginProcessor.h"
+#include "../Audio/Plugins/CabbagePluginEditor.h"
+#include <iostream>
+
+using namespace std;
+
+//runs each csd in the examples folder through the same code paths a host would, and
+//writes the time spent in each of them as JSON, so runs from different releases can be
+//diffed. All times are in milliseconds.
+
+struct BenchmarkSettings
+{
+    File examplesDir, outputFile;
+    String filter;
+    Array<int> blockSizes { 64, 256, 1024 };
+    double sampleRate = 44100;
+    double seconds = 2;
+    int channelDataTicks = 500;
+    bool createEditors = true;
+    bool verbose = false;
+};
+
+//keeps Csound's output off the console unless --verbose is given
+class SilentLogger : public Logger
+{
+    void logMessage (const String&) override {}
+};
+
+static double millisecondsSince (double start)
+{
+    return Time::getMillisecondCounterHiRes() - start;
+}
+
+//block times summarised the same way as CabbageCsoundCLI --render
+static var summariseBlockTimes (Array<double>& times, double blockBudget)
+{
+    DynamicObject::Ptr summary = new DynamicObject();
+    double total = 0;
+    int overruns = 0;
+
+    times.sort();
+
+    for (auto time : times)
+    {
+        total += time;
+
+        if (time > blockBudget)
+            ++overruns;
+    }
+
+    auto percentile = [&times] (double p) { return times[jmin (times.size() - 1, (int) (p * times.size()))]; };
+
+    summary->setProperty ("blocks", times.size());
+    summary->setProperty ("mean", total / jmax (1, times.size()));
+    summary->setProperty ("p50", percentile (0.5));
+    summary->setProperty ("p90", percentile (0.9));
+    summary->setProperty ("p99", percentile (0.99));
+    summary->setProperty ("max", times.getLast());
+    summary->setProperty ("overruns", overruns);
+    summary->setProperty ("realtimeFactor", times.size() * blockBudget / jmax (total, 0.000001));
+    return summary.get();
+}
+
+//noise on the inputs and a note held for the first half, so effects and instruments
+//both have something to do
+template <typename Type>
+static var runProcessBlock (CabbagePluginProcessor& processor, int blockSize, const BenchmarkSettings& settings)
+{
+    const int numInputs = processor.getTotalNumInputChannels();
+    const int numChannels = jmax (numInputs, processor.getTotalNumOutputChannels());
+    const int numBlocks = jmax (1, roundToInt (settings.seconds * settings.sampleRate / blockSize));
+
+    processor.prepareToPlay (settings.sampleRate, blockSize);
+
+    AudioBuffer<Type> buffer (numChannels, blockSize);
+    MidiBuffer midi;
+    Random random (1);
+    Array<double> times;
+    times.ensureStorageAllocated (numBlocks);
+
+    for (int block = 0; block < numBlocks; block++)
+    {
+        buffer.clear();
+
+        for (int channel = 0; channel < numInputs; channel++)
+            for (int i = 0; i < blockSize; i++)
+                buffer.setSample (channel, i, Type (random.nextFloat() * 0.2f - 0.1f));
+
+        midi.clear();
+
+        if (block == 0)
+            midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 0);
+        else if (block == numBlocks / 2)
+            midi.addEvent (MidiMessage::noteOff (1, 60), 0);
+
+        const double start = Time::getMillisecondCounterHiRes();
+        processor.processBlock (buffer, midi);
+        times.add (millisecondsSince (start));
+    }
+
+    processor.releaseResources();
+    return summariseBlockTimes (times, 1000. * blockSize / settings.sampleRate);
+}
+
+//the same widget polling the processor does on the message thread while audio runs. Each
+//parameter's channel is swept the way a slider drag would move it, the audio for one GUI
+//update is processed, and then the widgets are polled
+static var runChannelDataTicks (CabbagePluginProcessor& processor, const BenchmarkSettings& settings)
+{
+    const int blockSize = settings.blockSizes.getFirst();
+    //the processor asks for a GUI update once every refresh rate + 1 k-cycles
+    const int samplesPerTick = (processor.getGUIRefreshRate() + 1) * processor.getCsound()->GetKsmps();
+    const int blocksPerTick = jmax (1, roundToInt (samplesPerTick / (double) blockSize));
+    const int numTicks = jmax (1, settings.channelDataTicks);
+
+    processor.prepareToPlay (settings.sampleRate, blockSize);
+
+    AudioBuffer<float> buffer (jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), blockSize);
+    MidiBuffer midi;
+    Array<CsoundPluginProcessor::ControlChannel*> channels;
+
+    for (auto* parameter : processor.getCabbageParameters())
+        channels.add (processor.getControlChannel (parameter->getChannel()));
+
+    const int64 notificationsBefore = processor.getNumWidgetNotifications();
+    double pollTime = 0;
+
+    for (int tick = 0; tick < numTicks; tick++)
+    {
+        for (int i = 0; i < channels.size(); i++)
+        {
+            const NormalisableRange<float>& range = processor.getCabbageParameters()[i]->getNormalisableRange();
+
+            //a fast drag sends more than one value between k-cycles
+            for (int step = 0; step < 2; step++)
+                processor.postChannelValue (channels[i], range.convertFrom0to1 (std::fmod ((tick * 2 + step) * 0.01f + i * 0.1f, 1.f)));
+        }
+
+        for (int block = 0; block < blocksPerTick; block++)
+        {
+            buffer.clear();
+            processor.processBlock (buffer, midi);
+        }
+
+        const double start = Time::getMillisecondCounterHiRes();
+        processor.getChannelDataFromCsound();
+        pollTime += millisecondsSince (start);
+    }
+
+    processor.releaseResources();
+
+    //how the channel queue coped with the drags, to size it by
+    const CabbageMessageQueue::Stats stats = processor.getChannelMessageStats();
+    DynamicObject::Ptr channelMessages = new DynamicObject();
+    channelMessages->setProperty ("enqueued", stats.enqueued);
+    channelMessages->setProperty ("coalesced", stats.coalesced);
+    channelMessages->setProperty ("dropped", stats.dropped);
+    channelMessages->setProperty ("delivered", stats.delivered);
+    channelMessages->setProperty ("maxDrained", stats.maxDrained);
+
+    DynamicObject::Ptr result = new DynamicObject();
+    result->setProperty ("ticks", numTicks);
+    result->setProperty ("mean", pollTime / numTicks);
+    result->setProperty ("widgetNotificationsPerTick", (processor.getNumWidgetNotifications() - notificationsBefore) / (double) numTicks);
+    result->setProperty ("channelMessages", channelMessages.get());
+    return result.get();
+}
+
+//there is no offscreen peer to open the editor on, so its first paint is rendered into
+//an image, which is what a peer would do with the software renderer
+static var runEditor (CabbagePluginProcessor& processor)
+{
+    DynamicObject::Ptr timings = new DynamicObject();
+
+    double start = Time::getMillisecondCounterHiRes();
+    std::unique_ptr<AudioProcessorEditor> editor (processor.createEditorIfNeeded());
+    timings->setProperty ("create", millisecondsSince (start));
+
+    if (auto* cabbageEditor = dynamic_cast<CabbagePluginEditor*> (editor.get()))
+    {
+        start = Time::getMillisecondCounterHiRes();
+        cabbageEditor->createEditorInterface (processor.cabbageWidgets);
+        timings->setProperty ("createEditorInterface", millisecondsSince (start));
+        timings->setProperty ("numWidgets", processor.cabbageWidgets.getNumChildren());
+    }
+
+    if (editor != nullptr && ! editor->getLocalBounds().isEmpty())
+    {
+        start = Time::getMillisecondCounterHiRes();
+        editor->createComponentSnapshot (editor->getLocalBounds());
+        timings->setProperty ("paint", millisecondsSince (start));
+    }
+
+    return timings.get();
+}
+
+static var benchmarkCsd (const File& csdFile, const BenchmarkSettings& settings)
+{
+    DynamicObject::Ptr result = new DynamicObject();
+    result->setProperty ("file", csdFile.getRelativePathFrom (settings.examplesDir).replaceCharacter ('\\', '/'));
+
+    //laid out the way createPluginFilter() lays out a plugin for the csd
+    CabbagePreprocessedCsd::Ptr csd = CabbagePreprocessedCsd::get (csdFile);
+    const int numOutputs = jmax (1, csd->getHeaderInfo ("nchnls"));
+    const int numInputHeader = csd->getHeaderInfo ("nchnls_i");
+    const int numInputs = numInputHeader > 0 ? numInputHeader : numOutputs;
+
+    SilentLogger silentLogger;
+
+    if (! settings.verbose)
+        Logger::setCurrentLogger (&silentLogger);
+
+    const double start = Time::getMillisecondCounterHiRes();
+    std::unique_ptr<CabbagePluginProcessor> processor (new CabbagePluginProcessor (csdFile, AudioChannelSet::canonicalChannelSet (numInputs),
+                                                                                  AudioChannelSet::canonicalChannelSet (numOutputs)));
+    const double createTime = millisecondsSince (start);
+    const CabbagePluginProcessor::LoadTimings& loadTimings = processor->getLoadTimings();
+
+    DynamicObject::Ptr load = new DynamicObject();
+    load->setProperty ("total", createTime);
+    load->setProperty ("parseCsdFile", loadTimings.parse);
+    load->setProperty ("setupAndCompileCsound", loadTimings.compile);
+    load->setProperty ("createCabbageParameters", loadTimings.parameters);
+    result->setProperty ("load", load.get());
+    result->setProperty ("compiled", processor->csdCompiledWithoutError());
+
+    if (processor->csdCompiledWithoutError())
+    {
+        DynamicObject::Ptr processFloat = new DynamicObject();
+        DynamicObject::Ptr processDouble = new DynamicObject();
+
+        for (auto blockSize : settings.blockSizes)
+        {
+            processFloat->setProperty (String (blockSize), runProcessBlock<float> (*processor, blockSize, settings));
+            processDouble->setProperty (String (blockSize), runProcessBlock<double> (*processor, blockSize, settings));
+        }
+
+        result->setProperty ("ksmps", processor->getCsound()->GetKsmps());
+        result->setProperty ("processBlockFloat", processFloat.get());
+        result->setProperty ("processBlockDouble", processDouble.get());
+        result->setProperty ("getChannelDataFromCsound", runChannelDataTicks (*processor, settings));
+    }
+
+    if (settings.createEditors)
+        result->setProperty ("editor", runEditor (*processor));
+
+    processor = nullptr;
+    Logger::setCurrentLogger (nullptr);
+    return result.get();
+}
+
+static int getIntOption (const ArgumentList& args, StringRef option, int defaultValue)
+{
+    const String value (args.getValueForOption (option));
+    return value.isNotEmpty() ? value.getIntValue() : defaultValue;
+}
+
+static void runBenchmarks (const ArgumentList& args)
+{
+    BenchmarkSettings settings;
+    settings.examplesDir = args.containsOption ("--examples") ? args.getExistingFolderForOption ("--examples")
+                                                              : File::getCurrentWorkingDirectory().getChildFile ("Examples");
+    settings.outputFile = args.containsOption ("--output") ? args.getFileForOption ("--output")
+                                                           : File::getCurrentWorkingDirectory().getChildFile ("CabbageBenchmark.json");
+    settings.filter = args.getValueForOption ("--filter");
+    settings.sampleRate = getIntOption (args, "--sr", (int) settings.sampleRate);
+    settings.channelDataTicks = getIntOption (args, "--ticks", settings.channelDataTicks);
+    settings.createEditors = ! args.containsOption ("--no-editor");
+    settings.verbose = args.containsOption ("--verbose");
+
+    if (args.containsOption ("--seconds"))
+        settings.seconds = args.getValueForOption ("--seconds").getDoubleValue();
+
+    if (args.containsOption ("--blocks"))
+    {
+        settings.blockSizes.clear();
+
+        for (auto& blockSize : StringArray::fromTokens (args.getValueForOption ("--blocks"), ",", ""))
+            if (blockSize.getIntValue() > 0)
+                settings.blockSizes.add (blockSize.getIntValue());
+    }
+
+    if (! settings.examplesDir.isDirectory())
+        ConsoleApplication::fail ("Couldn't find " + settings.examplesDir.getFullPathName() + ", pass the folder with --examples=");
+
+    if (settings.sampleRate <= 0 || settings.seconds <= 0 || settings.blockSizes.isEmpty())
+        ConsoleApplication::fail ("--sr, --seconds and --blocks must be above 0");
+
+    Array<File> csdFiles (settings.examplesDir.findChildFiles (File::findFiles, true, "*.csd"));
+    csdFiles.sort();
+
+    Array<var> results;
+
+    for (auto& csdFile : csdFiles)
+    {
+        if (settings.filter.isNotEmpty() && ! csdFile.getFullPathName().containsIgnoreCase (settings.filter))
+            continue;
+
+        cout << csdFile.getRelativePathFrom (settings.examplesDir) << endl;
+        results.add (benchmarkCsd (csdFile, settings));
+    }
+
+    DynamicObject::Ptr report = new DynamicObject();
+    report->setProperty ("version", ProjectInfo::versionString);
+    report->setProperty ("date", Time::getCurrentTime().toISO8601 (true));
+    report->setProperty ("system", SystemStats::getOperatingSystemName() + ", " + SystemStats::getCpuModel());
+    report->setProperty ("sampleRate", settings.sampleRate);
+    report->setProperty ("seconds", settings.seconds);
+    report->setProperty ("results", results);
+
+    if (! settings.outputFile.replaceWithText (JSON::toString (report.get())))
+        ConsoleApplication::fail ("Couldn't write " + settings.outputFile.getFullPathName());
+
+    cout << "Wrote " << results.size() << " results to " << settings.outputFile.getFullPathName() << endl;
+}
+
+int main (int argc, char* argv[])
+{
+    //widgets and the editor need the message thread, which is this one
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage: CabbageBenchmark [options]\n\n"
+                        "Loads every csd under the examples folder as a plugin and times parsing, compiling,\n"
+                        "processBlock in float and double, widget updates and editor creation.\n\n"
+                        "  --examples=folder        defaults to ./Examples\n"
+                        "  --output=file.json       defaults to ./CabbageBenchmark.json\n"
+                        "  --filter=text            only csd files whose path contains this\n"
+                        "  --blocks=64,256,1024     block sizes to process with\n"
+                        "  --seconds=2              audio to process at each block size\n"
+                        "  --sr=44100               sample rate\n"
+                        "  --ticks=500              GUI updates to time getChannelDataFromCsound() over\n"
+                        "  --no-editor              don't create editors\n"
+                        "  --verbose                show Csound's messages", false);
+
+    app.addDefaultCommand ({ "", "[options]", "Benchmarks the examples", String(),
+                             [] (const ArgumentList& args) { runBenchmarks (args); } });
+
+    return app.findAndRunCommand (argc, argv);
+}
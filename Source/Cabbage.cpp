@@ -21,15 +21,75 @@
 #include "Application/CabbageDocumentWindow.h"
 #include "Cabbage.h"
 #include "Utilities/CabbageUtilities.h"
+#include "Widgets/CabbageWidgetData.h"
 
 
 //==============================================================================
 Cabbage::Cabbage()
 {
 }
+//==============================================================================
+//times the widget parser over the <Cabbage> sections of every csd below a directory,
+//e.g. Cabbage --benchmark-parser Examples
+static void benchmarkWidgetParser (const File& directory)
+{
+    StringArray widgetLines;
+
+    for (const auto& csdFile : directory.findChildFiles (File::findFiles, true, "*.csd"))
+    {
+        StringArray lines;
+        csdFile.readLines (lines);
+
+        for (const auto& line : lines)
+        {
+            if (line.contains ("</Cabbage>"))
+                break;
+
+            if (line.trim().isNotEmpty() && ! line.contains ("<Cabbage>") && line.trim().substring (0, 1) != ";")
+                widgetLines.add (line);
+        }
+    }
+
+    if (widgetLines.isEmpty())
+    {
+        std::cout << "No Cabbage widget lines found in " << directory.getFullPathName() << std::endl;
+        return;
+    }
+
+    auto runPass = [&widgetLines] (CabbageWidgetData::ScanMode mode)
+    {
+        const int passes = 5;
+        const double start = Time::getMillisecondCounterHiRes();
+
+        for (int pass = 0; pass < passes; pass++)
+            for (int i = 0; i < widgetLines.size(); i++)
+            {
+                ValueTree widget ("widget");
+                CabbageWidgetData::setWidgetState (widget, widgetLines[i], i, mode);
+            }
+
+        const double seconds = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        return (widgetLines.size() * passes) / jmax (seconds, 0.000001);
+    };
+
+    std::cout << "Widget lines: " << widgetLines.size() << std::endl;
+    std::cout << "All widgets: " << String (runPass (CabbageWidgetData::ScanMode::allWidgets), 0) << " lines/sec" << std::endl;
+    std::cout << "Form only:   " << String (runPass (CabbageWidgetData::ScanMode::formOnly), 0) << " lines/sec" << std::endl;
+}
+
 //==============================================================================
 void Cabbage::initialise (const String& commandLine)
 {
+    const StringArray params = getCommandLineParameterArray();
+
+    if (params.contains ("--benchmark-parser"))
+    {
+        isRunningCommandLine = true;
+        benchmarkWidgetParser (File::getCurrentWorkingDirectory().getChildFile (params[params.indexOf ("--benchmark-parser") + 1].unquoted()));
+        quit();
+        return;
+    }
+
     documentWindow.reset (new CabbageDocumentWindow (getApplicationName(), getCommandLineParameters()));
 
     if (commandLine.isEmpty())
@@ -319,6 +319,7 @@ public:
         add ("titlebarcolour");
         add ("tablegridcolor");
         add ("signalvariable");
+        add ("automationramp");
         add ("overlaycolour");
         add ("keydowncolour");
         add ("linethickness");
@@ -527,6 +528,7 @@ namespace CabbageIdentifierIds
 	static const Identifier arrowcolour = "arrowcolour";
     static const Identifier automation = "automation";
     static const Identifier automatable = "automatable";
+    static const Identifier automationramp = "automationramp";
 	static const Identifier author = "author";
 	static const Identifier backgroundcolour = "backgroundcolour";
 	static const Identifier ballcolour = "ballcolour";
@@ -727,6 +729,8 @@ namespace CabbageIdentifierIds
 	static const String cellheight = "cellheight";
 	static const String cellwidth = "cellwidth";
 	static const String csdfile = "csdfile";
+	static const String dspload = "DSP_LOAD";
+	static const String dspoverruns = "DSP_OVERRUNS";
 	static const String hostbpm = "HOST_BPM";
 	static const String hostppqpos = "HOST_PPQ_POS";
     static const String lastFileDropped = "LAST_FILE_DROPPED";
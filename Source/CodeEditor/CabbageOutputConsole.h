@@ -21,66 +21,212 @@
 
 #include "../CabbageIds.h"
 #include "../Settings/CabbageSettings.h"
+#include "../Utilities/CabbageConsoleLog.h"
+#include "../Audio/Plugins/CabbagePerformanceMonitor.h"
 
-class CabbageOutputConsole : public Component
+//only the last CabbageConsoleLog::capacity lines are kept, and only the rows
+//that are on screen get drawn
+class CabbageOutputConsole : public Component, private ListBoxModel
 {
-    std::unique_ptr<TextEditor> textEditor;
-    int fontSize;
+    ListBox listBox;
+    Label droppedMessagesLabel;
+    CabbageConsoleLog log;
+    int fontSize = 12;
+    int64 numDroppedMessages = 0;
     Typeface::Ptr fontPtr;
+    Colour textColour, backgroundColour, highlightColour;
+
+#if Cabbage_Performance_Monitor
+    //the instrument's DSP load over the last update, with a histogram of block loads on the
+    //left. The tooltip breaks the audio callback down by probe
+    class PerformanceMeter : public Component, public SettableTooltipClient
+    {
+    public:
+        Colour textColour, backgroundColour;
+        Font font;
+
+        void update (const CabbagePerformanceMonitor::Snapshot& window)
+        {
+            static const char* const probeNames[] = { "audio callback", "k-cycles", "host data", "score events", "MIDI in", "MIDI out" };
+            const CabbagePerformanceMonitor::ProbeStats& kCycles = window.probes[CabbagePerformanceMonitor::performKsmps];
+            String tooltip;
+
+            text = "DSP " + String (roundToInt (window.load * 100)) + "%, peak " + String (roundToInt (window.peakLoad * 100)) + "%";
+
+            if (kCycles.count > 0)
+                text << ", k-cycle p99 " << String (kCycles.getPercentileMicroseconds (0.99) / 1000.0, 2) << " ms";
+
+            if (window.numOverruns > 0)
+                text << ", " << String (window.numOverruns) << (window.numOverruns == 1 ? " overrun" : " overruns");
+
+            for (int probe = 0; probe < CabbagePerformanceMonitor::numProbes; probe++)
+            {
+                const CabbagePerformanceMonitor::ProbeStats& stats = window.probes[probe];
+
+                if (stats.count > 0)
+                    tooltip << probeNames[probe] << ": mean " << String (stats.getMeanMicroseconds(), 1)
+                            << "us, p99 " << String (stats.getPercentileMicroseconds (0.99), 1)
+                            << "us, max " << String (stats.maxMicroseconds, 1) << "us\n";
+            }
+
+            setTooltip (tooltip.trimEnd());
+            maxLoadCount = 1;
+
+            for (int i = 0; i < CabbagePerformanceMonitor::numLoadBuckets; i++)
+            {
+                loadHistogram[i] = window.loadHistogram[i];
+                maxLoadCount = jmax (maxLoadCount, loadHistogram[i]);
+            }
+
+            repaint();
+        }
+
+        void paint (Graphics& g) override
+        {
+            g.fillAll (backgroundColour.withAlpha (.8f));
+            Rectangle<float> area (getLocalBounds().reduced (2).toFloat());
+            const Rectangle<float> histogramArea (area.removeFromLeft (CabbagePerformanceMonitor::numLoadBuckets * 2.f));
+
+            for (int i = 0; i < CabbagePerformanceMonitor::numLoadBuckets; i++)
+            {
+                const float height = histogramArea.getHeight() * loadHistogram[i] / maxLoadCount;
+                g.setColour (i == CabbagePerformanceMonitor::numLoadBuckets - 1 ? textColour.interpolatedWith (Colours::red, .7f) : textColour);
+                g.fillRect (histogramArea.getX() + i * 2.f, histogramArea.getBottom() - height, 1.5f, height);
+            }
+
+            g.setColour (textColour);
+            g.setFont (font);
+            g.drawText (text, area.withTrimmedLeft (4.f), Justification::centredRight, false);
+        }
+
+    private:
+        String text;
+        uint32 loadHistogram[CabbagePerformanceMonitor::numLoadBuckets] = {};
+        uint32 maxLoadCount = 1;
+    };
+
+    PerformanceMeter performanceMeter;
+    CabbagePerformanceMonitor::Snapshot lastPerformanceSnapshot;
+#endif
+
 public:
     CabbageOutputConsole (ValueTree valueTree): Component(), value (valueTree)
     {
-        textEditor.reset (new TextEditor());
-        addAndMakeVisible (textEditor.get(), true);
-        textEditor->setColour (Label::outlineColourId, Colours::white);
-        textEditor->setColour (TextEditor::textColourId, CabbageSettings::getColourFromValueTree (valueTree, CabbageColourIds::consoleText, Colours::grey.darker()));
-        textEditor->setColour (TextEditor::backgroundColourId, CabbageSettings::getColourFromValueTree (valueTree, CabbageColourIds::consoleBackground, Colours::grey.darker()));
-        textEditor->setColour (TextEditor::highlightColourId, CabbageSettings::getColourFromValueTree (valueTree, CabbageColourIds::selectTextBackground, Colours::grey));
-        textEditor->setColour (TextEditor::highlightedTextColourId, CabbageSettings::getColourFromValueTree (valueTree, CabbageColourIds::selectTextBackground, Colours::grey).contrasting(0.8f));
-        textEditor->setMultiLine (true);
-        textEditor->setReadOnly (true);
+        addAndMakeVisible (listBox);
+        listBox.setModel (this);
+        listBox.setMultipleSelectionEnabled (true);
+        addChildComponent (droppedMessagesLabel);
+        droppedMessagesLabel.setJustificationType (Justification::centredRight);
+        droppedMessagesLabel.setInterceptsMouseClicks (false, false);
+#if Cabbage_Performance_Monitor
+        addChildComponent (performanceMeter);
+#endif
 
         fontPtr = Typeface::createSystemTypefaceFor (CabbageBinaryData::DejaVuSansMonoBold_ttf,  CabbageBinaryData::DejaVuSansMonoBold_ttfSize);
-        textEditor->setFont (Font (fontPtr).withHeight (12));
+        updateColourScheme();
+        setFontSize (12);
 
         setText ("Csound output message console\n");
     };
 
-    ~CabbageOutputConsole() {};
+    ~CabbageOutputConsole()
+    {
+        listBox.setModel (nullptr);
+    };
+
+    //lines can be added to this directly, followed by a call to linesAdded()
+    CabbageConsoleLog& getLog()
+    {
+        return log;
+    }
+
+    void linesAdded()
+    {
+        const bool followNewLines = isScrolledToEnd();
+        listBox.updateContent();
+
+        if (followNewLines)
+            listBox.scrollToEnsureRowIsOnscreen (getNumRows() - 1);
 
+        listBox.repaint();
+    }
 
     void setText (String text)
     {
         const MessageManagerLock lock;
-        textEditor->insertTextAtCaret (text);
-        textEditor->setCaretPosition (textEditor->getText().length());
+        log.addText (text, CabbageConsoleLog::message, Time::currentTimeMillis());
+        linesAdded();
     }
 
     String getText()
     {
-        const MessageManagerLock lock;
-        return textEditor->getText();
+        uint64 start = 0;
+        return log.getTextSince (start);
+    }
+
+    //messages thrown away because Csound was printing faster than the console rate limit
+    void setNumDroppedMessages (int64 numDropped)
+    {
+        if (numDropped == numDroppedMessages)
+            return;
+
+        numDroppedMessages = numDropped;
+        droppedMessagesLabel.setText (String (numDropped) + (numDropped == 1 ? " message dropped" : " messages dropped"), dontSendNotification);
+        droppedMessagesLabel.setVisible (numDropped > 0);
+    }
+
+#if Cabbage_Performance_Monitor
+    //shows what the instrument's audio callback has been doing since the previous call.
+    //The meter stays hidden until the instrument has processed some audio
+    void setPerformanceSnapshot (const CabbagePerformanceMonitor::Snapshot& snapshot)
+    {
+        const int processBlock = CabbagePerformanceMonitor::processBlock;
+
+        //the counters start again when the instrument is prepared to play
+        if (snapshot.probes[processBlock].count < lastPerformanceSnapshot.probes[processBlock].count)
+            lastPerformanceSnapshot = CabbagePerformanceMonitor::Snapshot();
+
+        performanceMeter.update (snapshot.since (lastPerformanceSnapshot));
+        performanceMeter.setVisible (snapshot.probes[processBlock].count > 0);
+        lastPerformanceSnapshot = snapshot;
     }
+#endif
 
     void updateColourScheme()
     {
 #ifndef CabbageLite
-        textEditor->setColour (TextEditor::textColourId, CabbageSettings::getColourFromValueTree (value, CabbageColourIds::consoleText, Colours::grey.darker()));
-        textEditor->setColour (TextEditor::backgroundColourId, CabbageSettings::getColourFromValueTree (value, CabbageColourIds::consoleBackground, Colours::grey.darker()));
-        textEditor->setColour (ScrollBar::ColourIds::thumbColourId,
+        textColour = CabbageSettings::getColourFromValueTree (value, CabbageColourIds::consoleText, Colours::grey.darker());
+        backgroundColour = CabbageSettings::getColourFromValueTree (value, CabbageColourIds::consoleBackground, Colours::grey.darker());
+        highlightColour = CabbageSettings::getColourFromValueTree (value, CabbageColourIds::selectTextBackground, Colours::grey);
+        listBox.setColour (ScrollBar::ColourIds::thumbColourId,
             CabbageSettings::getColourFromValueTree (value, CabbageColourIds::consoleBackground, Colours::white).contrasting (.1f));
-        repaint();
 #else
-        textEditor->setColour (TextEditor::textColourId, Colours::green);
-        textEditor->setColour (TextEditor::backgroundColourId, Colour (20, 20, 20));
-        repaint();
+        textColour = Colours::green;
+        backgroundColour = Colour (20, 20, 20);
+        highlightColour = Colours::grey;
+#endif
+        listBox.setColour (ListBox::backgroundColourId, backgroundColour);
+        droppedMessagesLabel.setColour (Label::textColourId, textColour.interpolatedWith (Colours::orange, .7f));
+        droppedMessagesLabel.setColour (Label::backgroundColourId, backgroundColour.withAlpha (.8f));
+#if Cabbage_Performance_Monitor
+        performanceMeter.textColour = textColour;
+        performanceMeter.backgroundColour = backgroundColour;
 #endif
+        repaint();
     }
 
     void setFontSize (int size)
     {
-        textEditor->setFont (Font (fontPtr).withHeight (size));
         fontSize = size;
+        const Font font (Font (fontPtr).withHeight (fontSize));
+        listBox.setRowHeight (roundToInt (font.getHeight() * 1.2f));
+        listBox.setMinimumContentWidth (roundToInt (font.getStringWidthFloat ("W") * CabbageConsoleLog::maxLineLength));
+        droppedMessagesLabel.setFont (font);
+#if Cabbage_Performance_Monitor
+        performanceMeter.font = font;
+#endif
+        resized();
+        listBox.repaint();
     }
 
     int getFontSize()
@@ -91,27 +237,30 @@ public:
     void zoom (bool in)
     {
         if (in == true)
-            fontSize++;
+            setFontSize (fontSize + 1);
         else
-            fontSize = fontSize > 6 ? fontSize - 1 : fontSize;
-
-        String currentText = textEditor->getText();
-        textEditor->setText ("");
-        textEditor->setFont (Font (fontPtr).withHeight (fontSize));
-        textEditor->setText (currentText);
-        textEditor->setCaretPosition (textEditor->getText().length());
+            setFontSize (fontSize > 6 ? fontSize - 1 : fontSize);
 
+        listBox.scrollToEnsureRowIsOnscreen (getNumRows() - 1);
     }
 
     void clearText()
     {
-        textEditor->setText ("");
+        log.clear();
+        listBox.updateContent();
+        listBox.repaint();
     }
 
     void resized() override
     {
-        Rectangle<int> area (getLocalBounds());
-        textEditor->setBounds (area.reduced (2).withY (0));
+        Rectangle<int> area (getLocalBounds().reduced (2).withY (0));
+        listBox.setBounds (area);
+        const int scrollBarThickness = listBox.getViewport()->getScrollBarThickness();
+#if Cabbage_Performance_Monitor
+        performanceMeter.setBounds (area.withTrimmedBottom (scrollBarThickness).removeFromBottom (listBox.getRowHeight() + 4)
+                                        .removeFromRight (area.getWidth() / 2).translated (-scrollBarThickness, 0));
+#endif
+        droppedMessagesLabel.setBounds (area.removeFromTop (listBox.getRowHeight() + 4).removeFromRight (area.getWidth() / 2).translated (-scrollBarThickness, 0));
     }
 
     void paint (Graphics& g)  override
@@ -121,9 +270,70 @@ public:
 #endif
     }
 
+    bool keyPressed (const KeyPress& key) override
+    {
+        if (key == KeyPress ('c', ModifierKeys::commandModifier, 0))
+        {
+            String selectedText;
+            CabbageConsoleLog::Line line;
+            const uint64 start = log.getStartSequence();
+
+            for (int i = 0; i < listBox.getNumSelectedRows(); i++)
+                if (log.getLine (start + listBox.getSelectedRow (i), line))
+                    selectedText << line.text << "\n";
+
+            SystemClipboard::copyTextToClipboard (selectedText);
+            return true;
+        }
+
+        return false;
+    }
+
 private:
     ValueTree value;
 
+    bool isScrolledToEnd()
+    {
+        Viewport* viewport = listBox.getViewport();
+        return viewport->getViewPositionY() + viewport->getViewHeight() >= viewport->getViewedComponent()->getHeight() - listBox.getRowHeight();
+    }
+
+    int getNumRows() override
+    {
+        return log.getNumLines();
+    }
+
+    void paintListBoxItem (int rowNumber, Graphics& g, int width, int height, bool rowIsSelected) override
+    {
+        CabbageConsoleLog::Line line;
+
+        if (! log.getLine (log.getStartSequence() + rowNumber, line))
+            return;
+
+        if (rowIsSelected)
+            g.fillAll (highlightColour);
+
+        if (line.severity == CabbageConsoleLog::error)
+            g.setColour (textColour.interpolatedWith (Colours::red, .7f));
+        else if (line.severity == CabbageConsoleLog::warning)
+            g.setColour (textColour.interpolatedWith (Colours::orange, .7f));
+        else
+            g.setColour (rowIsSelected ? highlightColour.contrasting (.8f) : textColour);
+
+        g.setFont (Font (fontPtr).withHeight (fontSize));
+        g.drawText (String::fromUTF8 (line.text), 4, 0, width - 4, height, Justification::centredLeft, false);
+    }
+
+    String getTooltipForRow (int row) override
+    {
+        CabbageConsoleLog::Line line;
+
+        if (log.getLine (log.getStartSequence() + row, line))
+            return Time (line.time).toString (false, true, true, true);
+
+        return String();
+    }
+
 };
 
 
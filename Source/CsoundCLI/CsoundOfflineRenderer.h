@@ -0,0 +1,400 @@
+/*
+  Copyright (C) 2019 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef CSOUNDOFFLINERENDERER_H_INCLUDED
+#define CSOUNDOFFLINERENDERER_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../Audio/Plugins/CabbagePluginProcessor.h"
+#include <iostream>
+
+//==============================================================================
+//loads a csd into a CabbagePluginProcessor, as a host would, and calls processBlock
+//with blocks of a fixed size, without an audio device. Every block is timed, so the
+//results show how close an instrument comes to running out of time in a real audio
+//callback. Needs the message thread, as the processor does.
+class CsoundOfflineRenderer
+{
+public:
+    struct Settings
+    {
+        File csdFile;
+        File inputFile;             //a sound file to feed in, otherwise inputSignal is used
+        String inputSignal = "silence";     //silence, sine or noise
+        File midiFile;
+        File automationFile;
+        File outputFile;            //nothing is written if this isn't set
+        int sampleRate = 44100;     //used unless the csd sets sr, as in the plugin
+        int blockSize = 512;
+        int numInputChannels = 2;
+        int numOutputChannels = 2;
+        double duration = 0;        //0 to use the length of the input or MIDI file
+        bool quiet = false;
+    };
+
+    struct Results
+    {
+        int sampleRate = 0;
+        int ksmps = 0;
+        int64 numSamples = 0;
+        int numBlocks = 0;
+        double renderSeconds = 0;
+        //how many seconds of audio were rendered for every second spent doing it
+        double realTimeFactor = 0;
+        double blockMilliseconds[4] = {};   //50th, 90th and 99th percentiles, and the slowest block
+        //blocks that took longer than their own duration, i.e. xruns in a real audio callback
+        int numOverruns = 0;
+    };
+
+    explicit CsoundOfflineRenderer (const Settings& renderSettings) : settings (renderSettings) {}
+
+    ~CsoundOfflineRenderer()
+    {
+        processor = nullptr;
+        Logger::setCurrentLogger (nullptr);
+    }
+
+    Result render (Results& results)
+    {
+        Result setup = createProcessor();
+
+        if (setup.failed())
+            return setup;
+
+        setup = openInput();
+
+        if (setup.failed())
+            return setup;
+
+        setup = loadMidiFile();
+
+        if (setup.failed())
+            return setup;
+
+        setup = loadAutomationFile();
+
+        if (setup.failed())
+            return setup;
+
+        std::unique_ptr<AudioFormatWriter> writer;
+
+        if (settings.outputFile != File())
+        {
+            settings.outputFile.deleteFile();
+            std::unique_ptr<FileOutputStream> stream (settings.outputFile.createOutputStream());
+
+            if (stream == nullptr)
+                return Result::fail ("Couldn't write to " + settings.outputFile.getFullPathName());
+
+            WavAudioFormat wav;
+            writer.reset (wav.createWriterFor (stream.get(), sampleRate, (unsigned int) settings.numOutputChannels, 24, {}, 0));
+
+            if (writer == nullptr)
+                return Result::fail ("Couldn't create a WAV writer for " + settings.outputFile.getFullPathName());
+
+            stream.release();
+        }
+
+        const int64 totalSamples = getLengthInSamples();
+        const int blockSize = settings.blockSize;
+        AudioBuffer<float> buffer (jmax (settings.numInputChannels, settings.numOutputChannels), blockSize);
+        MidiBuffer midi;
+        Array<double> blockTimes;
+        blockTimes.ensureStorageAllocated ((int) (totalSamples / blockSize) + 1);
+
+        const double blockDuration = blockSize / (double) sampleRate;
+        double totalTime = 0;
+
+        for (int64 blockStart = 0; blockStart < totalSamples; blockStart += blockSize)
+        {
+            //the last block is a full one, as a host's would be, but only its start is kept
+            const int numSamples = (int) jmin ((int64) blockSize, totalSamples - blockStart);
+            fillInputBuffer (buffer, blockStart);
+            fillMidiBuffer (midi, blockStart);
+            postAutomation (blockStart);
+
+            const int64 startTicks = Time::getHighResolutionTicks();
+            processor->processBlock (buffer, midi);
+            const double blockTime = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+            totalTime += blockTime;
+            blockTimes.add (blockTime);
+
+            if (blockTime > blockDuration)
+                results.numOverruns++;
+
+            if (writer != nullptr)
+                writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+
+            results.numSamples += numSamples;
+        }
+
+        processor->releaseResources();
+
+        results.sampleRate = sampleRate;
+        results.ksmps = processor->getCsound()->GetKsmps();
+        results.numBlocks = blockTimes.size();
+        results.renderSeconds = totalTime;
+        results.realTimeFactor = totalTime > 0 ? results.numSamples / (double) sampleRate / totalTime : 0;
+
+        if (blockTimes.size() > 0)
+        {
+            blockTimes.sort();
+            const double percentiles[] = { .5, .9, .99, 1. };
+
+            for (int i = 0; i < 4; i++)
+                results.blockMilliseconds[i] = 1000 * blockTimes[jmin (blockTimes.size() - 1, (int) (percentiles[i] * blockTimes.size()))];
+        }
+
+        return Result::ok();
+    }
+
+private:
+    //==============================================================================
+    //keeps Csound's output off the console when --quiet is given
+    class SilentLogger : public Logger
+    {
+        void logMessage (const String&) override {}
+    };
+
+    Result createProcessor()
+    {
+        if (! settings.csdFile.existsAsFile())
+            return Result::fail ("Couldn't find " + settings.csdFile.getFullPathName());
+
+        if (settings.quiet)
+            Logger::setCurrentLogger (&silentLogger);
+
+        processor.reset (new CabbagePluginProcessor (settings.csdFile, AudioChannelSet::canonicalChannelSet (settings.numInputChannels),
+                                                     AudioChannelSet::canonicalChannelSet (settings.numOutputChannels)));
+
+        //recompiles at the requested rate, the csd's own sr still wins as it does in a host
+        processor->prepareToPlay (settings.sampleRate, settings.blockSize);
+
+        if (! processor->csdCompiledWithoutError())
+            return Result::fail ("Csound couldn't compile " + settings.csdFile.getFullPathName());
+
+        sampleRate = (int) processor->getCsound()->GetSr();
+        return Result::ok();
+    }
+
+    Result openInput()
+    {
+        if (settings.inputFile == File())
+        {
+            if (settings.inputSignal != "silence" && settings.inputSignal != "sine" && settings.inputSignal != "noise")
+                return Result::fail ("Unknown input signal " + settings.inputSignal + ", use silence, sine or noise");
+
+            return Result::ok();
+        }
+
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        inputReader.reset (formatManager.createReaderFor (settings.inputFile));
+
+        if (inputReader == nullptr)
+            return Result::fail ("Couldn't read " + settings.inputFile.getFullPathName());
+
+        if (inputReader->sampleRate != sampleRate)
+            std::cout << "Warning: " << settings.inputFile.getFileName() << " is at " << inputReader->sampleRate
+                      << "Hz, and will be played at " << sampleRate << "Hz" << std::endl;
+
+        return Result::ok();
+    }
+
+    Result loadMidiFile()
+    {
+        if (settings.midiFile == File())
+            return Result::ok();
+
+        FileInputStream stream (settings.midiFile);
+        MidiFile midiFile;
+
+        if (stream.failedToOpen() || ! midiFile.readFrom (stream))
+            return Result::fail ("Couldn't read MIDI file " + settings.midiFile.getFullPathName());
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        for (int i = 0; i < midiFile.getNumTracks(); i++)
+            midiEvents.addSequence (*midiFile.getTrack (i), 0);
+
+        midiEvents.sort();
+        return Result::ok();
+    }
+
+    //one change per line: <time in seconds> <channel> <value>. Blank lines and lines
+    //starting with ; or # are skipped
+    Result loadAutomationFile()
+    {
+        if (settings.automationFile == File())
+            return Result::ok();
+
+        if (! settings.automationFile.existsAsFile())
+            return Result::fail ("Couldn't find automation file " + settings.automationFile.getFullPathName());
+
+        StringArray lines;
+        settings.automationFile.readLines (lines);
+
+        for (int i = 0; i < lines.size(); i++)
+        {
+            const String line (lines[i].trim());
+
+            if (line.isEmpty() || line.startsWithChar (';') || line.startsWithChar ('#'))
+                continue;
+
+            StringArray tokens;
+            tokens.addTokens (line, " \t", "\"");
+            tokens.removeEmptyStrings();
+
+            if (tokens.size() != 3)
+                return Result::fail ("Line " + String (i + 1) + " of " + settings.automationFile.getFileName() + " should be <time> <channel> <value>");
+
+            const String channel (tokens[1].unquoted());
+            automation.add ({ roundToInt (tokens[0].getDoubleValue() * sampleRate),
+                              processor->getControlChannel (channel), (float) tokens[2].getDoubleValue(), isAutomationRamped (channel) });
+        }
+
+        std::stable_sort (automation.begin(), automation.end(), [] (const AutomationEvent& a, const AutomationEvent& b)
+        {
+            return a.samplePosition < b.samplePosition;
+        });
+
+        return Result::ok();
+    }
+
+    int64 getLengthInSamples() const
+    {
+        if (settings.duration > 0)
+            return (int64) (settings.duration * sampleRate);
+
+        if (inputReader != nullptr)
+            return inputReader->lengthInSamples;
+
+        //leave a second for releases to ring out
+        if (midiEvents.getNumEvents() > 0)
+            return (int64) ((midiEvents.getEndTime() + 1.) * sampleRate);
+
+        if (automation.size() > 0)
+            return automation.getLast().samplePosition + sampleRate;
+
+        return (int64) (defaultDuration * sampleRate);
+    }
+
+    //==============================================================================
+    void fillInputBuffer (AudioBuffer<float>& buffer, int64 blockStart)
+    {
+        buffer.clear();
+        const int numInputs = jmin (settings.numInputChannels, buffer.getNumChannels());
+        const int numSamples = buffer.getNumSamples();
+
+        if (numInputs == 0)
+            return;
+
+        if (inputReader != nullptr)
+        {
+            AudioBuffer<float> inputs (buffer.getArrayOfWritePointers(), numInputs, numSamples);
+            inputReader->read (&inputs, 0, numSamples, blockStart, true, true);
+        }
+        else if (settings.inputSignal == "sine")
+        {
+            const double phaseIncrement = MathConstants<double>::twoPi * 440. / sampleRate;
+
+            for (int i = 0; i < numSamples; i++)
+                buffer.setSample (0, i, (float) (testSignalLevel * std::sin ((blockStart + i) * phaseIncrement)));
+
+            for (int channel = 1; channel < numInputs; channel++)
+                buffer.copyFrom (channel, 0, buffer, 0, 0, numSamples);
+        }
+        else if (settings.inputSignal == "noise")
+        {
+            for (int channel = 0; channel < numInputs; channel++)
+                for (int i = 0; i < numSamples; i++)
+                    buffer.setSample (channel, i, testSignalLevel * (2.f * random.nextFloat() - 1.f));
+        }
+    }
+
+    //the processor hands MIDI to Csound at the k-cycle each event falls in
+    void fillMidiBuffer (MidiBuffer& midi, int64 blockStart)
+    {
+        midi.clear();
+        const int64 blockEnd = blockStart + settings.blockSize;
+
+        while (midiIndex < midiEvents.getNumEvents())
+        {
+            const MidiMessage& message = midiEvents.getEventPointer (midiIndex)->message;
+            const int64 position = (int64) (message.getTimeStamp() * sampleRate);
+
+            if (position >= blockEnd)
+                break;
+
+            if (! message.isMetaEvent() && ! message.isSysEx())
+                midi.addEvent (message, (int) jmax ((int64) 0, position - blockStart));
+
+            midiIndex++;
+        }
+    }
+
+    //channels of parameters with automationramp(1) glide to each value, as they would in a host
+    bool isAutomationRamped (const String& channel) const
+    {
+        for (auto* parameter : processor->getCabbageParameters())
+            if (parameter->getChannel() == channel)
+                return parameter->getAutomationRamp();
+
+        return false;
+    }
+
+    //sent before the block they fall in, and on the same path, as a host's parameter changes would be
+    void postAutomation (int64 blockStart)
+    {
+        const int64 blockEnd = blockStart + settings.blockSize;
+
+        while (automationIndex < automation.size() && automation.getReference (automationIndex).samplePosition < blockEnd)
+        {
+            const AutomationEvent& event = automation.getReference (automationIndex++);
+            processor->postParameterChange (event.channel, event.value, event.ramp);
+        }
+    }
+
+    //==============================================================================
+    struct AutomationEvent
+    {
+        int64 samplePosition;
+        CsoundPluginProcessor::ControlChannel* channel;
+        float value;
+        bool ramp;
+    };
+
+    static constexpr double defaultDuration = 10.;
+    static constexpr float testSignalLevel = .25f;
+
+    Settings settings;
+    SilentLogger silentLogger;
+    std::unique_ptr<CabbagePluginProcessor> processor;
+    std::unique_ptr<AudioFormatReader> inputReader;
+    MidiMessageSequence midiEvents;
+    Array<AutomationEvent> automation;
+    Random random;
+    int sampleRate = 44100;
+    int midiIndex = 0, automationIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (CsoundOfflineRenderer)
+};
+
+#endif  // CSOUNDOFFLINERENDERER_H_INCLUDED
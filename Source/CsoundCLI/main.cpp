@@ -1,21 +1,128 @@
 #include <stdio.h>
 #include "csound.hpp"
 #include <iostream>
+#include "CsoundOfflineRenderer.h"
 
 using namespace std;
 
 //very basic app that will runs a few k-rate cycles of a Csound file for segfaults.
+//With --render it loads the file into a headless plugin, as a host would, and reports how long it took.
 
-int main (int argc, char* argv[])
+static int runCrashTest (const char* csdFile)
 {
     Csound* csound = new Csound();
-    csound->CompileCsd (argv[1]);
+    csound->CompileCsd (csdFile);
     csound->Start();
-    
+
     for ( int i = 0 ; i < 16 ; i++)
         csound->PerformKsmps();
-    
+
     //free Csound object
     delete csound;
     return 0;
 }
+
+static int getIntOption (const ArgumentList& args, StringRef option, int defaultValue)
+{
+    const String value (args.getValueForOption (option));
+    return value.isNotEmpty() ? value.getIntValue() : defaultValue;
+}
+
+static void render (const ArgumentList& args)
+{
+    //the plugin needs the message thread, which is this one
+    ScopedJuceInitialiser_GUI juceInitialiser;
+    CsoundOfflineRenderer::Settings settings;
+
+    //either --render=file.csd or --render file.csd
+    for (int i = 0; i < args.size() && settings.csdFile == File(); i++)
+    {
+        if (args[i].text.startsWith ("--render="))
+            settings.csdFile = args.getExistingFileForOption ("--render");
+        else if (! args[i].isOption())
+            settings.csdFile = args[i].resolveAsExistingFile();
+    }
+
+    if (settings.csdFile == File())
+        ConsoleApplication::fail ("Expected a csd file after --render");
+
+    if (args.containsOption ("--input"))
+    {
+        const String input (args.getValueForOption ("--input"));
+
+        if (input == "silence" || input == "sine" || input == "noise")
+            settings.inputSignal = input;
+        else
+            settings.inputFile = args.getExistingFileForOption ("--input");
+    }
+
+    if (args.containsOption ("--midi"))
+        settings.midiFile = args.getExistingFileForOption ("--midi");
+
+    if (args.containsOption ("--automation"))
+        settings.automationFile = args.getExistingFileForOption ("--automation");
+
+    if (args.containsOption ("--output"))
+        settings.outputFile = args.getFileForOption ("--output");
+
+    settings.sampleRate = getIntOption (args, "--sr", settings.sampleRate);
+    settings.blockSize = getIntOption (args, "--block", settings.blockSize);
+    settings.numInputChannels = getIntOption (args, "--inputs", settings.numInputChannels);
+    settings.numOutputChannels = getIntOption (args, "--outputs", settings.numOutputChannels);
+    settings.duration = args.getValueForOption ("--duration").getDoubleValue();
+    settings.quiet = args.containsOption ("--quiet");
+
+    if (settings.sampleRate <= 0 || settings.blockSize <= 0 || settings.numInputChannels < 0 || settings.numOutputChannels <= 0)
+        ConsoleApplication::fail ("--sr, --block and --outputs must be above 0, and --inputs can't be negative");
+
+    CsoundOfflineRenderer renderer (settings);
+    CsoundOfflineRenderer::Results results;
+    const Result result = renderer.render (results);
+
+    if (result.failed())
+        ConsoleApplication::fail (result.getErrorMessage());
+
+    const double blockBudget = 1000. * settings.blockSize / results.sampleRate;
+
+    cout << endl
+         << "file:           " << settings.csdFile.getFullPathName() << endl
+         << "sr / ksmps:     " << results.sampleRate << " / " << results.ksmps << endl
+         << "block size:     " << settings.blockSize << " (" << String (blockBudget, 3) << " ms)" << endl
+         << "audio:          " << String (results.numSamples / (double) results.sampleRate, 3) << " s in " << results.numBlocks << " blocks" << endl
+         << "render time:    " << String (results.renderSeconds, 3) << " s" << endl
+         << "realtime factor:" << String (results.realTimeFactor, 2) << "x" << endl
+         << "block time ms:  p50 " << String (results.blockMilliseconds[0], 3)
+         << ", p90 " << String (results.blockMilliseconds[1], 3)
+         << ", p99 " << String (results.blockMilliseconds[2], 3)
+         << ", max " << String (results.blockMilliseconds[3], 3) << endl
+         << "overruns:       " << results.numOverruns << endl;
+}
+
+int main (int argc, char* argv[])
+{
+    //the IDE still calls this with nothing but a csd file
+    if (argc == 2 && ! String (argv[1]).startsWith ("-"))
+        return runCrashTest (argv[1]);
+
+    ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage: CabbageCsoundCLI file.csd\n"
+                        "       CabbageCsoundCLI --render file.csd [options]\n\n"
+                        "Renders a csd headless, faster than real time, and prints the realtime factor,\n"
+                        "block time percentiles and the number of blocks that overran their duration.\n\n"
+                        "  --output=file.wav        write the output to a 24 bit WAV file\n"
+                        "  --input=silence|sine|noise|file.wav\n"
+                        "  --midi=file.mid          MIDI to play, from every track\n"
+                        "  --automation=file.txt    channel changes, one '<seconds> <channel> <value>' per line,\n"
+                        "                           sent before the block they fall in\n"
+                        "  --sr=44100               used unless the csd sets sr\n"
+                        "  --block=512              samples per block\n"
+                        "  --inputs=2 --outputs=2   channel layout\n"
+                        "  --duration=seconds       defaults to the length of the input, MIDI or automation,\n"
+                        "                           or 10 seconds\n"
+                        "  --quiet                  don't print Csound's messages", true);
+
+    app.addCommand ({ "--render", "--render file.csd [options]", "Renders a csd headless and reports its CPU cost", String(),
+                      [] (const ArgumentList& args) { render (args); } });
+
+    return app.findAndRunCommand (argc, argv);
+}
@@ -11,21 +11,331 @@
 #include <string>
  // #include <iomanip> 
 #include <fstream>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <cstring>
 // #include <iostream>
 #include "json.hpp"
-// #include <algorithm>
+#include <algorithm>
 #include "../CabbageCommonHeaders.h"
 using json = nlohmann::json;
 
-
+//====================================================================================================
+// Internal state used by the get/setStateValue opcodes. Values are kept in a typed key/value
+// store so that k-rate opcodes can read and write them through entries resolved at init time.
+// The JSON text is only rebuilt when it's needed, i.e. when saving plugin state or by readStateData
+//====================================================================================================
 class CabbagePersistentData
 {
 public:
-    
+    struct Entry
+    {
+        enum Type { empty, number, numberArray, string, stringArray, other };
+
+        explicit Entry (const std::string& entryKey) : key (entryKey) {}
+
+        const std::string key;
+        Type type = empty;
+        MYFLT value = 0;
+        std::vector<MYFLT> values;
+        std::string text;
+        std::vector<std::string> strings;
+        json otherValue;    //anything loaded from JSON that the opcodes can't read or write
+    };
+
     CabbagePersistentData(){}
-    
-    std::string data = "";
-    int size = 0;
+
+    //returns the global state object, creating it if needed and asked to
+    static CabbagePersistentData* get (csnd::Csound* csound, bool createIfNeeded)
+    {
+        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
+
+        if (pd == nullptr && createIfNeeded)
+        {
+            csound->create_global_variable("cabbageData", sizeof(CabbagePersistentData*));
+            pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
+            *pd = new CabbagePersistentData();
+            csound->message("Creating new internal state object...\n");
+        }
+
+        return pd != nullptr ? *pd : nullptr;
+    }
+
+    //entries are never removed, so the returned pointer stays valid for the lifetime of this object
+    Entry* getEntry (const std::string& key)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        return findOrCreateEntry (key);
+    }
+
+    //=================================================================================
+    void setNumber (Entry* entry, MYFLT newValue)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        entry->type = Entry::number;
+        entry->value = newValue;
+        jsonIsStale = true;
+    }
+
+    void setNumbers (Entry* entry, const MYFLT* newValues, int numValues)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        entry->type = Entry::numberArray;
+        entry->values.assign (newValues, newValues + numValues);
+        jsonIsStale = true;
+    }
+
+    void setString (Entry* entry, const char* newText)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        entry->type = Entry::string;
+        entry->text.assign (newText);
+        jsonIsStale = true;
+    }
+
+    void setStrings (Entry* entry, const STRINGDAT* newStrings, int numStrings)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        entry->type = Entry::stringArray;
+        entry->strings.resize (numStrings);
+
+        for (int i = 0; i < numStrings; i++)
+            entry->strings[i].assign (newStrings[i].data != nullptr ? newStrings[i].data : "");
+
+        jsonIsStale = true;
+    }
+
+    //=================================================================================
+    bool getNumber (const Entry* entry, MYFLT& result)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+
+        if (entry->type != Entry::number)
+            return false;
+
+        result = entry->value;
+        return true;
+    }
+
+    bool getNumbers (const Entry* entry, csnd::Csound* csound, csnd::Vector<MYFLT>& result)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+
+        if (entry->type != Entry::numberArray)
+            return false;
+
+        result.init (csound, (int)entry->values.size());
+        std::copy (entry->values.begin(), entry->values.end(), result.begin());
+        return true;
+    }
+
+    bool getString (const Entry* entry, csnd::Csound* csound, STRINGDAT& result)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+
+        if (entry->type != Entry::string)
+            return false;
+
+        copyToStringDat (csound, entry->text, result);
+        return true;
+    }
+
+    bool getStrings (const Entry* entry, csnd::Csound* csound, csnd::Vector<STRINGDAT>& result)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+
+        if (entry->type != Entry::stringArray)
+            return false;
+
+        result.init (csound, (int)entry->strings.size());
+
+        for (int i = 0; i < (int)entry->strings.size(); i++)
+            copyToStringDat (csound, entry->strings[i], result[i]);
+
+        return true;
+    }
+
+    //=================================================================================
+    //replaces, or merges into, the current state. Returns false if the text is not a JSON object
+    bool setJson (const std::string& jsonText, bool merge)
+    {
+        json j = json::object();
+
+        if (jsonText.empty() == false)
+        {
+            if (json::accept (jsonText) == false)
+                return false;
+
+            j = json::parse (jsonText);
+        }
+
+        if (j.is_object() == false)
+            return false;
+
+        const SpinLock::ScopedLockType sl (lock);
+
+        if (merge == false)
+            for (auto& entry : entries)
+                entry.second->type = Entry::empty;
+
+        for (json::iterator it = j.begin(); it != j.end(); ++it)
+            setEntryFromJson (*findOrCreateEntry (it.key()), it.value());
+
+        jsonIsStale = true;
+        return true;
+    }
+
+    //the values are copied while holding the lock the k-rate opcodes use, and the text is
+    //written out from the copy once it has been released
+    std::string getJson()
+    {
+        const ScopedLock jsonSl (jsonLock);
+        json j = json::object();
+        bool stale = false;
+
+        {
+            const SpinLock::ScopedLockType sl (lock);
+            stale = jsonIsStale;
+
+            if (stale)
+            {
+                for (auto& entry : entries)
+                {
+                    const Entry& e = *entry.second;
+
+                    if (e.type == Entry::number)                j[e.key] = e.value;
+                    else if (e.type == Entry::numberArray)      j[e.key] = e.values;
+                    else if (e.type == Entry::string)           j[e.key] = e.text;
+                    else if (e.type == Entry::stringArray)      j[e.key] = e.strings;
+                    else if (e.type == Entry::other)            j[e.key] = e.otherValue;
+                }
+
+                jsonIsStale = false;
+            }
+        }
+
+        if (stale)
+            jsonData = j.dump();
+
+        return jsonData;
+    }
+
+    bool isEmpty()
+    {
+        const SpinLock::ScopedLockType sl (lock);
+
+        for (auto& entry : entries)
+            if (entry.second->type != Entry::empty)
+                return false;
+
+        return true;
+    }
+
+private:
+    Entry* findOrCreateEntry (const std::string& key)
+    {
+        std::unique_ptr<Entry>& entry = entries[key];
+
+        if (entry == nullptr)
+            entry.reset (new Entry (key));
+
+        return entry.get();
+    }
+
+    static void setEntryFromJson (Entry& entry, const json& value)
+    {
+        entry.type = Entry::other;
+        entry.otherValue = json();
+
+        if (value.is_number())
+        {
+            entry.type = Entry::number;
+            entry.value = value.get<MYFLT>();
+        }
+        else if (value.is_string())
+        {
+            entry.type = Entry::string;
+            entry.text = value.get<std::string>();
+        }
+        else if (value.is_array())
+        {
+            const bool allNumbers = std::all_of (value.begin(), value.end(), [](const json& v) { return v.is_number(); });
+            const bool allStrings = std::all_of (value.begin(), value.end(), [](const json& v) { return v.is_string(); });
+
+            if (allNumbers)
+            {
+                entry.type = Entry::numberArray;
+                entry.values = value.get<std::vector<MYFLT>>();
+            }
+            else if (allStrings)
+            {
+                entry.type = Entry::stringArray;
+                entry.strings = value.get<std::vector<std::string>>();
+            }
+        }
+
+        if (entry.type == Entry::other)
+            entry.otherValue = value;
+    }
+
+    //reuses the string's existing memory when it is big enough
+    static void copyToStringDat (csnd::Csound* csound, const std::string& source, STRINGDAT& destination)
+    {
+        if (destination.data != nullptr && destination.size > (int)source.size())
+            std::memcpy (destination.data, source.c_str(), source.size() + 1);
+        else
+        {
+            destination.data = csound->strdup ((char*)source.c_str());
+            destination.size = (int)source.size() + 1;
+        }
+    }
+
+    SpinLock lock;
+    std::map<std::string, std::unique_ptr<Entry>> entries;
+    bool jsonIsStale = false;
+    //only used by getJson(), which the k-rate opcodes never call
+    CriticalSection jsonLock;
+    std::string jsonData = "{}";
+};
+
+//====================================================================================================
+// Each state opcode holds one of these. Csound doesn't construct opcode members, so it must
+// stay trivially constructible. The key is only looked up again when it changes
+//====================================================================================================
+struct CabbageStateHandle
+{
+    CabbagePersistentData* state;
+    CabbagePersistentData::Entry* entry;
+    bool reported;
+
+    bool resolve (csnd::Csound* csound, const char* key, bool createState)
+    {
+        if (state == nullptr)
+            state = CabbagePersistentData::get (csound, createState);
+
+        if (state == nullptr)
+            return false;
+
+        if (entry == nullptr || entry->key != key)
+        {
+            entry = state->getEntry (key);
+            reported = false;
+        }
+
+        return true;
+    }
+
+    //only print a given problem once per key, rather than on every k-cycle
+    void report (csnd::Csound* csound, const std::string& message)
+    {
+        if (reported == false)
+            csound->message (message);
+
+        reported = true;
+    }
 };
 
 //====================================================================================================
@@ -35,17 +345,15 @@ struct ReadStateData : csnd::Plugin<1, 1>
 {
     int init()
     {
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        if(pd != nullptr)
+        CabbagePersistentData* perData = CabbagePersistentData::get(csound, false);
+        if(perData != nullptr)
         {
-            auto perData = *pd;
-            //csound->message(perData->data);
-            if (perData->data.empty())
+            if (perData->isEmpty())
             {
                 csound->message("No data, temporary or persistent, has been written to internal state...\n");
             }
 
-            outargs.str_data(0).data = csound->strdup((char*)perData->data.c_str());
+            outargs.str_data(0).data = csound->strdup((char*)perData->getJson().c_str());
             return OK;
         }
         
@@ -67,43 +375,22 @@ struct WriteStateData : csnd::Plugin<1, 3>
 
     void writeJsonDataToGlobalVar()
     {
-
         std::string jsonString(inargs.str_data(1).data);
-        std::string jsonData = "";
         int mode = inargs[0];
-        json j;
 
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        auto perData = *pd;
-        if(perData != nullptr)
-        {
-            jsonData = perData->data;
-        }
-        else
+        CabbagePersistentData* perData = CabbagePersistentData::get(csound, false);
+        if(perData == nullptr)
         {
             csound->message("Internal JSON global var is not valid.\n");
             return;
         }
 
-        if (json::accept(jsonString) == false)
+        //mode 1 merges the new data into the existing state, otherwise it is replaced
+        if (perData->setJson(jsonString, mode == 1) == false)
         {
             csound->message("Invalid JSON data:" + jsonString + "\n");
             outargs[0] = -1;
-            return;
         }
-
-        if (mode == 1)
-        {
-                j = json::parse(jsonData);
-                auto j2 = json::parse(jsonString);
-                j.update(j2);
-        }
-        else
-        {
-            j = json::parse(jsonString);
-        }
-
-        perData->data = j.dump();
     }
 };
 
@@ -112,273 +399,102 @@ struct WriteStateData : csnd::Plugin<1, 3>
 //====================================================================================================
 struct SetStateFloatData : csnd::Plugin<1, 2>
 {
+    CabbageStateHandle handle;
+
     int init()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
 
     int kperf()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
     
-    bool writeJsonDataToGlobalVar()
+    int writeValue()
     {
-        
-        if (in_count() != 2)
-        {
-            return false;
-        }
-        
-        std::string jsonKeyName(inargs.str_data(0).data);
-        std::string jsonData;
-        MYFLT value = inargs[1];
-
-        json j;
-
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        CabbagePersistentData* perData;
-        if (pd != nullptr)
-        {
-            perData = *pd;
-            jsonData = perData->data;
-        }
-        else
-        {
-            csound->create_global_variable("cabbageData", sizeof(CabbagePersistentData*));
-            CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-            *pd = new CabbagePersistentData();
-            perData = *pd;
-            csound->message("Creating new internal state object...\n");
-            jsonData = "{}";
-        }
-
-        std::string newData = "{ \"" + jsonKeyName + "\" : " + std::to_string(value) + "}";
-
-        if (json::accept(newData) == false)
-        {
-            csound->message("Invalid JSON data:" + newData + "\n");
-            outargs[0] = -1;
-            return false;
-        }
-
-        j = json::parse(jsonData.empty() ? "{}" : jsonData);
-        auto j2 = json::parse(newData);
-        j.update(j2);
+        if (in_count() != 2 || handle.resolve(csound, inargs.str_data(0).data, true) == false)
+            return NOTOK;
 
-        perData->data = j.dump();
-        return true;
+        handle.state->setNumber(handle.entry, inargs[1]);
+        return OK;
     }
 };
 
 struct SetStateFloatArrayData : csnd::Plugin<1, 2>
 {
+    CabbageStateHandle handle;
+
     int init()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
     
     int kperf()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
     
-    bool writeJsonDataToGlobalVar()
+    int writeValue()
     {
-        if (in_count() != 2)
-        {
-            return false;
-        }
-        
-        std::string jsonKeyName(inargs.str_data(0).data);
-        std::string jsonData;
-        csnd::Vector<MYFLT>& args = inargs.myfltvec_data(1);
-
-        json j;
-
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        CabbagePersistentData* perData;
-        if (pd != nullptr)
-        {
-            perData = *pd;
-            jsonData = perData->data;
-        }
-        else
-        {
-            csound->create_global_variable("cabbageData", sizeof(CabbagePersistentData*));
-            CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-            *pd = new CabbagePersistentData();
-            perData = *pd;
-            csound->message("Creating new internal state object...\n");
-            jsonData = "{}";
-        }
-
-        std::string newData = "{ \"" + jsonKeyName + "\" : [";
-        for (int i = 0; i < args.len(); i++) {
-            newData += std::to_string(args[i]) + (i < args.len() - 1 ? ", " : "");
-        }
-        newData += "]}";
-
-        if (json::accept(newData) == false)
-        {
-            csound->message("Invalid JSON data:" + newData + "\n");
-            outargs[0] = -1;
-            return false;
-        }
-
-        j = json::parse(jsonData.empty() ? "{}" : jsonData);
-        auto j2 = json::parse(newData);
-        j.update(j2);
+        if (in_count() != 2 || handle.resolve(csound, inargs.str_data(0).data, true) == false)
+            return NOTOK;
 
-        perData->data = j.dump();
-        return true;
+        csnd::Vector<MYFLT>& args = inargs.myfltvec_data(1);
+        handle.state->setNumbers(handle.entry, args.begin(), args.len());
+        return OK;
     }
 };
 
 //====================================================================================================
-// Set float values 
+// Set string values 
 //====================================================================================================
 struct SetStateStringData : csnd::Plugin<1, 2>
 {
+    CabbageStateHandle handle;
+
     int init()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
     
     int kperf()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
     
-    bool writeJsonDataToGlobalVar()
+    int writeValue()
     {
-        
-        if (in_count() != 2)
-        {
-            return false;
-        }
-        
-        std::string jsonKeyName(inargs.str_data(0).data);
-        std::string jsonData;
-        std::string value(inargs.str_data(1).data);
+        if (in_count() != 2 || handle.resolve(csound, inargs.str_data(0).data, true) == false)
+            return NOTOK;
 
-        json j;
-
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        CabbagePersistentData* perData;
-        if (pd != nullptr)
-        {
-            perData = *pd;
-            jsonData = perData->data;
-        }
-        else
-        {
-            csound->create_global_variable("cabbageData", sizeof(CabbagePersistentData*));
-            CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-            *pd = new CabbagePersistentData();
-            perData = *pd;
-            csound->message("Creating new internal state object...\n");
-            jsonData = "{}";
-        }
-
-        std::string newData = "{ \"" + jsonKeyName + "\" : " + value + "}";
-
-        if (json::accept(newData) == false)
-        {
-            csound->message("Invalid JSON data:" + newData + "\n");
-            outargs[0] = -1;
-            return false;
-        }
-
-        j = json::parse(jsonData.empty() ? "{}" : jsonData);
-        auto j2 = json::parse(newData);
-        j.update(j2);
-
-        perData->data = j.dump();
-        return true;
-    }
-};
+        handle.state->setString(handle.entry, inargs.str_data(1).data);
+        return OK;
+    }
+};
 
 struct SetStateStringArrayData : csnd::Plugin<1, 2>
 {
+    CabbageStateHandle handle;
+
     int init()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
     
     int kperf()
     {
-        if(writeJsonDataToGlobalVar())
-            return OK;
-        else
-            return NOTOK;
+        return writeValue();
     }
     
-    bool writeJsonDataToGlobalVar()
+    int writeValue()
     {
-        std::string jsonKeyName(inargs.str_data(0).data);
-        std::string jsonData;
-        csnd::Vector<STRINGDAT>& strs = inargs.vector_data<STRINGDAT>(1);
-
-        json j;
-
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        CabbagePersistentData* perData;
-        if (pd != nullptr)
-        {
-            perData = *pd;
-            jsonData = perData->data;
-        }
-        else
-        {
-            csound->create_global_variable("cabbageData", sizeof(CabbagePersistentData*));
-            CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-            *pd = new CabbagePersistentData();
-            perData = *pd;
-            csound->message("Creating new internal state object...\n");
-            jsonData = "{}";
-        }
-
-        std::string newData = "{ \"" + jsonKeyName + "\" : [";
-        for (int i = 0; i < strs.len(); i++) {
-            newData += "\""+(strs[i].data + std::string(i < strs.len() - 1 ? "\", " : ""));
-        }
-        newData += "\"]}";
-
-        if (json::accept(newData) == false)
-        {
-            csound->message("Invalid JSON data:" + newData + "\n");
-            outargs[0] = -1;
-            return false;
-        }
-
-        j = json::parse(jsonData.empty() ? "{}" : jsonData);
-        auto j2 = json::parse(newData);
-        j.update(j2);
+        if (handle.resolve(csound, inargs.str_data(0).data, true) == false)
+            return NOTOK;
 
-        perData->data = j.dump();
-        return true;
+        csnd::Vector<STRINGDAT>& strs = inargs.vector_data<STRINGDAT>(1);
+        handle.state->setStrings(handle.entry, strs.begin(), strs.len());
+        return OK;
     }
 };
 //====================================================================================================
@@ -386,6 +502,8 @@ struct SetStateStringArrayData : csnd::Plugin<1, 2>
 //====================================================================================================
 struct GetStateStringValue : csnd::Plugin<1, 1>
 {
+    CabbageStateHandle handle;
+
     int init()
     {
         if (in_count() == 0)
@@ -399,63 +517,23 @@ struct GetStateStringValue : csnd::Plugin<1, 1>
 
     int kperf()
     {
-        if (in_count() == 0)
-        {
-            csound->message("Please pass a valid key...\n");
-            return NOTOK;
-        }
         readData();
         return OK;
     }
 
     void readData()
     {
-        std::string chString;
-        json j;
-        bool firstTimeSuccess = false;
-        std::string channelKey(inargs.str_data(0).data);
-        std::string jsonData;
-
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        auto perData = *pd;
-        if (perData != nullptr)
-        {
-            jsonData = perData->data;
-        }
-        else
-        {
-            csound->message("Internal JSON global var is not valid.\n");
-            return;
-        }
-
-        if (json::accept(jsonData) == false)
-        {
-            csound->message("Invalid JSON data:" + jsonData + "\n");
-            outargs.str_data(0).data = "";
-            return;
-        }
-
-        j = json::parse(jsonData);
-
-        for (json::iterator it = j.begin(); it != j.end(); ++it)
-        {
-            if (it.key() == channelKey && it.value().is_string())
-            {
-                outargs.str_data(0).data = csound->strdup((char*)it.value().dump().c_str());
-                firstTimeSuccess = true;
-            }
-        }
-
-        if (firstTimeSuccess == false)
-        {
-            csound->message("Could not find value for " + channelKey + "?\nCheck JSON channel data.\n");
-            firstTimeSuccess = true;
-        }
+        if (handle.resolve(csound, inargs.str_data(0).data, false) == false)
+            handle.report(csound, "Internal JSON global var is not valid.\n");
+        else if (handle.state->getString(handle.entry, csound, outargs.str_data(0)) == false)
+            handle.report(csound, "Could not find value for " + handle.entry->key + "?\nCheck JSON channel data.\n");
     }
 };
 
 struct GetStateStringValueArray : csnd::Plugin<1, 1>
 {
+    CabbageStateHandle handle;
+
     int init()
     {
         if (in_count() == 0)
@@ -469,70 +547,18 @@ struct GetStateStringValueArray : csnd::Plugin<1, 1>
 
     int kperf()
     {
-        if (in_count() == 0)
-        {
-            csound->message("Please pass a valid key...\n");
-            return NOTOK;
-        }
         readData();
         return OK;
     }
 
     void readData()
     {
-        std::string chString;
-        json j;
-        MYFLT* value;
-        bool firstTimeSuccess = false;
-        std::string channelKey(inargs.str_data(0).data);
-        std::string jsonData;
-
         csnd::Vector<STRINGDAT>& out = outargs.vector_data<STRINGDAT>(0);
 
-
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        auto perData = *pd;
-        if (perData != nullptr)
-        {
-            jsonData = perData->data;
-        }
-        else
-        {
-            csound->message("Internal JSON global var is not valid.\n");
-            return;
-        }
-
-
-        if (json::accept(jsonData) == false)
-        {
-            csound->message("Invalid JSON data:" + jsonData + "\n");
-            out.init(csound, 1);
-            out[0].data = "";
-            return;
-        }
-
-        j = json::parse(jsonData);
-
-        for (json::iterator it = j.begin(); it != j.end(); ++it)
-        {
-            if (it.key() == channelKey && it.value().is_array())
-            {
-                out.init(csound, (int)it.value().size());
-                int index = 0;
-                for (json::iterator tt = it.value().begin(); tt != it.value().end(); ++tt)
-                {
-                    if (tt.value().is_string())
-                        out[index++].data = csound->strdup((char*)tt.value().dump().c_str());
-                }
-                firstTimeSuccess = true;
-            }
-        }
-
-        if (firstTimeSuccess == false)
-        {
-            csound->message("Could not find value for " + channelKey + ". Check JSON channel data.\n");
-            firstTimeSuccess = true;
-        }
+        if (handle.resolve(csound, inargs.str_data(0).data, false) == false)
+            handle.report(csound, "Internal JSON global var is not valid.\n");
+        else if (handle.state->getStrings(handle.entry, csound, out) == false)
+            handle.report(csound, "Could not find value for " + handle.entry->key + ". Check JSON channel data.\n");
     }
 };
 
@@ -541,6 +567,8 @@ struct GetStateStringValueArray : csnd::Plugin<1, 1>
 //====================================================================================================
 struct GetStateFloatValue : csnd::Plugin<1, 1>
 {
+    CabbageStateHandle handle;
+
     int init()
     {
         if (in_count() == 0)
@@ -553,6 +581,29 @@ struct GetStateFloatValue : csnd::Plugin<1, 1>
     }
 
     int kperf()
+    {
+        readData();
+        return OK;
+    }
+
+    void readData()
+    {
+        MYFLT value = 0;
+
+        if (handle.resolve(csound, inargs.str_data(0).data, false) == false)
+            handle.report(csound, "Internal JSON global var is not valid.\n");
+        else if (handle.state->getNumber(handle.entry, value))
+            outargs[0] = value;
+        else
+            handle.report(csound, "Could not find value for " + handle.entry->key + "?\nCheck JSON channel data.\n");
+    }
+};
+
+struct GetStateFloatValueArray : csnd::Plugin<1, 1>
+{
+    CabbageStateHandle handle;
+
+    int init()
     {
         if (in_count() == 0)
         {
@@ -563,442 +614,1423 @@ struct GetStateFloatValue : csnd::Plugin<1, 1>
         return OK;
     }
 
+    int kperf()
+    {
+        readData();
+        return OK;
+    }
+
     void readData()
     {
-        std::string chString;
+        csnd::Vector<MYFLT>& out = outargs.myfltvec_data(0);
+
+        if (handle.resolve(csound, inargs.str_data(0).data, false) == false)
+            handle.report(csound, "Internal JSON global var is not valid.\n");
+        else if (handle.state->getNumbers(handle.entry, csound, out) == false)
+            handle.report(csound, "Could not find value for " + handle.entry->key + "?\nCheck JSON channel data.\n");
+    }
+};
+
+
+//===========================================================================
+// Channel State Save/Recall
+//===========================================================================
+struct ChannelStateFile
+{
+    static bool write (const std::string& filename, const json& j)
+    {
+        std::ofstream file;
+        file.open(String(filename).replace("\\\\", "/").toStdString());
+        const bool isOpen = file.is_open();
+
+        file << std::setw(4) << j << std::endl;
+        file.close();
+        return isOpen;
+    }
+
+    //reads a saved state, leaving out any channels in ignoreStrings
+    static bool read (const std::string& filename, const std::vector<std::string>& ignoreStrings, json& result)
+    {
+        std::ifstream file(filename);
+        if (file.fail())
+            return false;
+
         json j;
-        MYFLT* value;
-        bool firstTimeSuccess = false;
-        std::string channelKey(inargs.str_data(0).data);
-        std::string jsonData;
+        j << file;
+        file.close();
 
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        auto perData = *pd;
-        if (perData != nullptr)
-        {
-            jsonData = perData->data;
-        }
-        else
-        {
-            csound->message("Internal JSON global var is not valid.\n");
-            return;
-        }
+        result = json::object();
 
-        
-        if (json::accept(jsonData) == false)
+        for (json::iterator it = j.begin(); it != j.end(); ++it)
         {
-            csound->message("Invalid JSON data:" + jsonData + "\n");
-            outargs[0] = -1;
-            return;
+            if (std::find(ignoreStrings.begin(), ignoreStrings.end(), it.key()) == ignoreStrings.end())
+                result[it.key()] = it.value();
         }
 
-        j = json::parse(jsonData);
+        return true;
+    }
 
-        for (json::iterator it = j.begin(); it != j.end(); ++it)
+    //a channel that a recalled state is written to, looked up before it is applied
+    struct Channel
+    {
+        MYFLT* channel;
+        bool isString;
+        MYFLT value;
+        char* text;         //allocated by Csound, handed to the channel if its own buffer is too small
+        int textSize;
+    };
+
+    //looks the channels up and copies the strings, so that apply() only has to copy values
+    static void resolve (csnd::Csound* csound, const json& j, std::vector<Channel>& channels, std::vector<char*>& retired)
+    {
+        MYFLT* value;
+
+        for (json::const_iterator it = j.begin(); it != j.end(); ++it)
         {
-            if (it.key() == channelKey && it.value().is_number_float())
+            if (it.value().is_number_float())
+            {
+                if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, it.key().c_str(),
+                    CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
+                {
+                    channels.push_back ({ value, false, it.value().get<MYFLT>(), nullptr, 0 });
+                }
+            }
+            else if (it.value().is_string())
             {
-                outargs[0] = it.value();
-                firstTimeSuccess = true;
+                if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, it.key().c_str(),
+                    CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
+                {
+                    const std::string& string = it.value().get_ref<const std::string&>();
+                    channels.push_back ({ value, true, 0, csound->strdup((char*)string.c_str()), (int)string.size() + 1 });
+                }
             }
         }
 
-        if (firstTimeSuccess == false)
+        //apply() can retire one buffer per channel, and mustn't allocate to do it
+        retired.reserve (channels.size());
+    }
+
+    //copies the values into the channels. A string channel whose buffer is too small takes
+    //over the prepared copy, and its old buffer is left in retired for release() to free
+    static void apply (std::vector<Channel>& channels, std::vector<char*>& retired)
+    {
+        for (auto& channel : channels)
         {
-            csound->message("Could not find value for "+ channelKey + "?\nCheck JSON channel data.\n");
-            firstTimeSuccess = true;
+            if (channel.isString == false)
+            {
+                *channel.channel = channel.value;
+                continue;
+            }
+
+            STRINGDAT* string = (STRINGDAT*)channel.channel;
+
+            if (string->data != nullptr && string->size >= channel.textSize)
+                std::memcpy (string->data, channel.text, (size_t)channel.textSize);
+            else
+            {
+                retired.push_back (string->data);
+                string->data = channel.text;
+                string->size = channel.textSize;
+                channel.text = nullptr;
+            }
         }
     }
+
+    //frees the copies apply() didn't use, and the buffers it replaced
+    static void release (csnd::Csound* csound, std::vector<Channel>& channels, std::vector<char*>& retired)
+    {
+        for (auto& channel : channels)
+            if (channel.text != nullptr)
+                csound->free (channel.text);
+
+        for (auto* text : retired)
+            if (text != nullptr)
+                csound->free (text);
+
+        channels.clear();
+        retired.clear();
+    }
 };
 
-struct GetStateFloatValueArray : csnd::Plugin<1, 1>
+//===========================================================================
+// A save or recall request made by a k-rate channelStateSave/channelStateRecall.
+// Everything the worker thread needs is allocated when the opcode is initialised
+//===========================================================================
+class ChannelStateJob : public ReferenceCountedObject
 {
-    int init()
+public:
+    enum Status { idle, pending, done };
+
+    explicit ChannelStateJob (csnd::Csound* cs) : csound (cs) {}
+
+    ~ChannelStateJob()
     {
-        if (in_count() == 0)
-        {
-            csound->message("Please pass a valid key...\n");
-            return NOTOK;
-        }
-        readData();
-        return OK;
+        ChannelStateFile::release (csound, recalledChannels, retiredStrings);
     }
 
-    int kperf()
+    csnd::Csound* const csound;
+    bool isSave = true;
+    std::string filename;
+
+    //save: the channels that existed at init time, and their values at the last k-boundary
+    std::vector<std::string> names;
+    std::vector<MYFLT*> channelPtrs;
+    std::vector<bool> isStringChannel;
+    std::vector<MYFLT> values;
+    std::vector<std::string> strings;
+
+    //recall: read and resolved by the worker thread, and copied into the channels at a k-boundary.
+    //The buffers that replaced channel strings are freed by the worker when it next runs the job
+    std::vector<std::string> ignoreStrings;
+    std::vector<ChannelStateFile::Channel> recalledChannels;
+    std::vector<char*> retiredStrings;
+
+    std::atomic<int> status { idle };
+    int result = 0;
+};
+
+//===========================================================================
+// Does the file I/O for the k-rate channel state opcodes. Jobs are passed in
+// through a lock-free fifo and the worker marks them done when finished. One
+// instance per Csound, deleted when Csound is reset.
+//===========================================================================
+class ChannelStateIOThread : public Thread
+{
+public:
+    ChannelStateIOThread() : Thread ("Cabbage channel state I/O")
     {
-        if (in_count() == 0)
+        startThread();
+    }
+
+    ~ChannelStateIOThread()
+    {
+        stopThread (2000);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; i++)     jobs[start1 + i]->decReferenceCount();
+        for (int i = 0; i < size2; i++)     jobs[start2 + i]->decReferenceCount();
+
+        fifo.finishedRead (size1 + size2);
+    }
+
+    static ChannelStateIOThread* get (csnd::Csound* csound)
+    {
+        ChannelStateIOThread** io = (ChannelStateIOThread**)csound->query_global_variable("cabbageChannelStateIO");
+
+        if (io == nullptr)
         {
-            csound->message("Please pass a valid key...\n");
-            return NOTOK;
+            csound->create_global_variable("cabbageChannelStateIO", sizeof(ChannelStateIOThread*));
+            io = (ChannelStateIOThread**)csound->query_global_variable("cabbageChannelStateIO");
+            *io = new ChannelStateIOThread();
+            csound->get_csound()->RegisterResetCallback(csound->get_csound(), *io, deleteOnReset);
         }
-        readData();
-        return OK;
+
+        return *io;
     }
 
-    void readData()
+    //called at k-rate. Returns false, without blocking, if the job can't be queued this cycle
+    bool addJob (ChannelStateJob* job)
     {
-        std::string chString;
-        json j;
-        MYFLT* value;
-        bool firstTimeSuccess= false;
-        std::string channelKey(inargs.str_data(0).data);
-        std::string jsonData;
+        //Csound may run instruments on several threads, so only one of them can write at a time
+        const GenericScopedTryLock<SpinLock> tryLock (writeLock);
 
-        csnd::Vector<MYFLT>& out = outargs.myfltvec_data(0);
+        if (! tryLock.isLocked())
+            return false;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+            return false;
+
+        job->incReferenceCount();
+        job->status = ChannelStateJob::pending;
+        jobs[start1] = job;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead (1, start1, size1, start2, size2);
+
+            if (size1 == 0)
+            {
+                wait (10);
+                continue;
+            }
+
+            ChannelStateJob* job = jobs[start1];
+            fifo.finishedRead (1);
+
+            if (job->isSave)
+            {
+                json j;
+
+                for (size_t i = 0; i < job->names.size(); i++)
+                {
+                    if (job->isStringChannel[i])
+                        j[job->names[i]] = String(job->strings[i]).replace("\\\\", "/").toStdString();
+                    else
+                        j[job->names[i]] = job->values[i];
+                }
+
+                job->result = ChannelStateFile::write(job->filename, j) ? 1 : 0;
+            }
+            else
+            {
+                json j;
+                ChannelStateFile::release(job->csound, job->recalledChannels, job->retiredStrings);
+                job->result = ChannelStateFile::read(job->filename, job->ignoreStrings, j) ? 1 : 0;
+
+                if (job->result == 1)
+                    ChannelStateFile::resolve(job->csound, j, job->recalledChannels, job->retiredStrings);
+            }
+
+            job->status = ChannelStateJob::done;
+            job->decReferenceCount();
+        }
+    }
+
+private:
+    static int deleteOnReset (CSOUND*, void* userData)
+    {
+        delete (ChannelStateIOThread*) userData;
+        return 0;
+    }
+
+    enum { fifoSize = 64 };
+    AbstractFifo fifo { fifoSize };
+    ChannelStateJob* jobs[fifoSize] = {};
+    SpinLock writeLock;
+};
+
+//===========================================================================
+// i-rate versions, these do their file access straight away
+//===========================================================================
+struct ChannelStateSave : csnd::Plugin<1, 1>
+{
+    int init()
+    {
+        writeDataToDisk();
+        return OK;
+    }
+
+    void writeDataToDisk()
+    {
+        json j;
+
+        controlChannelInfo_s* csoundChanList;
+        int numberOfChannels = csound->get_csound()->ListChannels(csound->get_csound(), &csoundChanList);
+
+        for (int i = 0; i < numberOfChannels; i++)
+        {
+            //            const float min = csoundChanList[i].hints.min;
+            //            const float max = (csoundChanList[i].hints.max == 0 ? 1 : csoundChanList[i].hints.max);
+            //            const float defaultValue = csoundChanList[i].hints.dflt;
+            std::string name;
+
+            MYFLT* value;
+            char* chString;
+
+            if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, csoundChanList[i].name,
+                CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
+            {
+                j[csoundChanList[i].name] = *value;
+            }
+
+            if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, csoundChanList[i].name,
+                CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
+            {
+                chString = ((STRINGDAT*)value)->data;
+                String s(chString);
+                j[csoundChanList[i].name] = s.replace("\\\\", "/").toStdString();
+            }
+        }
+
+        if (numberOfChannels > 0)
+            csound->get_csound()->DeleteChannelList(csound->get_csound(), csoundChanList);
+
+        outargs[0] = ChannelStateFile::write(inargs.str_data(0).data, j) ? 1 : 0;
+        csound->message(j.dump());
+    }
+
+};
+
+
+struct ChannelStateRecall : csnd::Plugin<1, 2>
+{
+    int init()
+    {
+        readDataFromDisk();
+        return OK;
+    }
+
+    void readDataFromDisk()
+    {
+        json j;
+        std::vector<std::string> ignoreStrings;
+
+        if (inargs[1] != 0)
+        {
+            csnd::Vector<STRINGDAT>& in = inargs.vector_data<STRINGDAT>(1);
+            for (int i = 0; i < in.len(); i++)
+            {
+                ignoreStrings.push_back(std::string(in[i].data));
+            }
+        }
+
+        if (ChannelStateFile::read(inargs.str_data(0).data, ignoreStrings, j) == false)
+        {
+            csound->message("Unable to open file");
+            outargs[0] = 0;
+            return;
+        }
+
+        std::vector<ChannelStateFile::Channel> channels;
+        std::vector<char*> retired;
+        ChannelStateFile::resolve(csound, j, channels, retired);
+        ChannelStateFile::apply(channels, retired);
+        ChannelStateFile::release(csound, channels, retired);
+        outargs[0] = 1;
+        csound->message(j.dump());
+    }
+
+};
+
+//===========================================================================
+// k-rate versions. The opcode hands a job to the I/O thread and returns straight
+// away. Its output is updated with the result on the k-cycle after the job finishes.
+// Channels are snapshotted at a k-boundary, and recalled values applied at one.
+//===========================================================================
+struct ChannelStateSaveAsync : csnd::Plugin<1, 1>
+{
+    ChannelStateJob* job;
+    ChannelStateIOThread* io;
+
+    int init()
+    {
+        csound->plugin_deinit(this);
+        io = ChannelStateIOThread::get(csound);
+        job = new ChannelStateJob(csound);
+        job->incReferenceCount();
+        job->filename = inargs.str_data(0).data;
+
+        //resolve the channels once, so that each k-cycle only has to copy their values
+        controlChannelInfo_s* csoundChanList;
+        int numberOfChannels = csound->get_csound()->ListChannels(csound->get_csound(), &csoundChanList);
+
+        for (int i = 0; i < numberOfChannels; i++)
+        {
+            MYFLT* value;
+
+            if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, csoundChanList[i].name,
+                CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
+            {
+                job->names.push_back(csoundChanList[i].name);
+                job->channelPtrs.push_back(value);
+                job->isStringChannel.push_back(false);
+            }
+            else if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, csoundChanList[i].name,
+                CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
+            {
+                job->names.push_back(csoundChanList[i].name);
+                job->channelPtrs.push_back(value);
+                job->isStringChannel.push_back(true);
+            }
+        }
+
+        if (numberOfChannels > 0)
+            csound->get_csound()->DeleteChannelList(csound->get_csound(), csoundChanList);
+
+        job->values.resize(job->names.size());
+        job->strings.resize(job->names.size());
+
+        for (auto& string : job->strings)
+            string.reserve(256);
+
+        outargs[0] = 0;
+        return OK;
+    }
+
+    int kperf()
+    {
+        if (job->status == ChannelStateJob::pending)
+            return OK;
+
+        if (job->status == ChannelStateJob::done)
+            outargs[0] = job->result;
+
+        for (size_t i = 0; i < job->names.size(); i++)
+        {
+            if (job->isStringChannel[i])
+            {
+                const char* chString = ((STRINGDAT*)job->channelPtrs[i])->data;
+                job->strings[i].assign(chString != nullptr ? chString : "");
+            }
+            else
+                job->values[i] = *job->channelPtrs[i];
+        }
+
+        if (io->addJob(job) == false)
+            job->status = ChannelStateJob::idle;
+
+        return OK;
+    }
+
+    int deinit()
+    {
+        job->decReferenceCount();
+        return OK;
+    }
+};
+
+struct ChannelStateRecallAsync : csnd::Plugin<1, 2>
+{
+    ChannelStateJob* job;
+    ChannelStateIOThread* io;
+
+    int init()
+    {
+        csound->plugin_deinit(this);
+        io = ChannelStateIOThread::get(csound);
+        job = new ChannelStateJob(csound);
+        job->incReferenceCount();
+        job->isSave = false;
+        job->filename = inargs.str_data(0).data;
+
+        if (inargs[1] != 0)
+        {
+            csnd::Vector<STRINGDAT>& in = inargs.vector_data<STRINGDAT>(1);
+            for (int i = 0; i < in.len(); i++)
+            {
+                job->ignoreStrings.push_back(std::string(in[i].data));
+            }
+        }
+
+        outargs[0] = 0;
+        return OK;
+    }
+
+    int kperf()
+    {
+        if (job->status == ChannelStateJob::pending)
+            return OK;
+
+        if (job->status == ChannelStateJob::done)
+        {
+            if (job->result == 1)
+                ChannelStateFile::apply(job->recalledChannels, job->retiredStrings);
+            else
+                csound->message("Unable to open file");
+
+            outargs[0] = job->result;
+        }
+
+        if (io->addJob(job) == false)
+            job->status = ChannelStateJob::idle;
+
+        return OK;
+    }
+
+    int deinit()
+    {
+        job->decReferenceCount();
+        return OK;
+    }
+};
+
+//===========================================================================
+// FileToStr
+//===========================================================================
+struct FileToStr : csnd::Plugin<1, 1>
+{
+    int init()
+    {
+        std::string line;
+        std::string lines;
+        char* fileName = inargs.str_data(0).data;
+        std::ifstream fileStream(fileName);
+
+        if (fileStream.is_open())
+        {
+            while (getline(fileStream, line))
+            {
+                lines.append(line);
+                lines.append("\n");
+            }
+        }
+        else
+        {
+            csound->message("fileToStr could not open file for reading");
+            return NOTOK;
+        }
+
+        fileStream.close();
+        outargs.str_data(0).data = csound->strdup((char*)lines.c_str());
+        return OK;
+    }
+};
+
+//===========================================================================
+//removes a number of occurrences of one string from another
+//===========================================================================
+struct StrRemove : csnd::Plugin<1, 3>
+{
+    int init()
+    {
+        return parseStringAndFillStruct(this);
+    }
+
+    int parseStringAndFillStruct(Plugin* opcodeData)
+    {
+        int occurrences = -1;
+        int strsRemoved = 0;
+        char* inString = opcodeData->inargs.str_data(0).data;
+        char* inStripString = opcodeData->inargs.str_data(1).data;
+
+        if (opcodeData->in_count() > 2)
+            occurrences = opcodeData->inargs[2];
+
+        std::string input(inString);
+        std::string stripString(inStripString);
+        std::string::size_type index = input.find(stripString);
+
+        while (index != std::string::npos)
+        {
+            input.erase(index, stripString.length());
+            index = input.find(stripString, index);
+            strsRemoved += 1;
+
+            if (strsRemoved == occurrences)
+                break;
+        }
+
+        opcodeData->outargs.str_data(0).data = csound->strdup((char*)input.c_str());
+
+        return OK;
+    }
+};
+
+//===========================================================================
+// StrToArray
+//===========================================================================
+struct StrToArray : csnd::Plugin<1, 2>
+{
+    int init()
+    {
+        return parseStringAndFillStruct();
+    }
+
+    int parseStringAndFillStruct()
+    {
+        csnd::Vector<STRINGDAT>& out = outargs.vector_data<STRINGDAT>(0);
+
+        char* inString = inargs.str_data(0).data;
+        char* inStringDeLimiter = inargs.str_data(1).data;
+
+
+        std::string input(inString);
+        std::string delimiter(inStringDeLimiter);
+        std::vector<std::string> tokens;
+
+        size_t pos = 0;
+
+        while ((pos = input.find(delimiter)) != std::string::npos)
+        {
+            tokens.push_back(input.substr(0, pos));
+            input.erase(0, pos + delimiter.length());
+        }
+
+        if (input.size() > 0)
+            tokens.push_back(input);
+
+        out.init(csound, (int)tokens.size());
+
+        for (int i = 0; i < tokens.size(); i++)
+        {
+            out[i].data = csound->strdup((char*)tokens[i].c_str());
+        }
+
+        tokens.clear();
+        return OK;
+    }
+};
+//===========================================================================
+// StrToFile
+//===========================================================================
+
+struct StrToFile : csnd::Plugin<1, 3>
+{
+    int init()
+    {
+
+        int mode = 0;
+        if (in_count() < 2)
+        {
+            csound->message("You did not pass have enough arguments to strtofile\n");
+            return NOTOK;
+        }
+
+        char* inString = inargs.str_data(0).data;
+        char* fileName = inargs.str_data(1).data;
+
+
+        if (in_count() > 2)
+            mode = inargs[2];
+
+        std::ofstream fileStream;
+
+        if (mode == 1)
+        {
+            fileStream.open(fileName, std::ios::in | std::ios::app);
+        }
+        else
+            fileStream.open(fileName, std::ios::in | std::ios::trunc);
+
+        fileStream << inString;
+
+        if (!fileStream.is_open())
+        {
+            csound->message("*** strToFile could not open file for writing ***");
+            outargs[0] = 0;
+        }
+
+        fileStream.close();
+        outargs[0] = 1;
+        return OK;
+    }
+};
+
+//===========================================================================
+// An object shared by the host and the orchestra through a Csound global
+// variable. The host creates it when it compiles the instance, so opcodes only
+// ever look it up, and Csound deletes it when the instance is reset.
+//===========================================================================
+template <typename ObjectType>
+struct CsoundGlobalObject
+{
+    //called by the processor before the instance performs
+    static ObjectType* create (CSOUND* csound, const char* name)
+    {
+        if (ObjectType* existing = find (csound, name))
+            return existing;
+
+        csound->CreateGlobalVariable(csound, name, sizeof(ObjectType*));
+        ObjectType** object = (ObjectType**)csound->QueryGlobalVariable(csound, name);
+        *object = new ObjectType();
+        csound->RegisterResetCallback(csound, *object, deleteOnReset);
+        return *object;
+    }
+
+    static ObjectType* find (CSOUND* csound, const char* name)
+    {
+        ObjectType** object = (ObjectType**)csound->QueryGlobalVariable(csound, name);
+        return object != nullptr ? *object : nullptr;
+    }
+
+private:
+    static int deleteOnReset (CSOUND*, void* userData)
+    {
+        delete (ObjectType*) userData;
+        return 0;
+    }
+};
+
+//===========================================================================
+// Function table changes reported by the orchestra through tableChanged, so
+// that gentable widgets only need to redraw what was written. Each reported
+// table has a slot holding the union of what was written to it since the
+// reader last looked, so repeated reports merge instead of queueing up. One
+// instance per Csound, deleted when Csound is reset.
+//===========================================================================
+class TableChangeQueue
+{
+public:
+    struct Change
+    {
+        int tableNumber, start, end;
+    };
+
+    static TableChangeQueue* create (CSOUND* csound)
+    {
+        return CsoundGlobalObject<TableChangeQueue>::create (csound, "cabbageTableChanges");
+    }
+
+    //returns nullptr if the instance wasn't compiled by a Cabbage processor
+    static TableChangeQueue* find (CSOUND* csound)
+    {
+        return CsoundGlobalObject<TableChangeQueue>::find (csound, "cabbageTableChanges");
+    }
+
+    //called at k-rate, from any performance thread. end is exclusive, and -1 means the end of the
+    //table. If there is no slot left for the table the reader is told to check every reported table
+    void add (int tableNumber, int start, int end)
+    {
+        if (tableNumber <= 0)
+            return;
+
+        Slot* slot = getSlot (tableNumber);
+
+        if (slot == nullptr)
+        {
+            changesLost = true;
+            return;
+        }
+
+        const uint64 range = packRange (jmax (0, start), end < 0 ? std::numeric_limits<int>::max() : end);
+        uint64 current = slot->range.load();
+
+        while (! slot->range.compare_exchange_weak (current, mergeRanges (current, range)))
+        {}
+    }
+
+    //called on the message thread, once for each table written since the last call. Returns true
+    //if changes were dropped, in which case every reported table should be checked in full
+    template <typename Callback>
+    bool readAll (Callback&& callback)
+    {
+        for (auto& slot : slots)
+        {
+            const int tableNumber = slot.tableNumber.load();
+
+            if (tableNumber == 0)
+                continue;
+
+            const uint64 range = slot.range.exchange (0);
+
+            if (range != 0)
+                callback (Change { tableNumber, (int) (range >> 32), (int) (range & 0xffffffff) });
+        }
+
+        return changesLost.exchange (false);
+    }
+
+private:
+    //a table keeps its slot until Csound is reset. range packs start and end, and 0 means clean
+    struct Slot
+    {
+        std::atomic<int> tableNumber { 0 };
+        std::atomic<uint64> range { 0 };
+    };
+
+    enum { maxTables = 256 };
+    Slot slots[maxTables];
+    std::atomic<bool> changesLost { false };
+
+    Slot* getSlot (int tableNumber)
+    {
+        for (int i = 0; i < maxTables; i++)
+        {
+            Slot& slot = slots[((uint32) tableNumber + (uint32) i) % maxTables];
+            int owner = 0;
+
+            if (slot.tableNumber.compare_exchange_strong (owner, tableNumber) || owner == tableNumber)
+                return &slot;
+        }
+
+        return nullptr;
+    }
+
+    static uint64 packRange (int start, int end)
+    {
+        return start < end ? ((uint64) start << 32) | (uint64) end : 0;
+    }
+
+    static uint64 mergeRanges (uint64 a, uint64 b)
+    {
+        if (a == 0 || b == 0)
+            return a | b;
+
+        return jmin (a >> 32, b >> 32) << 32 | jmax (a & 0xffffffff, b & 0xffffffff);
+    }
+};
+
+//===========================================================================
+// tableChanged ifn [, kstart, kend]
+// Tells gentable widgets which part of a table has been written to. kend is
+// exclusive, and -1 means the end of the table. The k-rate version reports the
+// change every k-cycle it runs, the i-rate version once at init time
+//===========================================================================
+struct TableChanged : csnd::Plugin<0, 3>
+{
+    TableChangeQueue* queue = nullptr;
+
+    int init()
+    {
+        queue = TableChangeQueue::find (csound->get_csound());
+        return OK;
+    }
+
+    int kperf()
+    {
+        if (queue != nullptr)
+            queue->add ((int)inargs[0], (int)inargs[1], (int)inargs[2]);
+
+        return OK;
+    }
+};
+
+struct TableChangedInit : TableChanged
+{
+    int init()
+    {
+        TableChanged::init();
+        return kperf();
+    }
+};
+
+//===========================================================================
+// Widget property changes made by the orchestra through cabbageSet. Widgets
+// and identifiers are looked up by name once, at init time, and each widget
+// and identifier pair gets a slot holding its latest values. A slot is queued
+// at most once, so updates merge as they are sent and the newest values always
+// reach the processor, which applies them once per GUI update. One instance
+// per Csound, deleted when Csound is reset.
+//===========================================================================
+class WidgetUpdateQueue
+{
+public:
+    enum PropertyType { invalid, number, position, size, rotate, bounds, colour };
+
+    struct Update
+    {
+        int widget, property;   //ids returned by getNameId()
+        PropertyType type;
+        MYFLT values[4];
+    };
+
+    static WidgetUpdateQueue* create (CSOUND* csound)
+    {
+        return CsoundGlobalObject<WidgetUpdateQueue>::create (csound, "cabbageWidgetUpdates");
+    }
+
+    //returns nullptr if the instance wasn't compiled by a Cabbage processor
+    static WidgetUpdateQueue* find (CSOUND* csound)
+    {
+        return CsoundGlobalObject<WidgetUpdateQueue>::find (csound, "cabbageWidgetUpdates");
+    }
+
+    //the identifiers that can be set, and how many values each one takes. Colours take
+    //three or four, with the alpha defaulting to 255
+    static PropertyType getPropertyType (const std::string& identifier)
+    {
+        static const std::map<std::string, PropertyType> types = []
+        {
+            std::map<std::string, PropertyType> t;
+
+            for (auto* name : { "active", "alpha", "corners", "fill", "increment", "latched", "linethickness",
+                                "markerend", "markerstart", "markerthickness", "outlinethickness", "pivotx", "pivoty",
+                                "trackerinsideradius", "trackeroutsideradius", "trackerthickness", "value", "valuex",
+                                "valuey", "visible", "zoom" })
+                t[name] = number;
+
+            for (auto* name : { "colour", "colour:0", "colour:1", "fontcolour", "fontcolour:0", "fontcolour:1",
+                                "menucolour", "tablebackgroundcolour", "overlaycolour", "backgroundcolour",
+                                "keyseparatorcolour", "blacknotecolour", "keydowncolour", "whitenotecolour",
+                                "mouseoverkeycolour", "arrowbackgroundcolour", "arrowcolour", "ballcolour",
+                                "fillcolour", "tablegridcolour", "trackercolour", "trackerbgcolour", "highlightcolour",
+                                "activecellcolour", "titlebarcolour", "outlinecolour", "textcolour", "textboxcolour",
+                                "textboxoutlinecolour", "markercolour" })
+                t[name] = colour;
+
+            t["pos"] = position;
+            t["size"] = size;
+            t["rotate"] = rotate;
+            t["bounds"] = bounds;
+            return t;
+        }();
+
+        auto it = types.find (identifier);
+        return it != types.end() ? it->second : invalid;
+    }
+
+    static int getNumValues (PropertyType type)
+    {
+        switch (type)
+        {
+            case number:    return 1;
+            case position:
+            case size:      return 2;
+            case rotate:    return 3;
+            case bounds:
+            case colour:    return 4;
+            default:        return 0;
+        }
+    }
+
+    //called at init time. Names are never removed, so an id stays valid for the lifetime of the queue
+    int getNameId (const std::string& name)
+    {
+        const SpinLock::ScopedLockType sl (namesLock);
+        auto it = std::find (names.begin(), names.end(), name);
+
+        if (it != names.end())
+            return (int)(it - names.begin());
+
+        names.push_back (name);
+        return (int)names.size() - 1;
+    }
+
+    //called on the message thread
+    std::string getName (int nameId)
+    {
+        const SpinLock::ScopedLockType sl (namesLock);
+        return isPositiveAndBelow (nameId, (int)names.size()) ? names[nameId] : std::string();
+    }
+
+    //called at init time. Returns -1 once every slot has been handed out
+    int getSlotId (int widget, int property, PropertyType type)
+    {
+        const SpinLock::ScopedLockType sl (namesLock);
+
+        for (int i = 0; i < numSlots; i++)
+            if (slots[i].widget == widget && slots[i].property == property)
+                return i;
+
+        if (numSlots == maxSlots)
+            return -1;
+
+        slots[numSlots].widget = widget;
+        slots[numSlots].property = property;
+        slots[numSlots].type = type;
+        return numSlots++;
+    }
+
+    //called at k-rate, with getNumValues() values for the slot's type
+    void set (int slotId, const MYFLT* values)
+    {
+        Slot& slot = slots[slotId];
+
+        {
+            //the version is odd while the values are being written, so the reader can tell
+            const SpinLock::ScopedLockType sl (slot.writeLock);
+            const uint32 version = slot.version.load (std::memory_order_relaxed);
+            slot.version.store (version + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_release);
+
+            for (int i = 0; i < getNumValues (slot.type); i++)
+                slot.values[i].store (values[i], std::memory_order_relaxed);
+
+            slot.version.store (version + 2, std::memory_order_release);
+        }
+
+        if (slot.queued.exchange (true))
+            return;
+
+        //writers only hold this for the few instructions it takes to claim a position
+        const SpinLock::ScopedLockType sl (writeLock);
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        //every slot fits in the ring and is in it at most once, so this only guards against a bug
+        if (size1 == 0)
+        {
+            jassertfalse;
+            slot.queued = false;
+            return;
+        }
+
+        queuedSlots[start1] = slotId;
+        fifo.finishedWrite (1);
+    }
+
+    //called on the message thread, once for each slot set since the last call
+    template <typename Callback>
+    void readAll (Callback&& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; i++)     read (queuedSlots[start1 + i], callback);
+        for (int i = 0; i < size2; i++)     read (queuedSlots[start2 + i], callback);
+
+        fifo.finishedRead (size1 + size2);
+    }
+
+private:
+    enum { maxSlots = 1024 };
+
+    struct Slot
+    {
+        int widget = 0, property = 0;   //set once, before the slot id is handed out
+        PropertyType type = invalid;
+        std::atomic<MYFLT> values[4];
+        std::atomic<uint32> version { 0 };
+        std::atomic<bool> queued { false };
+        SpinLock writeLock;
+    };
+
+    template <typename Callback>
+    void read (int slotId, Callback& callback)
+    {
+        Slot& slot = slots[slotId];
+        //cleared before the values are read, so values set from now on queue the slot again
+        slot.queued.store (false);
 
+        Update update { slot.widget, slot.property, slot.type, { 0, 0, 0, 0 } };
 
-        CabbagePersistentData** pd = (CabbagePersistentData**)csound->query_global_variable("cabbageData");
-        auto perData = *pd;
-        if (perData != nullptr)
-        {
-            jsonData = perData->data;
-        }
-        else
+        for (int attempt = 0; attempt < 4; attempt++)
         {
-            csound->message("Internal JSON global var is not valid.\n");
-            return;
-        }
+            const uint32 version = slot.version.load (std::memory_order_acquire);
 
+            if ((version & 1) != 0)
+                continue;
 
-        if (json::accept(jsonData) == false)
-        {
-            csound->message("Invalid JSON data:" + jsonData + "\n");
-            out.init(csound, 1);
-            out[0] = -1;
-            return;
-        }
+            for (int i = 0; i < getNumValues (slot.type); i++)
+                update.values[i] = slot.values[i].load (std::memory_order_relaxed);
 
-        j = json::parse(jsonData);
+            std::atomic_thread_fence (std::memory_order_acquire);
 
-        for (json::iterator it = j.begin(); it != j.end(); ++it)
-        {
-            if (it.key() == channelKey && it.value().is_array())
+            if (slot.version.load (std::memory_order_relaxed) == version)
             {
-                out.init(csound, (int)it.value().size());
-                int index = 0;
-                for (json::iterator tt = it.value().begin(); tt != it.value().end(); ++tt)
-                {
-                    out[index++] = tt.value();
-                }
-                firstTimeSuccess = true;
+                callback (update);
+                return;
             }
         }
 
-        if (firstTimeSuccess == false)
-        {
-            csound->message("Could not find value for " + channelKey + "?\nCheck JSON channel data.\n");
-            firstTimeSuccess = true;
-        }
+        //a writer kept overtaking the read. It queues the slot again once it is done
     }
-};
 
+    //one more than the number of slots, as AbstractFifo keeps a position free
+    AbstractFifo fifo { maxSlots + 1 };
+    int queuedSlots[maxSlots + 1] = {};
+    Slot slots[maxSlots];
+    int numSlots = 0;
+    SpinLock writeLock, namesLock;
+    std::vector<std::string> names;
+};
 
 //===========================================================================
-// Channel State Save/Recall
+// cabbageSet SChannel, SIdentifier, iValue [, iValue2, iValue3, iValue4]
+// cabbageSet kTrig, SChannel, SIdentifier, kValue [, kValue2, kValue3, kValue4]
+// Sets a widget property without going through an identchannel string. The
+// widget is found by its channel, or failing that its identchannel. The k-rate
+// version sends an update on every k-cycle where kTrig is not 0, the i-rate
+// version once at init time. Updates sent between two GUI updates are merged,
+// so only the last one for each widget and identifier is applied
 //===========================================================================
-
-struct ChannelStateSave : csnd::Plugin<1, 1>
+struct CabbageSetWidget : csnd::Plugin<0, 7>
 {
+    //Csound doesn't construct opcodes, so everything is set up in init()
+    WidgetUpdateQueue* queue;
+    WidgetUpdateQueue::Update update;
+    int slotId;
+    int firstValue;
+
     int init()
     {
-        writeDataToDisk();
-        return OK;
+        return setUp (3);
     }
 
     int kperf()
     {
-        writeDataToDisk();
+        if (inargs[0] != 0)
+            send();
+
         return OK;
     }
 
-    void writeDataToDisk()
+    int setUp (int firstValueIndex)
     {
-        json j;
+        firstValue = firstValueIndex;
+        const std::string identifier (inargs.str_data (firstValue - 1).data);
+        update.type = WidgetUpdateQueue::getPropertyType (identifier);
 
-        controlChannelInfo_s* csoundChanList;
-        int numberOfChannels = csound->get_csound()->ListChannels(csound->get_csound(), &csoundChanList);
+        if (update.type == WidgetUpdateQueue::invalid)
+            return csound->init_error ("cabbageSet: " + identifier + " can't be set with cabbageSet, use an identchannel instead");
 
-        for (int i = 0; i < numberOfChannels; i++)
-        {
-            //            const float min = csoundChanList[i].hints.min;
-            //            const float max = (csoundChanList[i].hints.max == 0 ? 1 : csoundChanList[i].hints.max);
-            //            const float defaultValue = csoundChanList[i].hints.dflt;
-            std::string name;
+        const int numValues = (int)in_count() - firstValue;
 
-            MYFLT* value;
-            char* chString;
+        if (numValues != WidgetUpdateQueue::getNumValues (update.type) && (update.type != WidgetUpdateQueue::colour || numValues != 3))
+            return csound->init_error ("cabbageSet: wrong number of values for " + identifier);
 
-            if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, csoundChanList[i].name,
-                CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
-            {
-                j[csoundChanList[i].name] = *value;
-            }
+        const std::string widgetName (inargs.str_data (firstValue - 2).data);
 
-            if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, csoundChanList[i].name,
-                CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
-            {
-                chString = ((STRINGDAT*)value)->data;
-                String s(chString);
-                j[csoundChanList[i].name] = s.replace("\\\\", "/").toStdString();
-            }
-        }
+        if (widgetName.empty())
+            return csound->init_error ("cabbageSet: empty channel name");
 
-        String filename(inargs.str_data(0).data);
-        std::ofstream file;
-        file.open(filename.replace("\\\\", "/").toStdString());
-        if (file.is_open() == false)
-            outargs[0] = 0;
-        else
-            outargs[0] = 1;
+        queue = WidgetUpdateQueue::find (csound->get_csound());
 
-        file << std::setw(4) << j << std::endl;
-        file.close();
-        csound->message(j.dump());
+        if (queue == nullptr)
+            return csound->init_error ("cabbageSet: widgets can only be updated from inside Cabbage");
+
+        update.widget = queue->getNameId (widgetName);
+        update.property = queue->getNameId (identifier);
+        update.values[3] = 255;
+        slotId = queue->getSlotId (update.widget, update.property, update.type);
+
+        if (slotId < 0)
+            return csound->init_error ("cabbageSet: too many widget identifiers are set with cabbageSet");
+
+        return OK;
     }
 
-};
+    void send()
+    {
+        for (int i = firstValue; i < (int)in_count(); i++)
+            update.values[i - firstValue] = inargs[i];
 
+        queue->set (slotId, update.values);
+    }
+};
 
-struct ChannelStateRecall : csnd::Plugin<1, 2>
+struct CabbageSetWidgetInit : CabbageSetWidget
 {
     int init()
     {
-        readDataFromDisk();
+        if (setUp (2) != OK)
+            return NOTOK;
+
+        send();
         return OK;
     }
+};
 
-    int kperf()
+//===========================================================================
+// A copy of the widget properties that cabbageGet can read. The processor lays
+// it out, one entry per widget and identifier, before the instance starts
+// performing, and then publishes new values from the message thread whenever
+// a widget's ValueTree changes. Readers never lock: numbers are atomics, and
+// strings are double-buffered with a version count that tells a reader when
+// it needs to read again. One instance per Csound, deleted when Csound is reset.
+//===========================================================================
+class WidgetStateSnapshot
+{
+public:
+    enum { maxStringLength = 256 };
+
+    struct Entry
     {
-        readDataFromDisk();
-        return OK;
+        int widget;             //index into the processor's widgets
+        std::string identifier;
+        bool isString;
+        int valueIndex;
+    };
+
+    //called by the processor before the instance performs
+    static WidgetStateSnapshot* create (CSOUND* csound)
+    {
+        return CsoundGlobalObject<WidgetStateSnapshot>::create (csound, "cabbageWidgetState");
     }
 
-    void readDataFromDisk()
+    static WidgetStateSnapshot* find (CSOUND* csound)
     {
-        json j;
-        std::string filename(inargs.str_data(0).data);
-        std::vector<std::string> ignoreStrings;
-
-        if (inargs[1] != 0)
-        {
-            csnd::Vector<STRINGDAT>& in = inargs.vector_data<STRINGDAT>(1);
-            for (int i = 0; i < in.len(); i++)
-            {
-                ignoreStrings.push_back(std::string(in[i].data));
-            }
-        }
+        return CsoundGlobalObject<WidgetStateSnapshot>::find (csound, "cabbageWidgetState");
+    }
 
-        std::ifstream file(filename);
-        if (file.fail())
-        {
-            csound->message("Unable to open file");
-            outargs[0] = 0;
-            return;
-        }
+    //=================================================================================
+    //layout, only while the instance isn't performing
+    void clear()
+    {
+        widgetNames.clear();
+        entries.clear();
+        numbers.clear();
+        strings.clear();
+    }
 
-        j << file;
-        MYFLT* value;
+    void addWidget (int widget, const std::string& channel, const std::string& identChannel)
+    {
+        if ((int)widgetNames.size() <= widget)
+            widgetNames.resize (widget + 1);
 
-        for (json::iterator it = j.begin(); it != j.end(); ++it)
-        {
-            bool ignore = false;
-            std::string channelName = it.key();
+        widgetNames[widget] = { channel, identChannel };
+    }
 
-            for (int i = 0; i < ignoreStrings.size(); i++)
-            {
-                if (channelName == ignoreStrings[i])
-                    ignore = true;
-            }
+    void addNumber (int widget, const std::string& identifier, MYFLT value)
+    {
+        entries.push_back ({ widget, identifier, false, (int)numbers.size() });
+        numbers.emplace_back();
+        numbers.back().store (value);
+    }
 
-            if (ignore == false)
-            {
-                if (it.value().is_number_float())
-                {
-                    if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, channelName.c_str(),
-                        CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
-                    {
-                        *value = it.value();
-                    }
-                }
-                else if (it.value().is_string())
-                {
-                    if (csound->get_csound()->GetChannelPtr(csound->get_csound(), &value, channelName.c_str(),
-                        CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL) == CSOUND_SUCCESS)
-                    {
-                        std::string string = it.value();
-                        ((STRINGDAT*)value)->data = csound->strdup((char*)string.c_str());
-                    }
-                }
-            }
-        }
-        outargs[0] = 1;
-        file.close();
-        csound->message(j.dump());
+    void addString (int widget, const std::string& identifier, const char* text)
+    {
+        entries.push_back ({ widget, identifier, true, (int)strings.size() });
+        strings.emplace_back();
+        setString (strings.size() - 1, text);
     }
 
-};
+    const std::vector<Entry>& getEntries() const    { return entries; }
 
-//===========================================================================
-// FileToStr
-//===========================================================================
-struct FileToStr : csnd::Plugin<1, 1>
-{
-    int init()
+    //widgets are found by their first channel, then by their identchannel, as with cabbageSet
+    const Entry* findEntry (const std::string& widgetName, const std::string& identifier, bool isString) const
     {
-        std::string line;
-        std::string lines;
-        char* fileName = inargs.str_data(0).data;
-        std::ifstream fileStream(fileName);
+        for (int pass = 0; pass < 2; pass++)
+            for (auto& entry : entries)
+                if (entry.isString == isString && entry.identifier == identifier
+                    && (pass == 0 ? widgetNames[entry.widget].first : widgetNames[entry.widget].second) == widgetName)
+                    return &entry;
 
-        if (fileStream.is_open())
-        {
-            while (getline(fileStream, line))
-            {
-                lines.append(line);
-                lines.append("\n");
-            }
-        }
-        else
-        {
-            csound->message("fileToStr could not open file for reading");
-            return NOTOK;
-        }
+        return nullptr;
+    }
 
-        fileStream.close();
-        outargs.str_data(0).data = csound->strdup((char*)lines.c_str());
-        return OK;
+    //=================================================================================
+    //message thread only
+    void setNumber (int valueIndex, MYFLT value)
+    {
+        numbers[valueIndex].store (value, std::memory_order_relaxed);
     }
-};
 
-//===========================================================================
-//removes a number of occurrences of one string from another
-//===========================================================================
-struct StrRemove : csnd::Plugin<1, 3>
-{
-    int init()
+    void setString (int valueIndex, const char* text)
     {
-        return parseStringAndFillStruct(this);
+        StringValue& string = strings[valueIndex];
+        const uint32 version = string.version.load (std::memory_order_relaxed);
+        char* buffer = string.text[(version + 1) & 1];
+
+        std::strncpy (buffer, text, maxStringLength - 1);
+        buffer[maxStringLength - 1] = 0;
+        string.version.store (version + 1, std::memory_order_release);
     }
 
-    int parseStringAndFillStruct(Plugin* opcodeData)
+    //=================================================================================
+    //any thread
+    MYFLT getNumber (int valueIndex) const
     {
-        int occurrences = -1;
-        int strsRemoved = 0;
-        char* inString = opcodeData->inargs.str_data(0).data;
-        char* inStripString = opcodeData->inargs.str_data(1).data;
+        return numbers[valueIndex].load (std::memory_order_relaxed);
+    }
 
-        if (opcodeData->in_count() > 2)
-            occurrences = opcodeData->inargs[2];
+    uint32 getStringVersion (int valueIndex) const
+    {
+        return strings[valueIndex].version.load (std::memory_order_acquire);
+    }
 
-        std::string input(inString);
-        std::string stripString(inStripString);
-        std::string::size_type index = input.find(stripString);
+    //copies the current text, which is at most maxStringLength - 1 characters long, and
+    //returns its version. If the writer keeps overtaking the copy, the last attempt is kept
+    uint32 getString (int valueIndex, char* destination) const
+    {
+        const StringValue& string = strings[valueIndex];
+        uint32 version = 0;
 
-        while (index != std::string::npos)
+        for (int attempt = 0; attempt < 4; attempt++)
         {
-            input.erase(index, stripString.length());
-            index = input.find(stripString, index);
-            strsRemoved += 1;
+            version = string.version.load (std::memory_order_acquire);
+            std::memcpy (destination, string.text[version & 1], maxStringLength);
+            std::atomic_thread_fence (std::memory_order_acquire);
 
-            if (strsRemoved == occurrences)
+            if (string.version.load (std::memory_order_relaxed) == version)
                 break;
         }
 
-        opcodeData->outargs.str_data(0).data = csound->strdup((char*)input.c_str());
-
-        return OK;
+        destination[maxStringLength - 1] = 0;
+        return version;
     }
+
+private:
+    struct StringValue
+    {
+        char text[2][maxStringLength] = {};
+        std::atomic<uint32> version { 0 };
+    };
+
+    std::vector<std::pair<std::string, std::string>> widgetNames;
+    std::vector<Entry> entries;
+    //deques, so that values don't move as the layout grows
+    std::deque<std::atomic<MYFLT>> numbers;
+    std::deque<StringValue> strings;
 };
 
 //===========================================================================
-// StrToArray
+// iValue cabbageGet SChannel, SIdentifier
+// kValue cabbageGet SChannel, SIdentifier
+// SValue cabbageGet SChannel, SIdentifier
+// Reads a widget property without an identchannel round trip. The widget is
+// found by its channel, or failing that its identchannel. Numbers can be read
+// from value, valuex, valuey, minvalue, maxvalue, left, top, width, height,
+// visible, active and alpha, and strings from value, text, file and, for
+// comboboxes, currenttext, the text of the selected item
 //===========================================================================
-struct StrToArray : csnd::Plugin<1, 2>
+struct CabbageGetWidget
 {
-    int init()
-    {
-        return parseStringAndFillStruct();
-    }
-
-    int parseStringAndFillStruct()
+    //finds the entry at init time, or reports an init error
+    template <typename Opcode>
+    static const WidgetStateSnapshot::Entry* findEntry (Opcode& opcode, WidgetStateSnapshot*& snapshot, bool isString)
     {
-        csnd::Vector<STRINGDAT>& out = outargs.vector_data<STRINGDAT>(0);
-
-        char* inString = inargs.str_data(0).data;
-        char* inStringDeLimiter = inargs.str_data(1).data;
+        const std::string widgetName (opcode.inargs.str_data (0).data);
+        const std::string identifier (opcode.inargs.str_data (1).data);
+        snapshot = WidgetStateSnapshot::find (opcode.csound->get_csound());
 
+        const WidgetStateSnapshot::Entry* entry = snapshot != nullptr ? snapshot->findEntry (widgetName, identifier, isString) : nullptr;
 
-        std::string input(inString);
-        std::string delimiter(inStringDeLimiter);
-        std::vector<std::string> tokens;
+        if (entry == nullptr)
+            opcode.csound->init_error ("cabbageGet: " + widgetName + " has no " + (isString ? "string " : "numeric ") + identifier + " that can be read");
 
-        size_t pos = 0;
+        return entry;
+    }
+};
 
-        while ((pos = input.find(delimiter)) != std::string::npos)
-        {
-            tokens.push_back(input.substr(0, pos));
-            input.erase(0, pos + delimiter.length());
-        }
+struct CabbageGetWidgetNumber : csnd::Plugin<1, 2>
+{
+    //Csound doesn't construct opcodes, so everything is set up in init()
+    WidgetStateSnapshot* snapshot;
+    int valueIndex;
 
-        if (input.size() > 0)
-            tokens.push_back(input);
+    int init()
+    {
+        const WidgetStateSnapshot::Entry* entry = CabbageGetWidget::findEntry (*this, snapshot, false);
 
-        out.init(csound, (int)tokens.size());
+        if (entry == nullptr)
+            return NOTOK;
 
-        for (int i = 0; i < tokens.size(); i++)
-        {
-            out[i].data = csound->strdup((char*)tokens[i].c_str());
-        }
+        valueIndex = entry->valueIndex;
+        return kperf();
+    }
 
-        tokens.clear();
+    int kperf()
+    {
+        outargs[0] = snapshot->getNumber (valueIndex);
         return OK;
     }
 };
-//===========================================================================
-// StrToFile
-//===========================================================================
 
-struct StrToFile : csnd::Plugin<1, 3>
+struct CabbageGetWidgetString : csnd::Plugin<1, 2>
 {
+    WidgetStateSnapshot* snapshot;
+    int valueIndex;
+    uint32 version;
+
     int init()
     {
+        const WidgetStateSnapshot::Entry* entry = CabbageGetWidget::findEntry (*this, snapshot, true);
 
-        int mode = 0;
-        if (in_count() < 2)
-        {
-            csound->message("You did not pass have enough arguments to strtofile\n");
+        if (entry == nullptr)
             return NOTOK;
-        }
 
-        char* inString = inargs.str_data(0).data;
-        char* fileName = inargs.str_data(1).data;
+        valueIndex = entry->valueIndex;
+        return readString();
+    }
 
+    //the output is only written when the text has changed
+    int kperf()
+    {
+        return snapshot->getStringVersion (valueIndex) != version ? readString() : OK;
+    }
 
-        if (in_count() > 2)
-            mode = inargs[2];
+    int readString()
+    {
+        char text[WidgetStateSnapshot::maxStringLength];
+        version = snapshot->getString (valueIndex, text);
 
-        std::ofstream fileStream;
+        STRINGDAT& result = outargs.str_data (0);
+        const int length = (int)std::strlen (text);
 
-        if (mode == 1)
-        {
-            fileStream.open(fileName, std::ios::in | std::ios::app);
-        }
+        if (result.data != nullptr && result.size > length)
+            std::memcpy (result.data, text, length + 1);
         else
-            fileStream.open(fileName, std::ios::in | std::ios::trunc);
-
-        fileStream << inString;
-
-        if (!fileStream.is_open())
         {
-            csound->message("*** strToFile could not open file for writing ***");
-            outargs[0] = 0;
+            result.data = csound->strdup (text);
+            result.size = length + 1;
         }
 
-        fileStream.close();
-        outargs[0] = 1;
         return OK;
     }
 };
+
 //void csnd::on_load (Csound* csound)
 //{
 //    csnd::plugin<channelStateSave> (csound, "channelStateSave.i", "i", "S", csnd::thread::i);
@@ -0,0 +1,208 @@
+/*
+  Copyright (C) 2019 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef CABBAGECONSOLELOG_H_INCLUDED
+#define CABBAGECONSOLELOG_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+//the last few thousand lines of console output, kept in a fixed block of memory.
+//Every line gets a sequence number, so readers can ask for whatever arrived since
+//they last looked, and lines that have scrolled out of the ring are simply gone.
+//Messages added faster than the rate limit are counted and thrown away, but
+//warnings and errors are always kept.
+class CabbageConsoleLog
+{
+public:
+    enum Severity { message = 0, warning, error };
+    enum { capacity = 1024, maxLineLength = 255 };
+
+    struct Line
+    {
+        char text[maxLineLength + 1];
+        int severity;
+        int64 time;
+    };
+
+    //pass 0 for maxLinesPerSecond to keep every line
+    explicit CabbageConsoleLog (int linesPerSecond = 0)
+        : lines (capacity), maxLinesPerSecond (linesPerSecond)
+    {
+    }
+
+    //adds a single line, split over as many lines as it needs. Returns false if the
+    //rate limit dropped it. Lines should only be added from one thread
+    bool add (const char* text, size_t numBytes, int severity, int64 time)
+    {
+        if (severity == message && isOverRateLimit (time))
+        {
+            ++numDropped;
+            return false;
+        }
+
+        const SpinLock::ScopedLockType sl (lock);
+
+        do
+        {
+            size_t lineBytes = numBytes;
+
+            if (lineBytes > maxLineLength)
+            {
+                //don't leave half a UTF-8 character at the end
+                lineBytes = maxLineLength;
+
+                while (lineBytes > 0 && (text[lineBytes] & 0xc0) == 0x80)
+                    --lineBytes;
+
+                if (lineBytes == 0)
+                    lineBytes = maxLineLength;
+            }
+
+            Line& line = lines[(int) (endSequence % capacity)];
+            memcpy (line.text, text, lineBytes);
+            line.text[lineBytes] = 0;
+            line.severity = severity;
+            line.time = time;
+            ++endSequence;
+
+            text += lineBytes;
+            numBytes -= lineBytes;
+        }
+        while (numBytes > 0);
+
+        return true;
+    }
+
+    bool add (const String& text, int severity, int64 time)
+    {
+        return add (text.toRawUTF8(), text.getNumBytesAsUTF8(), severity, time);
+    }
+
+    //splits the text into lines, as they arrive from a process or a file
+    void addText (const String& text, int severity, int64 time)
+    {
+        StringArray newLines;
+        newLines.addLines (text.trimCharactersAtEnd ("\n\r"));
+
+        for (auto& line : newLines)
+            add (line, severity, time);
+    }
+
+    void clear()
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        startSequence = endSequence;
+    }
+
+    //the sequence number of the oldest line still held
+    uint64 getStartSequence() const
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        return getOldestSequence();
+    }
+
+    //one past the sequence number of the newest line
+    uint64 getEndSequence() const
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        return endSequence;
+    }
+
+    int getNumLines() const
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        return (int) (endSequence - getOldestSequence());
+    }
+
+    //copies a line out, returns false if it has already been overwritten
+    bool getLine (uint64 sequence, Line& dest) const
+    {
+        const SpinLock::ScopedLockType sl (lock);
+
+        if (sequence >= endSequence || sequence < getOldestSequence())
+            return false;
+
+        dest = lines[(int) (sequence % capacity)];
+        return true;
+    }
+
+    //the lines from 'sequence' up to the newest one, with 'sequence' moved on past them
+    String getTextSince (uint64& sequence) const
+    {
+        String text;
+        Line line;
+        const uint64 end = getEndSequence();
+
+        for (sequence = jmax (sequence, getStartSequence()); sequence < end; ++sequence)
+            if (getLine (sequence, line))
+                text << line.text << "\n";
+
+        return text;
+    }
+
+    //copies the lines 'source' has taken since 'sequence', keeping their severity and
+    //time, and moves 'sequence' on past them. Returns true if anything was added
+    bool addLinesFrom (const CabbageConsoleLog& source, uint64& sequence)
+    {
+        bool added = false;
+        Line line;
+        const uint64 end = source.getEndSequence();
+
+        for (sequence = jmax (sequence, source.getStartSequence()); sequence < end; ++sequence)
+            if (source.getLine (sequence, line))
+                added = add (line.text, strlen (line.text), line.severity, line.time) || added;
+
+        return added;
+    }
+
+    int64 getNumDropped() const     { return numDropped.get(); }
+
+private:
+    uint64 getOldestSequence() const
+    {
+        return jmax (startSequence, endSequence > (uint64) capacity ? endSequence - capacity : (uint64) 0);
+    }
+
+    bool isOverRateLimit (int64 time)
+    {
+        if (maxLinesPerSecond <= 0)
+            return false;
+
+        if (time - rateWindowStart >= 1000)
+        {
+            rateWindowStart = time;
+            linesInRateWindow = 0;
+        }
+
+        return ++linesInRateWindow > maxLinesPerSecond;
+    }
+
+    HeapBlock<Line> lines;
+    uint64 startSequence = 0, endSequence = 0;
+    mutable SpinLock lock;
+    Atomic<int64> numDropped { 0 };
+    const int maxLinesPerSecond;
+    int64 rateWindowStart = 0;
+    int linesInRateWindow = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (CabbageConsoleLog)
+};
+
+#endif  // CABBAGECONSOLELOG_H_INCLUDED
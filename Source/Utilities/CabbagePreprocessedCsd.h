@@ -0,0 +1,214 @@
+/*
+  Copyright (C) 2019 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef CABBAGEPREPROCESSEDCSD_H_INCLUDED
+#define CABBAGEPREPROCESSEDCSD_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Widgets/CabbageWidgetData.h"
+
+//==============================================================================
+//a csd file that has been read and scanned once. Results are shared between everything
+//that loads the same file contents, so plugin instances don't each re-read the file
+//and re-parse its form line, header and macros.
+class CabbagePreprocessedCsd : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<CabbagePreprocessedCsd> Ptr;
+
+    //returns the scan of the file's current contents. The file is only read again
+    //if its size or modification time has changed
+    static Ptr get (const File& csdFile)
+    {
+        Cache& cache = getCache();
+        const String path = csdFile.getFullPathName();
+        const int64 modified = csdFile.getLastModificationTime().toMilliseconds();
+        const int64 size = csdFile.getSize();
+
+        {
+            const ScopedLock sl (cache.lock);
+
+            for (auto& stamp : cache.stamps)
+                if (stamp.path == path && stamp.modified == modified && stamp.size == size)
+                    if (auto* csd = cache.find (stamp.contentHash, nullptr))
+                        return csd;
+        }
+
+        const String text = csdFile.loadFileAsString();
+        const int64 contentHash = text.hashCode64();
+
+        const ScopedLock sl (cache.lock);
+        Ptr csd = cache.find (contentHash, &text);
+
+        if (csd == nullptr)
+        {
+            csd = new CabbagePreprocessedCsd (text, contentHash);
+            cache.entries.add (csd);
+
+            if (cache.entries.size() > maxCachedFiles)
+                cache.entries.remove (0);
+        }
+
+        cache.setStamp ({ path, modified, size, contentHash });
+        return csd;
+    }
+
+    //cheap check for a form() line, so that callers only need to run the full
+    //widget parser on lines that can be one
+    static bool isFormLine (const String& line)
+    {
+        return CabbageWidgetData::getWidgetTypeFromLine (line).trim() == CabbageWidgetTypes::form;
+    }
+
+    //--omacro options for every #define in the <Cabbage> section
+    static StringArray parseMacroOptions (const StringArray& csdLines)
+    {
+        StringArray options;
+        bool inCabbageSection = false;
+
+        for (const auto& line : csdLines)
+        {
+            if (!inCabbageSection && line.contains ("<Cabbage"))
+                inCabbageSection = true;
+
+            if (inCabbageSection && line.trim().substring (0, 7) == "#define")
+            {
+                StringArray tokens;
+                tokens.addTokens (line.replace ("#", "").trim(), " ");
+                const String macroName = tokens[1];
+                tokens.remove (0);
+                tokens.remove (0);
+                options.add ("--omacro:" + macroName + "=" + tokens.joinIntoString (" "));
+            }
+
+            if (line.contains ("</Cabbage>"))
+                break;
+        }
+
+        return options;
+    }
+
+    const String text;
+    const StringArray lines;
+    const int64 contentHash;
+
+    //the last form() line in the <Cabbage> section, an invalid tree if there isn't one
+    ValueTree getForm() const
+    {
+        return form.createCopy();
+    }
+
+    const StringArray& getMacroOptions() const
+    {
+        return macroOptions;
+    }
+
+    bool hasCsoundTags() const
+    {
+        return csoundTags;
+    }
+
+    //same as CabbageUtilities::getHeaderInfo(), but each header is only looked up once
+    int getHeaderInfo (const String& headerString) const
+    {
+        const ScopedLock sl (headerLock);
+
+        if (!headerInfo.contains (headerString))
+            headerInfo.set (headerString, CabbageUtilities::getHeaderInfo (text, headerString));
+
+        return headerInfo[headerString];
+    }
+
+private:
+    CabbagePreprocessedCsd (const String& csdText, int64 hash)
+        : text (csdText), lines (StringArray::fromLines (csdText)), contentHash (hash)
+    {
+        for (int i = 0; i < lines.size(); i++)
+        {
+            if (lines[i].contains ("</Cabbage>"))
+                break;
+
+            ValueTree widget ("form");
+
+            if (CabbageWidgetData::setWidgetState (widget, lines[i], i, CabbageWidgetData::ScanMode::formOnly))
+                form = widget;
+        }
+
+        csoundTags = text.contains ("<Csound") || text.contains ("</Csound");
+        macroOptions = parseMacroOptions (lines);
+    }
+
+    ValueTree form;
+    StringArray macroOptions;
+    bool csoundTags = false;
+    CriticalSection headerLock;
+    mutable NamedValueSet headerInfo;
+
+    //==============================================================================
+    enum { maxCachedFiles = 16 };
+
+    struct FileStamp
+    {
+        String path;
+        int64 modified, size, contentHash;
+    };
+
+    struct Cache
+    {
+        CriticalSection lock;
+        ReferenceCountedArray<CabbagePreprocessedCsd> entries;
+        Array<FileStamp> stamps;
+
+        CabbagePreprocessedCsd* find (int64 hash, const String* textToMatch)
+        {
+            for (auto* csd : entries)
+                if (csd->contentHash == hash && (textToMatch == nullptr || csd->text == *textToMatch))
+                    return csd;
+
+            return nullptr;
+        }
+
+        void setStamp (const FileStamp& newStamp)
+        {
+            for (auto& stamp : stamps)
+            {
+                if (stamp.path == newStamp.path)
+                {
+                    stamp = newStamp;
+                    return;
+                }
+            }
+
+            stamps.add (newStamp);
+
+            if (stamps.size() > maxCachedFiles)
+                stamps.remove (0);
+        }
+    };
+
+    static Cache& getCache()
+    {
+        static Cache cache;
+        return cache;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (CabbagePreprocessedCsd)
+};
+
+#endif  // CABBAGEPREPROCESSEDCSD_H_INCLUDED
@@ -704,26 +704,33 @@ public:
 
 	static StringArray getTokens(String code, char breakChar)
 	{
+        //walks the line once; indexing a String by position is linear in utf8
         StringArray tokens;
-        int linesize = code.length();
-        int from = 0; // index of the first char of the current token in this line of code
-        
-        for (int i = 0; i < linesize; i++) // let's find all the tokens in this line of code...
+        auto c = code.getCharPointer();
+        auto from = c; // first char of the current token in this line of code
+
+        while (! c.isEmpty()) // let's find all the tokens in this line of code...
         {
-            while (i < linesize && (char)code[i] != breakChar) // let's find the end of a token...
+            while (! c.isEmpty() && (char) *c != breakChar) // let's find the end of a token...
             {
-                if (code[i] == '\"')   // excuse anything in quotes..
+                if (*c == '\"')   // excuse anything in quotes..
                 {
-                    i++; // so, skip the first quote char
+                    ++c; // so, skip the first quote char
 
-                    while (i < linesize && code[i] != '\"') // continue to skip until endline or end quote char
-                        i++;
+                    while (! c.isEmpty() && *c != '\"') // continue to skip until endline or end quote char
+                        ++c;
                 }
-                i++; // move to the next char
+
+                if (! c.isEmpty())
+                    ++c; // move to the next char
             }
 
-            tokens.add(code.substring(from, i)); // let's add the token to the tokens array
-            from = i + 1; // set new start position for the next token
+            tokens.add (String (from, c)); // let's add the token to the tokens array
+
+            if (c.isEmpty())
+                break;
+
+            from = ++c; // set new start position for the next token
         }
         
         return tokens;
@@ -21,32 +21,37 @@
 #include "../Audio/Plugins/CabbagePluginEditor.h"
 
 CabbageCsoundConsole::CabbageCsoundConsole (ValueTree wData, CabbagePluginEditor* _owner)
-    :  TextEditor (""),
-    owner (_owner),
+    :  owner (_owner),
     widgetData (wData)
 {
     setName (CabbageWidgetData::getStringProp (wData, CabbageIdentifierIds::name));
     widgetData.addListener (this);              //add listener to valueTree so it gets notified when a widget's property changes
     initialiseCommonAttributes (this, wData);   //initialise common attributes such as bounds, name, rotation, etc..
-    this->setMultiLine (true, false);
-    this->setScrollbarsShown (true);
+    addAndMakeVisible (listBox);
+    listBox.setModel (this);
 
-    setColour (TextEditor::textColourId, Colour::fromString (CabbageWidgetData::getStringProp (wData, CabbageIdentifierIds::fontcolour)));
-    setColour (TextEditor::backgroundColourId, Colour::fromString (CabbageWidgetData::getStringProp (wData, CabbageIdentifierIds::colour)));
-    setColour (TextEditor::outlineColourId, Colours::transparentBlack);
-    setColour (TextEditor::focusedOutlineColourId, Colours::transparentBlack);
-    setColour (TextEditor::highlightColourId, Colour::fromString (CabbageWidgetData::getStringProp (wData, CabbageIdentifierIds::fontcolour)).contrasting (.5f));
+    textColour = Colour::fromString (CabbageWidgetData::getStringProp (wData, CabbageIdentifierIds::fontcolour));
+    listBox.setColour (ListBox::backgroundColourId, Colour::fromString (CabbageWidgetData::getStringProp (wData, CabbageIdentifierIds::colour)));
+    listBox.setColour (ListBox::outlineColourId, Colours::transparentBlack);
 
     if (CabbageUtilities::getTarget() == CabbageUtilities::TargetTypes::IDE)
     {
-        const String initText ("========================================\nCsound output messages are only sent to\nthis widget when your Cabbage instrument\nis running in plugin mode.\n========================================");
-        setText (initText);
+        placeholderLines.addLines ("========================================\nCsound output messages are only sent to\nthis widget when your Cabbage instrument\nis running in plugin mode.\n========================================");
     }
     else
+    {
+        consoleLog = &owner->getProcessor().getConsoleLog();
         startTimer (100);
+    }
 
     this->monospacedFont.setTypefaceName(Font::getDefaultMonospacedFontName());
     setMonospaced(wData);
+    listBox.updateContent();
+}
+
+CabbageCsoundConsole::~CabbageCsoundConsole()
+{
+    listBox.setModel (nullptr);
 }
 
 void CabbageCsoundConsole::setMonospaced(bool monoVal)
@@ -56,7 +61,7 @@ void CabbageCsoundConsole::setMonospaced(bool monoVal)
         return;
     }
     this->monospaced = monoVal;
-    applyFontToAllText(this->monospaced ? monospacedFont : defaultFont);
+    listBox.repaint();
 }
 
 void CabbageCsoundConsole::setMonospaced(const ValueTree &valueTree)
@@ -64,30 +69,85 @@ void CabbageCsoundConsole::setMonospaced(const ValueTree &valueTree)
     setMonospaced(CabbageWidgetData::getStringProp(valueTree, CabbageIdentifierIds::style).contains("monospaced"));
 }
 
+void CabbageCsoundConsole::resized()
+{
+    listBox.setBounds (getLocalBounds());
+}
+
+//only repaints when new lines have arrived, and keeps the newest line in view
+//unless the list has been scrolled back
 void CabbageCsoundConsole::timerCallback()
 {
-    if (CabbageUtilities::getTarget() == CabbageUtilities::TargetTypes::IDE)
-    {
-        const String initText ("===========================\nCsound output messages are only sent to\nthis widget when your Cabbage instrument\nis running in plugin mode.\n===========================");
-        setText (initText);
-    }
+    const uint64 newestLine = consoleLog->getEndSequence();
+
+    if (newestLine == lastLineShown)
+        return;
+
+    Viewport* viewport = listBox.getViewport();
+    const bool followNewLines = viewport->getViewPositionY() + viewport->getViewHeight()
+                                >= viewport->getViewedComponent()->getHeight() - listBox.getRowHeight();
+
+    lastLineShown = newestLine;
+    listBox.updateContent();
+
+    if (followNewLines)
+        listBox.scrollToEnsureRowIsOnscreen (getNumRows() - 1);
+
+    listBox.repaint();
+}
+
+int CabbageCsoundConsole::getNumRows()
+{
+    return consoleLog != nullptr ? consoleLog->getNumLines() : placeholderLines.size();
+}
+
+void CabbageCsoundConsole::paintListBoxItem (int rowNumber, Graphics& g, int width, int height, bool rowIsSelected)
+{
+    String text;
+    int severity = CabbageConsoleLog::message;
+
+    if (consoleLog == nullptr)
+        text = placeholderLines[rowNumber];
     else
     {
-        const String csoundOutputString = owner->getCsoundOutputFromProcessor();
+        CabbageConsoleLog::Line line;
 
-        if (csoundOutputString.isNotEmpty())
-        {
-            insertTextAtCaret (csoundOutputString);
-        }
+        if (! consoleLog->getLine (consoleLog->getStartSequence() + rowNumber, line))
+            return;
+
+        text = String::fromUTF8 (line.text);
+        severity = line.severity;
     }
+
+    if (rowIsSelected)
+        g.fillAll (textColour.contrasting (.5f));
+
+    if (severity == CabbageConsoleLog::error)
+        g.setColour (textColour.interpolatedWith (Colours::red, .7f));
+    else if (severity == CabbageConsoleLog::warning)
+        g.setColour (textColour.interpolatedWith (Colours::orange, .7f));
+    else
+        g.setColour (textColour);
+
+    g.setFont ((monospaced ? monospacedFont : defaultFont).withHeight (height * .8f));
+    g.drawText (text, 2, 0, width - 2, height, Justification::centredLeft, false);
+}
+
+String CabbageCsoundConsole::getTooltipForRow (int row)
+{
+    CabbageConsoleLog::Line line;
+
+    if (consoleLog != nullptr && consoleLog->getLine (consoleLog->getStartSequence() + row, line))
+        return Time (line.time).toString (false, true, true, true);
+
+    return String();
 }
 
 void CabbageCsoundConsole::valueTreePropertyChanged (ValueTree& valueTree, const Identifier& prop)
 {
-    setColour (TextEditor::textColourId, Colour::fromString (CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::fontcolour)));
-    setColour (TextEditor::backgroundColourId, Colour::fromString (CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::colour)));
+    textColour = Colour::fromString (CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::fontcolour));
+    listBox.setColour (ListBox::backgroundColourId, Colour::fromString (CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::colour)));
     setMonospaced(valueTree);
-    lookAndFeelChanged();
-    repaint();
+    listBox.repaint();
     handleCommonUpdates (this, valueTree);      //handle comon updates such as bounds, alpha, rotation, visible, etc
 }
@@ -22,15 +22,16 @@
 
 #include "../CabbageCommonHeaders.h"
 #include "CabbageWidgetBase.h"
+#include "../Utilities/CabbageConsoleLog.h"
 
 class CabbagePluginEditor;
 
-class CabbageCsoundConsole : public TextEditor, public Timer, public ValueTree::Listener, public CabbageWidgetBase
+class CabbageCsoundConsole : public Component, public ListBoxModel, public Timer, public ValueTree::Listener, public CabbageWidgetBase
 {
 public:
 
     CabbageCsoundConsole (ValueTree wData, CabbagePluginEditor* _owner);
-    ~CabbageCsoundConsole() {};
+    ~CabbageCsoundConsole();
 
     void setMonospaced(bool value);
     void setMonospaced(const ValueTree &valueTree);
@@ -45,6 +46,12 @@ public:
     void valueTreeParentChanged (ValueTree&) override {};
 
     void timerCallback()  override;
+    void resized() override;
+
+    //ListBoxModel methods, the rows are the last lines in the processor's console log
+    int getNumRows() override;
+    void paintListBoxItem (int rowNumber, Graphics& g, int width, int height, bool rowIsSelected) override;
+    String getTooltipForRow (int row) override;
 
     ValueTree widgetData;
 
@@ -52,6 +59,11 @@ public:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CabbageCsoundConsole);
 
 private:
+    ListBox listBox;
+    const CabbageConsoleLog* consoleLog = nullptr;
+    StringArray placeholderLines;
+    uint64 lastLineShown = 0;
+    Colour textColour;
     bool monospaced = false;
     Font monospacedFont;
     Font defaultFont;
@@ -44,6 +44,11 @@ CabbageGenTable::CabbageGenTable (ValueTree wData, CabbagePluginEditor* owner)
 
 }
 
+CabbageGenTable::~CabbageGenTable()
+{
+    owner->getProcessor().removeTableListener (this);
+}
+
 //===============================================================================
 void CabbageGenTable::changeListenerCallback (ChangeBroadcaster* source)
 {
@@ -56,6 +61,23 @@ void CabbageGenTable::changeListenerCallback (ChangeBroadcaster* source)
     }
 }
 
+void CabbageGenTable::tableChanged (int tableNumber, const Array<float, CriticalSection>& values, Range<int> changedRange)
+{
+    GenTable* genTable = table.getTableFromFtNumber (tableNumber);
+
+    if (genTable == nullptr)
+        return;
+
+    if (genTable->genRoutine == 1)
+    {
+        tableBuffer.setSize (1, values.size(), false, false, true);
+        tableBuffer.copyFrom (0, 0, values.getRawDataPointer(), values.size());
+        table.setWaveform (tableBuffer, tableNumber);
+    }
+    else
+        table.updateWaveform (values, changedRange, tableNumber);
+}
+
 void CabbageGenTable::initialiseGenTable (ValueTree wData)
 {
     int fileTable = 0;
@@ -73,6 +95,7 @@ void CabbageGenTable::initialiseGenTable (ValueTree wData)
 
 
     tables = CabbageWidgetData::getProperty (wData, CabbageIdentifierIds::tablenumber);
+    tableStatements.resize (tables.size());
 
     for (int y = 0; y < tables.size(); y++)
     {
@@ -92,9 +115,11 @@ void CabbageGenTable::initialiseGenTable (ValueTree wData)
                                          Colour::fromString (CabbageWidgetData::getProperty (wData, CabbageIdentifierIds::tablecolour)[y].toString()) :
                                          Colour::fromString (CabbageWidgetData::getProperty (wData, CabbageIdentifierIds::tablecolour)[numberOfColours - 1].toString()));
 
-                table.addTable (44100, tableCol, (tableValues.size() >= MAX_TABLE_SIZE ? 1 : genRoutine), ampRanges, tableNumber, this);
+                table.addTable (44100, tableCol, genRoutine, ampRanges, tableNumber, this);
+                tableStatements.getReference (y) = pFields;
+                owner->getProcessor().addTableListener (tableNumber, this);
 
-                if (abs (genRoutine) == 1 || tableValues.size() >= MAX_TABLE_SIZE)
+                if (abs (genRoutine) == 1)
                 {
                     tableBuffer.clear();
                     int channels = 1;//for now only works in mono;;
@@ -172,33 +197,28 @@ void CabbageGenTable::valueTreePropertyChanged (ValueTree& valueTree, const Iden
 {
     if (CabbageWidgetData::getNumProp (valueTree, CabbageIdentifierIds::update) == 1)
     {
-        const int numberOfTables = tables.size();
-        tableBuffer.clear();
-
-        for (int y = 0; y < numberOfTables; y++)
+        for (int y = 0; y < tables.size(); y++)
         {
-            int tableNumber = tables[y];
-            tableValues.clear();
-            tableValues = owner->getTableFloats (tableNumber);
+            const int tableNumber = tables[y];
 
-            if (table.getTableFromFtNumber (tableNumber) != nullptr)
+            if (GenTable* genTable = table.getTableFromFtNumber (tableNumber))
             {
-                if (table.getTableFromFtNumber (tableNumber)->tableSize >= MAX_TABLE_SIZE)
-                {
-                    tableBuffer.clear();
-                    tableBuffer.addFrom (y, 0, tableValues.getRawDataPointer(), tableValues.size());
-                    table.setWaveform (tableBuffer, tableNumber);
-                }
-                else
+                //only the values that have changed come back through tableChanged()
+                owner->getProcessor().updateObservedTable (tableNumber);
+
+                if (genTable->genRoutine != 1)
                 {
-                    table.setWaveform (tableValues, tableNumber, false);
-                    StringArray pFields = owner->getTableStatement (tableNumber);
-                    table.enableEditMode (pFields, tableNumber);
+                    //handles only need rebuilding if the table was regenerated with new arguments
+                    const StringArray pFields = owner->getTableStatement (tableNumber);
+
+                    if (pFields != tableStatements[y])
+                    {
+                        tableStatements.set (y, pFields);
+                        table.enableEditMode (pFields, tableNumber);
+                    }
                 }
             }
         }
-
-
     }
     else if (CabbageWidgetData::getNumProp (valueTree, CabbageIdentifierIds::update) == 0)
     {
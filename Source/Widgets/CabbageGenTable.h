@@ -24,10 +24,12 @@
 #include "../CabbageCommonHeaders.h"
 #include "CabbageWidgetBase.h"
 #include "Legacy/TableManager.h"
+#include "../Audio/Plugins/CsoundPluginProcessor.h"
 
 class CabbagePluginEditor;
 
-class CabbageGenTable : public Component, public ValueTree::Listener, public CabbageWidgetBase, public ChangeListener
+class CabbageGenTable : public Component, public ValueTree::Listener, public CabbageWidgetBase, public ChangeListener,
+    public CsoundPluginProcessor::TableListener
 {
     String colour;
     String fontcolour;
@@ -45,10 +47,11 @@ class CabbageGenTable : public Component, public ValueTree::Listener, public Cab
     Array <float, CriticalSection> tableValues;
     AudioSampleBuffer tableBuffer;
     var tables;
+    Array<StringArray> tableStatements;
 public:
 
     CabbageGenTable (ValueTree wData, CabbagePluginEditor* owner);
-    ~CabbageGenTable() {};
+    ~CabbageGenTable();
 
     //ValueTree::Listener virtual methods....
     void valueTreePropertyChanged (ValueTree& valueTree, const Identifier&)  override;
@@ -58,6 +61,7 @@ public:
     void valueTreeParentChanged (ValueTree&) override {};
     void initialiseGenTable (ValueTree widgetData);
     void changeListenerCallback (ChangeBroadcaster* source) override;
+    void tableChanged (int tableNumber, const Array<float, CriticalSection>& values, Range<int> changedRange) override;
 
 
     void resized()  override;
@@ -71,6 +71,10 @@ CabbageSignalDisplay::CabbageSignalDisplay (ValueTree wData, CabbagePluginEditor
         addAndMakeVisible (zoomInButton);
         addAndMakeVisible (zoomOutButton);
     }
+
+    //spectrogram colours, looked up by level when a column is written
+    for (int i = 0; i < 256; i++)
+        sonogramColours[i] = Colour::fromHSV (i / 255.f, 1.0f, i / 255.f, 1.0f).getPixelARGB();
 
     const int newUpdateRate = CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::updaterate);
     startTimer (newUpdateRate);
@@ -167,28 +171,40 @@ void CabbageSignalDisplay::drawSonogram()
 
     spectrogramImage.moveImageSection (0, 0, 1, 0, rightHandEdge, imageHeight);
 
-    Graphics g (spectrogramImage);
-    Range<float> maxLevel = FloatVectorOperations::findMinAndMax (signalFloatArray.getRawDataPointer(), signalFloatArray.size());
+    const float* const frame = signalFloatArray.getRawDataPointer();
+    const float maxLevel = FloatVectorOperations::findMaximum (frame, signalFloatArray.size());
+    Image::BitmapData pixels (spectrogramImage, rightHandEdge, 0, 2, imageHeight, Image::BitmapData::writeOnly);
 
     for (int y = 0; y < imageHeight; y++)
     {
         const int index = jmap (y, 0, imageHeight, 0, vectorSize);
-        const float level = jmap (signalFloatArray[index], 0.0f, jmax (maxLevel.getEnd(), signalFloatArray[index] + 0.1f), 0.0f, 1.0f);
-        g.setColour (Colour::fromHSV (level, 1.0f, level, 1.0f));
-        g.drawHorizontalLine (imageHeight - y, rightHandEdge, rightHandEdge + 2);
+        const float level = jmap (frame[index], 0.0f, jmax (maxLevel, frame[index] + 0.1f), 0.0f, 1.0f);
+        const PixelARGB pixelColour = sonogramColours[jlimit (0, 255, roundToInt (level * 255.f))];
+
+        for (int x = 0; x < 2; x++)
+        {
+            uint8* const pixel = pixels.getPixelPointer (x, imageHeight - 1 - y);
+
+            if (pixels.pixelFormat == Image::RGB)
+                reinterpret_cast<PixelRGB*> (pixel)->set (pixelColour);
+            else
+                reinterpret_cast<PixelARGB*> (pixel)->set (pixelColour);
+        }
     }
 }
 
 //====================================================================================
 void CabbageSignalDisplay::drawSpectroscope (Graphics& g)
 {
+    const float* const frame = signalFloatArray.getRawDataPointer();
+    const int offset = isScrollbarShowing == true ? scrollbarHeight : 0;
+    const int height = getHeight() - offset;
+    g.setColour (colour);
+
     for (int i = 0; i < vectorSize; i++)
     {
         const int position = jmap (i, 0, vectorSize, leftPos, scopeWidth);
-        const int offset = isScrollbarShowing == true ? scrollbarHeight : 0;
-        const int height = getHeight() - offset;
-        const int amp = (signalFloatArray[i] * 3 * height);
-        g.setColour (colour);
+        const int amp = (frame[i] * 3 * height);
         g.drawVerticalLine (position, height - amp, height);
     }
 }
@@ -196,20 +212,37 @@ void CabbageSignalDisplay::drawSpectroscope (Graphics& g)
 //====================================================================================
 void CabbageSignalDisplay::drawWaveform (Graphics& g)
 {
+    const float* const frame = signalFloatArray.getRawDataPointer();
     const int offset = isScrollbarShowing == true ? scrollbarHeight : 0;
     const int height = getHeight() - offset;
-    int prevXPos = 0;
-    int prevYPos = jmap (signalFloatArray[0]*-1.f, -1.f, 1.f, 0.f, 1.f) * height;
+    auto getYPos = [height] (float sample) { return jmap (sample * -1.f, -1.f, 1.f, 0.f, 1.f) * height; };
+    Path waveform;
 
-    for (int i = 0; i < vectorSize; i++)
+    if (isMinMaxFrame)
     {
-        const int position = jmap (i, 0, vectorSize, leftPos, scopeWidth);
-        const int amp = jmap (signalFloatArray[i]*-1.f, -1.f, 1.f, 0.f, 1.f) * height;
-        g.setColour (colour);
-        g.drawLine (prevXPos, prevYPos, position, amp, lineThickness);
-        prevXPos = position;
-        prevYPos = amp;
+        //one min/max pair per pixel column
+        for (int i = 0; i < vectorSize; i++)
+        {
+            const float position = jmap (i, 0, vectorSize, leftPos, scopeWidth);
+
+            if (i == 0)
+                waveform.startNewSubPath (position, getYPos (frame[1]));
+            else
+                waveform.lineTo (position, getYPos (frame[i * 2 + 1]));
+
+            waveform.lineTo (position, getYPos (frame[i * 2]));
+        }
     }
+    else
+    {
+        waveform.startNewSubPath (0, getYPos (frame[0]));
+
+        for (int i = 0; i < vectorSize; i++)
+            waveform.lineTo (jmap (i, 0, vectorSize, leftPos, scopeWidth), getYPos (frame[i]));
+    }
+
+    g.setColour (colour);
+    g.strokePath (waveform, PathStrokeType (lineThickness));
 }
 
 //====================================================================================
@@ -302,20 +335,47 @@ void CabbageSignalDisplay::setSignalFloatArraysForLissajous (Array<float, Critic
 //====================================================================================
 void CabbageSignalDisplay::timerCallback()
 {
+    typedef CsoundPluginProcessor::SignalDisplay::Reduction Reduction;
     const String variable = CabbageWidgetData::getStringProp (widgetData, CabbageIdentifierIds::signalvariable);
-    if (owner->shouldUpdateSignalDisplay(variable))
-    {
-        
-        const String signalDisplayType = CabbageWidgetData::getStringProp (widgetData, CabbageIdentifierIds::displaytype);
+    const String signalDisplayType = CabbageWidgetData::getStringProp (widgetData, CabbageIdentifierIds::displaytype);
+
+    //have the processor cut frames down to display resolution before they get here
+    if (signalDisplayType == "lissajous")
+    {
+        signalVariables = CabbageWidgetData::getProperty (widgetData, CabbageIdentifierIds::signalvariable);
+
+        for (int i = 0; i < signalVariables.size(); i++)
+            owner->setSignalDisplayReduction (signalVariables[i], signalDisplayType, Reduction::subsample, getWidth());
+    }
+    else if (shouldDrawSonogram)
+        owner->setSignalDisplayReduction (variable, signalDisplayType, Reduction::peak, spectrogramImage.getHeight());
+    else if (signalDisplayType == "waveform")
+        owner->setSignalDisplayReduction (variable, signalDisplayType, Reduction::minMax, scopeWidth);
+    else
+        owner->setSignalDisplayReduction (variable, signalDisplayType, Reduction::peak, scopeWidth);
+
+    //a lissajous curve needs the newest frame of both its variables
+    bool hasNewFrame = false;
 
+    if (signalDisplayType == "lissajous")
+    {
+        for (int i = 0; i < signalVariables.size(); i++)
+            hasNewFrame = owner->shouldUpdateSignalDisplay (signalVariables[i]) || hasNewFrame;
+    }
+    else
+        hasNewFrame = owner->shouldUpdateSignalDisplay (variable);
+
+    if (hasNewFrame)
+    {
         if (signalDisplayType != "lissajous")
         {
-            setSignalFloatArray (owner->getArrayForSignalDisplay (variable, signalDisplayType));
+            Reduction reduction = Reduction::none;
+            const Array<float, CriticalSection> points = owner->getArrayForSignalDisplay (variable, signalDisplayType, &reduction);
+            isMinMaxFrame = reduction == Reduction::minMax;
+            setSignalFloatArray (points);
         }
         else
         {
-            signalVariables = CabbageWidgetData::getProperty (widgetData, CabbageIdentifierIds::signalvariable);
-
             if (signalVariables.size() == 2)
                 setSignalFloatArraysForLissajous (owner->getArrayForSignalDisplay (signalVariables[0], signalDisplayType),
                                                   owner->getArrayForSignalDisplay (signalVariables[1], signalDisplayType));
@@ -44,6 +44,8 @@ class CabbageSignalDisplay : public Component, public ValueTree::Listener, publi
     bool isScrollbarShowing;
     float rotate;
     bool shouldPaint {false};
+    bool isMinMaxFrame {false};
+    PixelARGB sonogramColours[256];
     int updateRate {200};
 
     Image spectrogramImage, spectroscopeImage;
@@ -32,6 +32,132 @@ constexpr unsigned long long int HashStringToInt (const char* str, unsigned long
 }
 //===============================================================================
 void CabbageWidgetData::setWidgetState (ValueTree widgetData, String lineFromCsd, int ID)
+{
+    setWidgetState (widgetData, lineFromCsd, ID, ScanMode::allWidgets);
+}
+
+bool CabbageWidgetData::setWidgetState (ValueTree widgetData, String lineFromCsd, int ID, ScanMode mode)
+{
+    const String typeToken = getWidgetTypeFromLine (lineFromCsd);
+
+    if (mode == ScanMode::formOnly && typeToken.trim() != CabbageWidgetTypes::form)
+        return false;
+
+    applyWidgetDefaults (widgetData, typeToken, ID);
+
+    //parse the text now that all default values ahve been assigned
+    setCustomWidgetState (widgetData, lineFromCsd, "");
+    return true;
+}
+
+//===============================================================================
+//the first token StringArray::addTokens (line, " ", "\"") would give, without tokenising the rest of the line
+String CabbageWidgetData::getWidgetTypeFromLine (const String& lineFromCsd)
+{
+    auto start = lineFromCsd.getCharPointer();
+    auto end = start;
+    bool inQuotes = false;
+
+    while (! end.isEmpty())
+    {
+        const juce_wchar c = *end;
+
+        if (c == '"')
+            inQuotes = ! inQuotes;
+        else if (c == ' ' && ! inQuotes)
+            break;
+
+        ++end;
+    }
+
+    return String (start, end);
+}
+
+//===============================================================================
+//a widget's defaults only depend on its type, and on its ID through the default name, so
+//they are built once per type and copied into each new widget from then on
+void CabbageWidgetData::applyWidgetDefaults (ValueTree widgetData, const String& typeToken, int ID)
+{
+    struct WidgetTemplate
+    {
+        ValueTree defaults { "defaults" };
+        Array<Identifier> propertiesUsingID;
+    };
+
+    struct TemplateCache
+    {
+        CriticalSection lock;
+        OwnedArray<WidgetTemplate> templates;
+        HashMap<String, WidgetTemplate*> templatesByType;
+    };
+
+    static TemplateCache cache;
+    const String typeOfWidget = typeToken.trim();
+    WidgetTemplate* widgetTemplate = nullptr;
+
+    {
+        const ScopedLock sl (cache.lock);
+
+        if (cache.templatesByType.contains (typeOfWidget))
+            widgetTemplate = cache.templatesByType[typeOfWidget];
+        else
+        {
+            std::unique_ptr<WidgetTemplate> newTemplate (new WidgetTemplate());
+
+            //anything that isn't a known widget type is set up from scratch each time
+            if (! setWidgetDefaults (newTemplate->defaults, typeToken, 0))
+            {
+                setWidgetDefaults (widgetData, typeToken, ID);
+                return;
+            }
+
+            ValueTree withOtherID ("defaults");
+            setWidgetDefaults (withOtherID, typeToken, 1);
+
+            //the default name and line number are the only things the ID changes
+            for (int i = 0; i < withOtherID.getNumProperties(); i++)
+            {
+                const Identifier name = withOtherID.getPropertyName (i);
+
+                if (withOtherID.getProperty (name) != newTemplate->defaults.getProperty (name))
+                    newTemplate->propertiesUsingID.add (name);
+            }
+
+            widgetTemplate = cache.templates.add (newTemplate.release());
+            cache.templatesByType.set (typeOfWidget, widgetTemplate);
+        }
+    }
+
+    const ValueTree& defaults = widgetTemplate->defaults;
+
+   #if JUCE_DEBUG
+    //widgets edit their arrays in place, none of that should ever reach the shared defaults
+    ValueTree freshDefaults ("defaults");
+    setWidgetDefaults (freshDefaults, typeToken, 0);
+    jassert (defaults.isEquivalentTo (freshDefaults));
+   #endif
+
+    //arrays are cloned, so that each widget gets its own copy of every level of them
+    for (int i = 0; i < defaults.getNumProperties(); i++)
+    {
+        const Identifier name = defaults.getPropertyName (i);
+        setProperty (widgetData, name, defaults.getProperty (name).clone());
+    }
+
+    for (const auto& name : widgetTemplate->propertiesUsingID)
+    {
+        const var value = defaults.getProperty (name);
+
+        if (value.isString())
+            setProperty (widgetData, name, value.toString().dropLastCharacters (1) + String (ID));
+        else
+            setProperty (widgetData, name, ID);
+    }
+}
+
+//===============================================================================
+//sets the default properties for a type of widget. Returns false if typeToken isn't a known widget type
+bool CabbageWidgetData::setWidgetDefaults (ValueTree widgetData, const String& typeToken, int ID)
 {
     setProperty (widgetData, "scalex", 1);
     setProperty (widgetData, "scaley", 1);
@@ -67,204 +193,170 @@ void CabbageWidgetData::setWidgetState (ValueTree widgetData, String lineFromCsd
     setProperty(widgetData, CabbageIdentifierIds::filmStripRemoveFrom2, 0);
     setProperty(widgetData, CabbageIdentifierIds::opcodedir, "");
 
-    StringArray strTokens;
-    strTokens.addTokens (lineFromCsd, " ", "\"");
-
-    if(strTokens.size()>0)
-        setProperty (widgetData, CabbageIdentifierIds::type, strTokens[0].trim());
+    setProperty (widgetData, CabbageIdentifierIds::type, typeToken.trim());
 
     setProperty (widgetData, CabbageIdentifierIds::widgetarray, "");
 
-    if (strTokens[0].trim() == String(CabbageWidgetTypes::hslider))
-        setHSliderProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::vslider))
-        setVSliderProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::rslider))
-        setRSliderProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::json))
-        setJSONProperties (widgetData, ID);
-    
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::groupbox))
-        setGroupBoxProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::csoundoutput))
-        setCsoundOutputProperties (widgetData, ID);
+    //duplicate case labels don't compile, so the hash is collision free over the known widget types.
+    //Any other string can still share a known type's hash, so a case only applies if the name matches too
+    const String type = typeToken.trim();
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::keyboard) || 
-		strTokens[0].trim() == String(CabbageWidgetTypes::keyboarddisplay))
-        setKeyboardProperties (widgetData, ID, (strTokens[0].trim() == "keyboard" ? false : true));
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::form))
-        setFormProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::textbox))
-        setTextBoxProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::checkbox))
-        setCheckBoxProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::nslider))
-        setNumberSliderProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::combobox))
-        setComboBoxProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::label))
-        setLabelProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::listbox))
-        setListBoxProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::texteditor))
-        setTextEditorProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::image))
-        setImageProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::encoder))
-        setEncoderProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::hmeter))
-        setMeterProperties (widgetData, ID, false);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::vmeter))
-        setMeterProperties (widgetData, ID, true);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::button))
-        setButtonProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::soundfiler))
-        setSoundfilerProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::filebutton))
-        setFileButtonProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::infobutton))
-        setInfoButtonProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::line))
-        setLineProperties (widgetData, ID);
-    
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::cvoutput) || strTokens[0].trim() == String(CabbageWidgetTypes::cvinput))
-        setPortProperties (widgetData, ID, strTokens[0].trim());
-    
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::screw))
-        setScrewProperties (widgetData, ID);
-
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::light))
-        setLightProperties (widgetData, ID);
+    switch (HashStringToInt (type.toRawUTF8()))
+    {
+        case HashStringToInt ("hslider"):           if (type == "hslider") { setHSliderProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("vslider"):           if (type == "vslider") { setVSliderProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("rslider"):           if (type == "rslider") { setRSliderProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("json"):              if (type == "json") { setJSONProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("groupbox"):          if (type == "groupbox") { setGroupBoxProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("csoundoutput"):      if (type == "csoundoutput") { setCsoundOutputProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("keyboard"):          if (type == "keyboard") { setKeyboardProperties (widgetData, ID, false); return true; } break;
+        case HashStringToInt ("keyboarddisplay"):   if (type == "keyboarddisplay") { setKeyboardProperties (widgetData, ID, true); return true; } break;
+        case HashStringToInt ("form"):              if (type == "form") { setFormProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("textbox"):           if (type == "textbox") { setTextBoxProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("checkbox"):          if (type == "checkbox") { setCheckBoxProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("nslider"):           if (type == "nslider") { setNumberSliderProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("combobox"):          if (type == "combobox") { setComboBoxProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("label"):             if (type == "label") { setLabelProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("listbox"):           if (type == "listbox") { setListBoxProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("texteditor"):        if (type == "texteditor") { setTextEditorProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("image"):             if (type == "image") { setImageProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("encoder"):           if (type == "encoder") { setEncoderProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("hmeter"):            if (type == "hmeter") { setMeterProperties (widgetData, ID, false); return true; } break;
+        case HashStringToInt ("vmeter"):            if (type == "vmeter") { setMeterProperties (widgetData, ID, true); return true; } break;
+        case HashStringToInt ("button"):            if (type == "button") { setButtonProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("soundfiler"):        if (type == "soundfiler") { setSoundfilerProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("filebutton"):        if (type == "filebutton") { setFileButtonProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("infobutton"):        if (type == "infobutton") { setInfoButtonProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("line"):              if (type == "line") { setLineProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("cvoutput"):          if (type == "cvoutput") { setPortProperties (widgetData, ID, CabbageWidgetTypes::cvoutput); return true; } break;
+        case HashStringToInt ("cvinput"):           if (type == "cvinput") { setPortProperties (widgetData, ID, CabbageWidgetTypes::cvinput); return true; } break;
+        case HashStringToInt ("screw"):             if (type == "screw") { setScrewProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("light"):             if (type == "light") { setLightProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("sourcebutton"):
+        case HashStringToInt ("loadbutton"):        if (type == "sourcebutton" || type == "loadbutton") { setLoadButtonProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("signaldisplay"):
+        case HashStringToInt ("fftdisplay"):        if (type == "signaldisplay" || type == "fftdisplay") { setSignalDisplayProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("xypad"):             if (type == "xypad") { setXYPadProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("gentable"):          if (type == "gentable") { setGenTableProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("hrange"):            if (type == "hrange") { setHRangeSliderProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("vrange"):            if (type == "vrange") { setVRangeSliderProperties (widgetData, ID); return true; } break;
+        case HashStringToInt ("eventsequencer"):    if (type == "eventsequencer") { setEventSequencerProperties (widgetData, ID); return true; } break;
+
+        //===============table==================//
+        case HashStringToInt ("table"):
+        {
+            if (type != "table")
+                break;
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::sourcebutton) || strTokens[0].trim() == String(CabbageWidgetTypes::loadbutton))
-        setLoadButtonProperties (widgetData, ID);
+            setProperty (widgetData, "basetype", "layout");
+            var tableColours;
+            tableColours.append ("white");
+            tableColours.append ("cornflowerblue");
+            tableColours.append ("yellow");
+            tableColours.append ("lime");
+            tableColours.append ("green");
+            tableColours.append ("pink");
+
+            setProperty (widgetData, CabbageIdentifierIds::top, 10);
+            setProperty (widgetData, CabbageIdentifierIds::left, 10);
+            setProperty (widgetData, CabbageIdentifierIds::width, 400);
+            setProperty (widgetData, CabbageIdentifierIds::height, 200);
+            setProperty (widgetData, CabbageIdentifierIds::tablenumber, 1);
+            setProperty (widgetData, CabbageIdentifierIds::drawmode, "");
+            setProperty (widgetData, CabbageIdentifierIds::resizemode, 0);
+            setProperty (widgetData, CabbageIdentifierIds::readonly, 0);
+            setProperty (widgetData, CabbageIdentifierIds::tablecolour, tableColours);
+            setProperty (widgetData, CabbageIdentifierIds::amprange, 0);
+            setProperty (widgetData, CabbageIdentifierIds::type, "table");
+            setProperty (widgetData, CabbageIdentifierIds::stack, 0);
+            setProperty (widgetData, CabbageIdentifierIds::name, getProperty (widgetData, "name").toString() + String (ID));
+            setProperty (widgetData, CabbageIdentifierIds::identchannel, "");
+            setProperty (widgetData, CabbageIdentifierIds::visible, 1);
+            return true;
+        }
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::signaldisplay) || strTokens[0].trim() == String(CabbageWidgetTypes::fftdisplay))
-        setSignalDisplayProperties (widgetData, ID);
+        //===============stepper example==================//
+        case HashStringToInt ("stepper"):
+        {
+            if (type != "stepper")
+                break;
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::xypad))
-        setXYPadProperties (widgetData, ID);
+            setProperty (widgetData, "basetype", "layout");
+            setProperty (widgetData, CabbageIdentifierIds::top, 10);
+            setProperty (widgetData, CabbageIdentifierIds::left, 10);
+            setProperty (widgetData, CabbageIdentifierIds::width, 160);
+            setProperty (widgetData, CabbageIdentifierIds::height, 2);
+            setProperty (widgetData, CabbageIdentifierIds::colour, Colours::white.toString());
+            setProperty (widgetData, CabbageIdentifierIds::type, "stepper");
+            setProperty (widgetData, CabbageIdentifierIds::name, "stepper");
+            setProperty (widgetData, CabbageIdentifierIds::name, getProperty (widgetData, "name").toString() + String (ID));
+            setProperty (widgetData, CabbageIdentifierIds::identchannel, "");
+            setProperty (widgetData, CabbageIdentifierIds::visible, 1);
+            return true;
+        }
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::gentable))
-        setGenTableProperties (widgetData, ID);
+        //===============non-GUI host widgets==================//
+        case HashStringToInt ("hostbpm"):
+        {
+            if (type != "hostbpm")
+                break;
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::hrange))
-        setHRangeSliderProperties (widgetData, ID);
+            setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
+            setProperty (widgetData, CabbageIdentifierIds::name, "hostbpm");
+            setProperty (widgetData, CabbageIdentifierIds::type, "hostbpm");
+            return true;
+        }
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::vrange))
-        setVRangeSliderProperties (widgetData, ID);
+        case HashStringToInt ("hostppqpos"):
+        {
+            if (type != "hostppqpos")
+                break;
 
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::eventsequencer))
-        setEventSequencerProperties (widgetData, ID);
+            setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
+            setProperty (widgetData, CabbageIdentifierIds::name, "hostppqpos");
+            setProperty (widgetData, CabbageIdentifierIds::type, "hostppqpos");
+            return true;
+        }
 
-    //===============table==================//
-    else if (strTokens[0].trim() == String(CabbageWidgetTypes::table))
-    {
-        setProperty (widgetData, "basetype", "layout");
-        var tableColours;
-        tableColours.append ("white");
-        tableColours.append ("cornflowerblue");
-        tableColours.append ("yellow");
-        tableColours.append ("lime");
-        tableColours.append ("green");
-        tableColours.append ("pink");
-
-        setProperty (widgetData, CabbageIdentifierIds::top, 10);
-        setProperty (widgetData, CabbageIdentifierIds::left, 10);
-        setProperty (widgetData, CabbageIdentifierIds::width, 400);
-        setProperty (widgetData, CabbageIdentifierIds::height, 200);
-        setProperty (widgetData, CabbageIdentifierIds::tablenumber, 1);
-        setProperty (widgetData, CabbageIdentifierIds::drawmode, "");
-        setProperty (widgetData, CabbageIdentifierIds::resizemode, 0);
-        setProperty (widgetData, CabbageIdentifierIds::readonly, 0);
-        setProperty (widgetData, CabbageIdentifierIds::tablecolour, tableColours);
-        setProperty (widgetData, CabbageIdentifierIds::amprange, 0);
-        setProperty (widgetData, CabbageIdentifierIds::type, "table");
-        setProperty (widgetData, CabbageIdentifierIds::stack, 0);
-        setProperty (widgetData, CabbageIdentifierIds::name, getProperty (widgetData, "name").toString() + String (ID));
-        setProperty (widgetData, CabbageIdentifierIds::identchannel, "");
-        setProperty (widgetData, CabbageIdentifierIds::visible, 1);
-    }
+        case HashStringToInt ("hostplaying"):
+        {
+            if (type != "hostplaying")
+                break;
 
-    //===============stepper example==================//
-    else if (strTokens[0].trim() == "stepper")
-    {
-        setProperty (widgetData, "basetype", "layout");
-        setProperty (widgetData, CabbageIdentifierIds::top, 10);
-        setProperty (widgetData, CabbageIdentifierIds::left, 10);
-        setProperty (widgetData, CabbageIdentifierIds::width, 160);
-        setProperty (widgetData, CabbageIdentifierIds::height, 2);
-        setProperty (widgetData, CabbageIdentifierIds::colour, Colours::white.toString());
-        setProperty (widgetData, CabbageIdentifierIds::type, "stepper");
-        setProperty (widgetData, CabbageIdentifierIds::name, "stepper");
-        setProperty (widgetData, CabbageIdentifierIds::name, getProperty (widgetData, "name").toString() + String (ID));
-        setProperty (widgetData, CabbageIdentifierIds::identchannel, "");
-        setProperty (widgetData, CabbageIdentifierIds::visible, 1);
-    }
+            setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
+            setProperty (widgetData, CabbageIdentifierIds::name, "hostplaying");
+            setProperty (widgetData, CabbageIdentifierIds::type, "hostplaying");
+            return true;
+        }
 
-    //===============non-GUI host widgets==================//
-    else if (strTokens[0].trim() == "hostbpm")
-    {
-        setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
-        setProperty (widgetData, CabbageIdentifierIds::name, "hostbpm");
-        setProperty (widgetData, CabbageIdentifierIds::type, "hostbpm");
-    }
+        case HashStringToInt ("hostrecording"):
+        {
+            if (type != "hostrecording")
+                break;
 
-    else if (strTokens[0].trim() == "hostppqpos")
-    {
-        setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
-        setProperty (widgetData, CabbageIdentifierIds::name, "hostppqpos");
-        setProperty (widgetData, CabbageIdentifierIds::type, "hostppqpos");
-    }
+            setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
+            setProperty (widgetData, CabbageIdentifierIds::name, "hostrecording");
+            setProperty (widgetData, CabbageIdentifierIds::type, "hostrecording");
+            return true;
+        }
 
-    else if (strTokens[0].trim() == "hostplaying")
-    {
-        setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
-        setProperty (widgetData, CabbageIdentifierIds::name, "hostplaying");
-        setProperty (widgetData, CabbageIdentifierIds::type, "hostplaying");
-    }
+        case HashStringToInt ("hosttime"):
+        {
+            if (type != "hosttime")
+                break;
 
-    else if (strTokens[0].trim() == "hostrecording")
-    {
-        setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
-        setProperty (widgetData, CabbageIdentifierIds::name, "hostrecording");
-        setProperty (widgetData, CabbageIdentifierIds::type, "hostrecording");
-    }
+            setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
+            setProperty (widgetData, CabbageIdentifierIds::name, "hosttime");
+            setProperty (widgetData, CabbageIdentifierIds::type, "hosttime");
+            return true;
+        }
 
-    else if (strTokens[0].trim() == "hosttime")
-    {
-        setProperty (widgetData, CabbageIdentifierIds::basetype, "layout");
-        setProperty (widgetData, CabbageIdentifierIds::name, "hosttime");
-        setProperty (widgetData, CabbageIdentifierIds::type, "hosttime");
-    }
-    else
-    {
-        setProperty (widgetData, CabbageIdentifierIds::type, strTokens[0]);
+        default:
+            break;
     }
 
-    //parse the text now that all default values ahve been assigned
-    setCustomWidgetState (widgetData, lineFromCsd, "");
+    setProperty (widgetData, CabbageIdentifierIds::type, typeToken);
+    return false;
 }
 
 //===========================================================================================
@@ -294,9 +386,6 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
 
     IdentifiersAndParameters identifierValueSet = getSetofIdentifiersAndParameters (lineOfText);
 
-    CabbageIdentifierStrings identifierArray;
-
-
     for ( int indx = 0 ; indx < identifierValueSet.identifier.size() ; indx++)
     {
         //CabbageUtilities::debug(identifierValueSet.identifier[indx]);
@@ -399,6 +488,7 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
             case HashStringToInt ("active"):
             case HashStringToInt ("automation"):
             case HashStringToInt ("automatable"):
+            case HashStringToInt ("automationramp"):
             case HashStringToInt ("alpha"):
             case HashStringToInt ("corners"):
             case HashStringToInt ("ffttablenumber"):
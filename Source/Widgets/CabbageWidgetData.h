@@ -43,7 +43,14 @@ public:
     CabbageWidgetData() {};
     ~CabbageWidgetData() {};
     //============================================================================
+    enum class ScanMode { allWidgets, formOnly };
+
     static void setWidgetState (ValueTree widgetData, String lineFromCsd, int ID);
+    //formOnly skips, and returns false for, anything that isn't a form() line
+    static bool setWidgetState (ValueTree widgetData, String lineFromCsd, int ID, ScanMode mode);
+    static String getWidgetTypeFromLine (const String& lineFromCsd);
+    static void applyWidgetDefaults (ValueTree widgetData, const String& typeToken, int ID);
+    static bool setWidgetDefaults (ValueTree widgetData, const String& typeToken, int ID);
     static void setCustomWidgetState (ValueTree widgetData, String lineFromCsd, String identifier = String());
     //============================================================================
     // these methods are implemented in CabbageWidgetDataInitMethods.h
@@ -134,23 +134,6 @@ void CabbageXYPad::mouseUp (const MouseEvent& e)
     }
 }
 
-void CabbageXYPad::changeListenerCallback (ChangeBroadcaster* source)
-{
-    if (XYPadAutomator* xyAuto = dynamic_cast<XYPadAutomator*> (source))
-    {
-        juce::Point<float> pos (getValueAsPosition (juce::Point<float> (xyAuto->getPosition().getX(), xyAuto->getPosition().getY())));
-        pos.addXY (-ball.getWidth() / 2, -ball.getWidth() / 2);
-        ball.setBounds (pos.getX(), pos.getY(), 20, 20);
-
-        setValues (xyAuto->getPosition().getX(), xyAuto->getPosition().getY());
-
-        if (xyAuto->getShouldRepaintBackground() == true)
-        {
-            repaint();
-            xyAuto->setRepaintBackground (false);
-        }
-    }
-}
 //==================================================================
 void CabbageXYPad::valueTreePropertyChanged (ValueTree& valueTree, const Identifier& prop)
 {
@@ -171,12 +154,15 @@ void CabbageXYPad::valueTreePropertyChanged (ValueTree& valueTree, const Identif
     else
     {
         //need to add a flag to xypad to disable dragging if users want to set values manually
+        //this is also how the ball follows the processor's automation, so only the display is updated
         const float xPos = CabbageWidgetData::getNumProp (valueTree, CabbageIdentifierIds::valuex);
         const float yPos = CabbageWidgetData::getNumProp (valueTree, CabbageIdentifierIds::valuey);
         //setValues(xPos, maxY - yPos);
         juce::Point<float> pos (getValueAsPosition (juce::Point<float> (xPos, maxY - yPos)));
         //pos.addXY(-ball.getWidth() / 2, -ball.getWidth() / 2);
         ball.setTopLeftPosition (constrainPosition (pos.getX(), pos.getY()));
+        xValueLabel.setText (createValueText (xPos, 3, xPrefix, xPostfix), dontSendNotification);
+        yValueLabel.setText (createValueText (yPos, 3, yPrefix, yPostfix), dontSendNotification);
         repaint();
     }
 }
@@ -294,48 +280,3 @@ void CabbageXYPad::setValues (float x, float y, bool notify)
     xValueLabel.setText (createValueText(x, 3, xPrefix, xPostfix), dontSendNotification);
     yValueLabel.setText (createValueText(minY + (maxY - y), 3, yPrefix, yPostfix), dontSendNotification);
 }
-//========================================================================
-XYPadAutomator::XYPadAutomator (String name, CabbagePluginParameter* xParam, CabbagePluginParameter* yParam, AudioProcessor* _owner)
-    : name (name), xParam (xParam), yParam (yParam), owner (_owner)
-{}
-
-
-void XYPadAutomator::timerCallback()
-{
-    xValue += xValueIncrement;
-    position.setX (xValue);
-
-    yValue += yValueIncrement;
-    position.setY (yValue);
-
-    // If a border is hit then the increment value should be reversed...
-    if (xValue <= xMin)
-    {
-        xValue = xMin;
-        xValueIncrement *= -1;
-    }
-    else if (xValue >= xMax)
-    {
-        xValue = xMax;
-        xValueIncrement *= -1;
-    }
-
-    if (yValue <= yMin)
-    {
-        yValue = yMin;
-        yValueIncrement *= -1;
-    }
-    else if (yValue >= yMax)
-    {
-        yValue = yMax;
-        yValueIncrement *= -1;
-    }
-
-    if (isPluginEditorOpen && xParam!=nullptr && yParam!=nullptr) //only update GUI is editor is open
-        sendSynchronousChangeMessage();
-    else
-    {
-        xParam->setValue (xValue);
-        yParam->setValue (yValue);
-    }
-}
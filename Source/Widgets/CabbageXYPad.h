@@ -28,7 +28,6 @@
 #include "CabbageWidgetBase.h"
 
 class CabbagePluginEditor;
-class CabbagePluginParameter;
 class AudioProccessor;
 
 // Add any new custom widgets here to avoid having to edit makefiles and projects
@@ -36,8 +35,7 @@ class AudioProccessor;
 class CabbageXYPad
     : public Component,
       public ValueTree::Listener,
-      public CabbageWidgetBase,
-      public ChangeListener
+      public CabbageWidgetBase
 {
     CabbagePluginEditor* owner;
     Colour fontColour, textColour, colour, bgColour, ballColour;
@@ -90,7 +88,6 @@ public:
     void valueTreeChildOrderChanged (ValueTree&, int, int) override {}
     void valueTreeParentChanged (ValueTree&) override {};
 
-    void changeListenerCallback (ChangeBroadcaster* source) override;
     ValueTree widgetData;
 
     void paint (Graphics& g) override;
@@ -122,109 +119,4 @@ public:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CabbageXYPad);
 };
 
-//=============================================================================
-class XYPadAutomator : public ChangeBroadcaster, public Timer
-{
-    String name;
-    CabbagePluginParameter* xParam, *yParam;
-    float xValue = 0;
-    float yValue = 0;
-    float xValueIncrement = 1;
-    float yValueIncrement = 1;
-    Line<float> dragLine;
-    bool isPluginEditorOpen = false;
-    bool repaintBackground = false;
-    juce::Point<double> position;
-    float xMin, xMax, yMin, yMax, velocity;
-    AudioProcessor* owner;
-
-public:
-    XYPadAutomator (String name, CabbagePluginParameter* xParam, CabbagePluginParameter* yParam, AudioProcessor* _owner);
-
-    ~XYPadAutomator()
-    {
-        stopTimer();
-        removeAllChangeListeners();
-    }
-
-    void timerCallback() override;
-    String getName()
-    {
-        return name;
-    }
-    void setDragLine (const Line<float>& newDragLine)
-    {
-        this->dragLine = newDragLine;
-    }
-    void setIsPluginEditorOpen (bool isEditorOpen)
-    {
-        this->isPluginEditorOpen = isEditorOpen;
-    }
-    void setName (const String& newName)
-    {
-        this->name = newName;
-    }
-    void setPosition (const juce::Point<double>& newPosition)
-    {
-        this->position = newPosition;
-    }
-    void setRepaintBackground (bool paintBackground)
-    {
-        this->repaintBackground = paintBackground;
-    }
-    void setVelocity (float newVelocity)
-    {
-        this->velocity = newVelocity;
-    }
-    void setXMax (float newXMax)
-    {
-        this->xMax = newXMax;
-    }
-    void setXMin (float newXMin)
-    {
-        this->xMin = newXMin;
-    }
-    void setXValue (float newXValue)
-    {
-        this->xValue = newXValue;
-    }
-    void setXValueIncrement (float newXValueIncrement)
-    {
-        this->xValueIncrement = newXValueIncrement;
-    }
-    void setYMax (float newYMax)
-    {
-        this->yMax = newYMax;
-    }
-    void setYMin (float newYMin)
-    {
-        this->yMin = newYMin;
-    }
-    void setYValue (float newYValue)
-    {
-        this->yValue = newYValue;
-    }
-    void setYValueIncrement (float newYValueIncrement)
-    {
-        this->yValueIncrement = newYValueIncrement;
-    }
-    bool getIsPluginEditorOpen() const
-    {
-        return isPluginEditorOpen;
-    }
-    const juce::Point<double>& getPosition() const
-    {
-        return position;
-    }
-    bool getShouldRepaintBackground() const
-    {
-        return repaintBackground;
-    }
-    float getXValueIncrement() const
-    {
-        return xValueIncrement;
-    }
-
-};
-
 #endif  // CABBAGEXYPAD_H_INCLUDED
@@ -0,0 +1,66 @@
+/*
+  Copyright (C) 2019 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef SHAREDTHUMBNAILCACHE_H_INCLUDED
+#define SHAREDTHUMBNAILCACHE_H_INCLUDED
+
+#include "../../CabbageCommonHeaders.h"
+
+//=================================================================
+// one thumbnail cache for every soundfiler and GEN01 table in the
+// process. Files are read on the cache's own thread, and a file
+// already shown somewhere else, with the same modification time,
+// isn't read again. Hold it through a SharedResourcePointer
+//=================================================================
+class SharedThumbnailCache
+{
+public:
+    SharedThumbnailCache() : cache (maxNumThumbnails)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    AudioThumbnail* createThumbnail()
+    {
+        return new AudioThumbnail (samplesPerThumbnailSample, formatManager, cache);
+    }
+
+    //points the thumbnail at the file, which is then loaded in the background.
+    //Returns the file's sample rate, or 0 if it can't be read
+    double setSource (AudioThumbnail& thumbnail, const File& file)
+    {
+        std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+        if (reader == nullptr)
+            return 0;
+
+        //the modification time goes into the hash, so a file that has been rewritten isn't drawn from the cache
+        thumbnail.setSource (new FileInputSource (file, true));
+        return reader->sampleRate;
+    }
+
+private:
+    enum { maxNumThumbnails = 32, samplesPerThumbnailSample = 2 };
+    AudioFormatManager formatManager;
+    AudioThumbnailCache cache;
+
+    JUCE_DECLARE_NON_COPYABLE (SharedThumbnailCache)
+};
+
+#endif  // SHAREDTHUMBNAILCACHE_H_INCLUDED
@@ -62,7 +62,6 @@ Soundfiler::Soundfiler (int sr, Colour col, Colour bgcol):
     scrubberPosition (0),
     sampleRate (sr),
     regionWidth (1),
-    thumbnailCache (5),
     colour (col),
     bgColour (bgcol),
     mouseDownX (0),
@@ -71,8 +70,7 @@ Soundfiler::Soundfiler (int sr, Colour col, Colour bgcol):
     currentPlayPosition (0),
     drawWaveform (false)
 {
-    formatManager.registerBasicFormats();
-    thumbnail.reset (new AudioThumbnail (2, formatManager, thumbnailCache));
+    thumbnail.reset (thumbnailCache->createThumbnail());
     thumbnail->addChangeListener (this);
     //setSize(400, 200);
     sampleRate = sr;
@@ -131,21 +129,17 @@ void Soundfiler::setFile (const File& file)
 {
     if (! file.isDirectory())
     {
-        AudioFormatManager format;
-        format.registerBasicFormats();
-        //registers wav and aif format (just nescearry one time if you alays use the "getInstance()" method)
-        AudioFormatReader* reader = format.createReaderFor (file);
+        //the thumbnail fills in as the file is read in the background, and repaints as it goes
+        const double fileSampleRate = thumbnailCache->setSource (*thumbnail, file);
 
-        //creates a reader for the result file (may file, if the result/opened file is no wav or aif)
-        if (reader) //if a reader got created
+        if (fileSampleRate > 0)
         {
-            AudioBuffer<float> buffer(reader->numChannels, (int)reader->lengthInSamples);
-            buffer.clear();
-            reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
-            setWaveform (buffer, reader->numChannels);
+            sampleRate = (float) fileSampleRate;
+            const Range<double> newRange (0.0, thumbnail->getTotalLength());
+            scrollbar->setRangeLimits (newRange);
+            setRange (newRange);
+            setZoomFactor (zoom);
         }
-
-        delete reader;
     }
 
     repaint (0, 0, getWidth(), getHeight());
@@ -156,7 +150,7 @@ void Soundfiler::setWaveform (AudioSampleBuffer buffer, int channels)
 {
     thumbnail->clear();
     repaint();
-    thumbnail->reset (channels, 44100, buffer.getNumSamples());
+    thumbnail->reset (channels, sampleRate, buffer.getNumSamples());
     //thumbnail->clear();
     thumbnail->addBlock (0, buffer, 0, buffer.getNumSamples());
     const Range<double> newRange (0.0, thumbnail->getTotalLength());
@@ -21,6 +21,7 @@
 #define SOUNDFILEWAVEFORM_H
 
 #include "../../CabbageCommonHeaders.h"
+#include "SharedThumbnailCache.h"
 
 class ZoomButton;
 //=================================================================
@@ -113,11 +114,10 @@ private:
     void changeListenerCallback (ChangeBroadcaster* source) override;
     std::unique_ptr<ZoomButton> zoomIn, zoomOut;
 
-    AudioFormatManager formatManager;
     float sampleRate;
     float regionWidth;
     Image waveformImage;
-    AudioThumbnailCache thumbnailCache;
+    SharedResourcePointer<SharedThumbnailCache> thumbnailCache;
     std::unique_ptr<AudioThumbnail> thumbnail;
     Colour colour, bgColour;
     int mouseDownX, mouseUpX;
@@ -514,6 +514,16 @@ void TableManager::setWaveform (Array<float, CriticalSection> buffer, int ftNumb
         }
 }
 //==============================================================================
+void TableManager::updateWaveform (const Array<float, CriticalSection>& values, Range<int> changedRange, int ftNumber)
+{
+    for ( int i = 0; i < tables.size(); i++)
+        if (ftNumber == tables[i]->tableNumber)
+        {
+            tables[i]->updateWaveform (values, changedRange);
+            return;
+        }
+}
+//==============================================================================
 void TableManager::enableEditMode (StringArray pFields, int ftNumber)
 {
     for ( int i = 0; i < tables.size(); i++)
@@ -548,6 +558,102 @@ void TableManager::bringTableToFront (int ftNumber)
     bringButtonsToFront();
 }
 
+//==============================================================================
+// TableMinMaxPyramid
+//==============================================================================
+void TableMinMaxPyramid::update (const float* data, int numPoints, Range<int> changedRange)
+{
+    if (numPoints != numSourcePoints)
+    {
+        levels.clear();
+        numSourcePoints = numPoints;
+
+        for (int blockSize = blockFactor; blockSize < numPoints; blockSize *= blockFactor)
+        {
+            Level level;
+            level.blockSize = blockSize;
+            level.blocks.resize ((numPoints + blockSize - 1) / blockSize);
+            levels.add (level);
+        }
+
+        changedRange = Range<int> (0, numPoints);
+    }
+
+    changedRange = changedRange.getIntersectionWith (Range<int> (0, numPoints));
+
+    if (changedRange.isEmpty())
+        return;
+
+    for (int l = 0; l < levels.size(); l++)
+    {
+        Level& level = levels.getReference (l);
+        const int firstBlock = changedRange.getStart() / level.blockSize;
+        const int lastBlock = (changedRange.getEnd() - 1) / level.blockSize;
+
+        for (int block = firstBlock; block <= lastBlock; block++)
+        {
+            Range<float> blockRange;
+
+            //each level is built from blockFactor entries of the one below it
+            if (l == 0)
+            {
+                const int start = block * level.blockSize;
+                blockRange = FloatVectorOperations::findMinAndMax (data + start, jmin (level.blockSize, numPoints - start));
+            }
+            else
+            {
+                const Array<Range<float>>& below = levels.getReference (l - 1).blocks;
+                const int start = block * blockFactor;
+                const int end = jmin (start + blockFactor, below.size());
+                blockRange = below.getReference (start);
+
+                for (int i = start + 1; i < end; i++)
+                    blockRange = blockRange.getUnionWith (below.getReference (i));
+            }
+
+            level.blocks.setUnchecked (block, blockRange);
+        }
+    }
+}
+
+Range<float> TableMinMaxPyramid::getMinMax (const float* data, int start, int end) const
+{
+    start = jlimit (0, numSourcePoints, start);
+    end = jlimit (start, numSourcePoints, end);
+
+    if (start == end)
+        return Range<float> (data[jmin (start, numSourcePoints - 1)], data[jmin (start, numSourcePoints - 1)]);
+
+    float low = data[start], high = low;
+
+    for (int i = start; i < end;)
+    {
+        //use the coarsest block that starts here and fits inside the range
+        int l = -1;
+
+        while (l + 1 < levels.size() && i % levels.getReference (l + 1).blockSize == 0
+               && i + levels.getReference (l + 1).blockSize <= end)
+            l++;
+
+        if (l < 0)
+        {
+            low = jmin (low, data[i]);
+            high = jmax (high, data[i]);
+            i++;
+        }
+        else
+        {
+            const Level& level = levels.getReference (l);
+            const Range<float> blockRange = level.blocks.getReference (i / level.blockSize);
+            low = jmin (low, blockRange.getStart());
+            high = jmax (high, blockRange.getEnd());
+            i += level.blockSize;
+        }
+    }
+
+    return Range<float> (low, high);
+}
+
 //==============================================================================
 // GenTable display  component
 //==============================================================================
@@ -570,7 +676,6 @@ GenTable::GenTable():
     currentPositionMarker (new DrawableRectangle()),
     scrubberPosition (0),
     regionWidth (1),
-    thumbnailCache (5),
     mouseDownX (0),
     mouseUpX (0),
     loopLength (0),
@@ -619,8 +724,7 @@ void GenTable::addTable (int sr, const Colour col, int igen, var ampRange)
     //set up table according to type of GEN used to create it
     if (genRoutine == 1)
     {
-        formatManager.registerBasicFormats();
-        thumbnail.reset (new AudioThumbnail (2, formatManager, thumbnailCache));
+        thumbnail.reset (thumbnailCache->createThumbnail());
         thumbnail->addChangeListener (this);
         setZoomFactor (0.0);
     }
@@ -660,6 +764,13 @@ void GenTable::setAmpRanges (var ampRange)
 //==============================================================================
 void GenTable::changeListenerCallback (ChangeBroadcaster* source)
 {
+    //more of a sound file has been read in
+    if (thumbnail != nullptr && source == thumbnail.get())
+    {
+        repaint();
+        return;
+    }
+
     currentHandle = dynamic_cast<HandleComponent*> (source);
 
     if (currentHandle)
@@ -725,24 +836,21 @@ void GenTable::scrollBarMoved (ScrollBar* scrollBarThatHasMoved, double /*newRan
 
 void GenTable::setFile (const File& file)
 {
-    if (file.existsAsFile())
+    if (file.existsAsFile() && thumbnail != nullptr)
     {
         genRoutine = 1;
-        AudioFormatManager format;
-        format.registerBasicFormats();
 
-        AudioFormatReader* reader = format.createReaderFor (file);
+        //the thumbnail fills in as the file is read in the background, and repaints as it goes
+        const double fileSampleRate = thumbnailCache->setSource (*thumbnail, file);
 
-        if (reader) //if a reader got created
+        if (fileSampleRate > 0)
         {
-            AudioSampleBuffer buffer (reader->numChannels, (int)reader->lengthInSamples);
-            buffer.clear();
-            buffer.setSize (reader->numChannels, (int)reader->lengthInSamples);
-            reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
-            setWaveform (buffer);
+            sampleRate = fileSampleRate;
+            tableSize = (int) (thumbnail->getTotalLength() * sampleRate);
+            const Range<double> newRange (0.0, thumbnail->getTotalLength());
+            scrollbar->setRangeLimits (newRange);
+            setRange (newRange);
         }
-
-        delete reader;
     }
 
     repaint (0, 0, getWidth(), getHeight());
@@ -804,7 +912,7 @@ void GenTable::setWaveform (AudioSampleBuffer buffer)
         genRoutine = 1;
         thumbnail->clear();
         repaint();
-        thumbnail->reset (buffer.getNumChannels(), 44100, buffer.getNumSamples());
+        thumbnail->reset (buffer.getNumChannels(), sampleRate, buffer.getNumSamples());
         thumbnail->addBlock (0, buffer, 0, buffer.getNumSamples());
         const Range<double> newRange (0.0, thumbnail->getTotalLength());
         scrollbar->setRangeLimits (newRange);
@@ -818,25 +926,44 @@ void GenTable::setWaveform (Array<float, CriticalSection> buffer, bool updateRan
 {
     if (genRoutine != 1)
     {
-        waveformBuffer.clear();
-        waveformBuffer = buffer;
+        //only the part of the table that has changed since the last update needs summarising again
+        Range<int> changedRange (0, buffer.size());
+
+        if (buffer.size() == waveformBuffer.size())
+        {
+            const float* const newData = buffer.getRawDataPointer();
+            const float* const oldData = waveformBuffer.getRawDataPointer();
+            int start = 0, end = buffer.size();
+
+            while (start < end && newData[start] == oldData[start])
+                start++;
+
+            while (end > start && newData[end - 1] == oldData[end - 1])
+                end--;
+
+            changedRange = Range<int> (start, end);
+        }
+
+        waveformBuffer.swapWith (buffer);
+        waveformPyramid.update (waveformBuffer.getRawDataPointer(), waveformBuffer.size(), changedRange);
 
-        //waveformBuffer.swapWith(buffer);
         tableSize = waveformBuffer.size();
 
         handleViewer->tableSize = tableSize;
 
         if (updateRange == true)
         {
-            const Range<double> newRange (0.0, buffer.size() / sampleRate);
+            const Range<double> newRange (0.0, waveformBuffer.size() / sampleRate);
             scrollbar->setRangeLimits (newRange);
             setRange (newRange);
             setZoomFactor (0);
         }
+        else if (changedRange.isEmpty())
+            return;
 
         if (minMax.getLength() == 0)
         {
-            minMax = findMinMax (buffer);
+            minMax = findMinMax (waveformBuffer);
             handleViewer->minMax = minMax;
         }
 
@@ -847,6 +974,36 @@ void GenTable::setWaveform (Array<float, CriticalSection> buffer, bool updateRan
     }
 
 }
+
+void GenTable::updateWaveform (const Array<float, CriticalSection>& values, Range<int> changedRange)
+{
+    if (genRoutine == 1)
+        return;
+
+    if (values.size() != waveformBuffer.size())
+    {
+        setWaveform (values, false);
+        return;
+    }
+
+    changedRange = changedRange.getIntersectionWith (Range<int> (0, values.size()));
+
+    if (changedRange.isEmpty())
+        return;
+
+    FloatVectorOperations::copy (waveformBuffer.getRawDataPointer() + changedRange.getStart(),
+                                 values.getRawDataPointer() + changedRange.getStart(), changedRange.getLength());
+    waveformPyramid.update (waveformBuffer.getRawDataPointer(), waveformBuffer.size(), changedRange);
+
+    if (minMax.getLength() == 0)
+    {
+        minMax = findMinMax (waveformBuffer);
+        handleViewer->minMax = minMax;
+    }
+
+    repaint();
+}
+
 //==============================================================================
 void GenTable::enableEditMode (StringArray m_pFields)
 {
@@ -1101,7 +1258,7 @@ void GenTable::paint (Graphics& g)
     }
 
     //if gen01 then use an audio thumbnail class
-    if (genRoutine == 1 || waveformBuffer.size() > MAX_TABLE_SIZE)
+    if (genRoutine == 1)
     {
         g.setColour (tableColour);
         thumbnail->drawChannels (g, thumbArea.reduced (2), visibleRange.getStart(), visibleRange.getEnd(), .8f);
@@ -1130,6 +1287,45 @@ void GenTable::paint (Graphics& g)
 
         int gridIndex = ceil (visibleStart);
 
+        //more than one table point per pixel, so draw each pixel column from the min/max pyramid
+        if (incr > 1.f && tableSize > 2 && !(qsteps == 1 && genRoutine == 2))
+        {
+            const float* const data = waveformBuffer.getRawDataPointer();
+            RectangleList<float> fill;
+            Path trace;
+
+            for (int x = 0; x < thumbArea.getWidth(); x++)
+            {
+                const int start = (int) (visibleStart + x * incr);
+                const int end = jmax (start + 1, (int) (visibleStart + (x + 1) * incr));
+
+                if (start >= tableSize)
+                    break;
+
+                const Range<float> columnRange = waveformPyramid.getMinMax (data, start, end);
+                const float top = ampToPixel (thumbHeight, minMax, columnRange.getEnd());
+                const float bottom = ampToPixel (thumbHeight, minMax, columnRange.getStart());
+
+                if (shouldFill)
+                    fill.addWithoutMerging (juce::Rectangle<float>::leftTopRightBottom (x, jmin (top, midPoint), x + 1, jmax (bottom, midPoint)));
+
+                if (x == 0)
+                    trace.startNewSubPath (x, top);
+                else
+                    trace.lineTo (x, top);
+
+                trace.lineTo (x, bottom);
+            }
+
+            g.setColour (tableColour);
+            g.fillRectList (fill);
+
+            if (traceThickness > 0)
+                g.strokePath (trace, PathStrokeType (traceThickness));
+
+            return;
+        }
+
         for (double i = visibleStart; i <= visibleEnd; i += incr)
         {
             //when qsteps == 1 we draw a grid
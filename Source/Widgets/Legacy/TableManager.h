@@ -25,10 +25,36 @@
 
 #include "../../CabbageCommonHeaders.h"
 #include "../../LookAndFeel/CabbageLookAndFeel2.h"
+#include "SharedThumbnailCache.h"
 
 class RoundButton;
 class HandleViewer;
 class HandleComponent;
+
+//=================================================================
+// min/max summary of a table at successively coarser resolutions,
+// so any range of it can be measured without visiting every point
+//=================================================================
+class TableMinMaxPyramid
+{
+public:
+    //rebuilds the summary over the changed range only, or all of it if the table size has changed
+    void update (const float* data, int numPoints, Range<int> changedRange);
+    //exact min/max of data[start..end)
+    Range<float> getMinMax (const float* data, int start, int end) const;
+
+private:
+    enum { blockFactor = 4 };
+
+    struct Level
+    {
+        int blockSize;
+        Array<Range<float>> blocks;
+    };
+
+    Array<Level> levels;
+    int numSourcePoints = 0;
+};
 class GenTable;
 
 class TableManager : public Component,
@@ -76,6 +102,8 @@ public:
     void setWaveform (AudioSampleBuffer buffer, int ftNumber);
     void scrollBarMoved (ScrollBar* scrollBarThatHasMoved, double newRangeStart) override;
     void setWaveform (Array<float, CriticalSection> buffer, int ftNumber, bool updateRange = true);
+    //copies in only the values in changedRange
+    void updateWaveform (const Array<float, CriticalSection>& values, Range<int> changedRange, int ftNumber);
     void setFile (const File file);
     void enableEditMode (StringArray pFields, int ftnumber);
     void toggleEditMode (bool enable);
@@ -140,6 +168,7 @@ public:
     void enableEditMode (StringArray pFields);
     juce::Point<int> tableTopAndHeight;
     void setWaveform (Array<float, CriticalSection> buffer, bool updateRange = true);
+    void updateWaveform (const Array<float, CriticalSection>& values, Range<int> changedRange);
     void createImage (String filename);
     void addTable (int sr, const Colour col, int gen, var ampRange);
     static float ampToPixel (int height, Range<float> minMax, float sampleVal);
@@ -256,11 +285,10 @@ private:
     void scrollBarMoved (ScrollBar* scrollBarThatHasMoved, double newRangeStart) override;
     void changeListenerCallback (ChangeBroadcaster* source) override;
     std::unique_ptr<HandleViewer> handleViewer;
-    AudioFormatManager formatManager;
     double sampleRate = 44100;
     float regionWidth = 0;
     Image waveformImage = {};
-    AudioThumbnailCache thumbnailCache;
+    SharedResourcePointer<SharedThumbnailCache> thumbnailCache;
     std::unique_ptr<AudioThumbnail> thumbnail;
     Colour tableColour, fontcolour;
     int mouseDownX = 0, mouseUpX = 0;
@@ -274,23 +302,13 @@ private:
     const Image drawGridImage (bool redraw, double width = 0.0, double height = 0.0, double offset = 0.0);
 
     Array<float, CriticalSection> waveformBuffer;
+    TableMinMaxPyramid waveformPyramid;
     double visibleLength = 0, visibleStart = 0, visibleEnd = 0, maxAmp = 0;
     Range<float> minMax;
 
-    Range<float> findMinMax (Array<float, CriticalSection> buffer)
+    Range<float> findMinMax (const Array<float, CriticalSection>& buffer)
     {
-        float min = buffer[0], max = buffer[0];
-
-        for (int i = 0; i < buffer.size(); i++)
-        {
-            if (buffer[i] > max)
-                max = buffer[i];
-
-            if (buffer[i] < min)
-                min = buffer[i];
-        }
-
-        return Range<float> (min, max);
+        return FloatVectorOperations::findMinAndMax (buffer.getRawDataPointer(), buffer.size());
     }
 
 };